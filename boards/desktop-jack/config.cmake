@@ -0,0 +1,4 @@
+otto_include_board(parts/audio/jack)
+otto_include_board(parts/ui/glfw)
+otto_include_board(parts/controller/emulator)
+otto_include_board(parts/controller/protto1-serial)
@@ -9,6 +9,7 @@
 #include "services/log_manager.hpp"
 #include "services/preset_manager.hpp"
 #include "services/state_manager.hpp"
+#include "services/thread_policy.hpp"
 #include "services/clock_manager.hpp"
 #include "services/ui_manager.hpp"
 #include "services/controller.hpp"
@@ -42,10 +43,12 @@ int main(int argc, char* argv[])
 
     auto cli = lyra::cli_parser();
     RTAudioAudioManager::current().add_args(cli);
+    ThreadPolicy::current().add_args(cli);
 
     cli.parse({argc, argv});
 
     RTAudioAudioManager::current().log_devices();
+    ThreadPolicy::current().apply();
 
     Settings settings;
 
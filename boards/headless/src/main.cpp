@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <lyra/lyra.hpp>
+
+#include "core/audio/midi.hpp"
+#include "core/ui/nvg/SoftwareCanvas.hpp"
+#include "core/ui/vector_graphics.hpp"
+
+#include "services/audio_manager.hpp"
+#include "services/clock_manager.hpp"
+#include "services/controller.hpp"
+#include "services/engine_manager.hpp"
+#include "services/log_manager.hpp"
+#include "services/preset_manager.hpp"
+#include "services/state_manager.hpp"
+#include "services/thread_policy.hpp"
+#include "services/ui_manager.hpp"
+
+#include "util/exception.hpp"
+#include "util/utility.hpp"
+
+#include "board/audio_driver.hpp"
+
+using namespace otto;
+using namespace otto::services;
+
+int handle_exception(const char* e);
+int handle_exception(std::exception& e);
+int handle_exception();
+
+/// Runs the UI logic thread like a board with a display, and renders its frames to memory
+struct HeadlessUIManager final : UIManager {
+  HeadlessUIManager() = default;
+
+  void main_ui_loop() override
+  {
+    ThreadPolicy::set_role(ThreadPolicy::Role::ui);
+    nvg::SoftwareCanvas sc = {int(core::ui::vg::width), int(core::ui::vg::height)};
+    core::ui::vg::initUtils(sc.canvas());
+    start_logic_thread(60);
+    while (Application::current().running()) {
+      if (has_new_frame()) {
+        render_frame(sc.begin_frame());
+        sc.end_frame();
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1000 / 60));
+    }
+    stop_logic_thread();
+  }
+};
+
+/// Plays input events from a file into the controller's queue, like a hardware controller would
+///
+/// Each line holds the time in seconds since the start, and one of `press <key>`,
+/// `release <key>` or `encoder <blue|green|yellow|red> <steps>`: `1.5 encoder blue -2`.
+/// Lines starting with `#` are ignored. The events are played in real time, also with `--fast`.
+struct ScriptedController final : Controller {
+  ~ScriptedController() noexcept
+  {
+    stop_ = true;
+    if (thread_.joinable()) thread_.join();
+  }
+
+  void set_color(LED, LEDColor) override{};
+  void flush_leds() override {}
+  void clear_leds() override {}
+
+  template<typename Parser>
+  void add_args(Parser& cli)
+  {
+    cli |= lyra::opt(file_, "file")["--input"]("File with timestamped key and encoder events");
+  }
+
+  /// Load the events, and start playing them
+  void open()
+  {
+    if (file_.empty()) return;
+    load();
+    thread_ = std::thread([this] { run(); });
+  }
+
+  static ScriptedController& current()
+  {
+    return dynamic_cast<ScriptedController&>(Controller::current());
+  }
+
+private:
+  struct TimedEvent {
+    chrono::duration time;
+    Event event;
+  };
+
+  void load()
+  {
+    std::ifstream file(file_);
+    if (!file) throw util::exception("Could not open input file '{}'", file_);
+    std::string line;
+    for (int line_no = 1; std::getline(file, line); line_no++) {
+      std::istringstream ss(line);
+      double seconds;
+      // Skips comments and empty lines
+      if (!(ss >> seconds)) continue;
+      auto time = chrono::duration_cast<chrono::duration>(std::chrono::duration<double>(seconds));
+      std::string type, name;
+      ss >> type >> name;
+      if (type == "press" || type == "release") {
+        auto key = Key::_from_string_nothrow(name.c_str());
+        if (!key) {
+          LOGE("{}:{}: Unknown key '{}'", file_, line_no, name);
+          continue;
+        }
+        if (type == "press") events_.push_back({time, KeyPressEvent{*key}});
+        else events_.push_back({time, KeyReleaseEvent{*key}});
+      } else if (type == "encoder") {
+        auto encoder = core::input::Encoder::_from_string_nothrow(name.c_str());
+        int steps = 0;
+        if (!encoder || !(ss >> steps)) {
+          LOGE("{}:{}: Expected 'encoder <blue|green|yellow|red> <steps>'", file_, line_no);
+          continue;
+        }
+        events_.push_back({time, EncoderEvent{*encoder, steps}});
+      } else {
+        LOGE("{}:{}: Unknown event '{}'", file_, line_no, type);
+      }
+    }
+    std::stable_sort(events_.begin(), events_.end(),
+                     [](const TimedEvent& a, const TimedEvent& b) { return a.time < b.time; });
+    LOGI("Loaded {} input events from '{}'", events_.size(), file_);
+  }
+
+  void run() noexcept
+  {
+    ThreadPolicy::set_role(ThreadPolicy::Role::io);
+    auto start = chrono::clock::now();
+    for (auto& [time, event] : events_) {
+      // Sleep in short steps, so the thread stops quickly on exit
+      while (!stop_ && chrono::clock::now() < start + time) {
+        auto left = start + time - chrono::clock::now();
+        std::this_thread::sleep_for(std::min<chrono::duration>(left, std::chrono::milliseconds(10)));
+      }
+      if (stop_ || !Application::current().running()) return;
+      input_time_ = util::latency_clock::now();
+      util::match(
+        event, [this](KeyPressEvent& e) { keypress(e.key); }, [this](KeyReleaseEvent& e) { keyrelease(e.key); },
+        [this](EncoderEvent& e) { encoder(e); });
+    }
+  }
+
+  std::string file_;
+  std::vector<TimedEvent> events_;
+  std::atomic_bool stop_ = false;
+  std::thread thread_;
+};
+
+int main(int argc, char* argv[])
+{
+  try {
+    Application app{[&] { return std::make_unique<LogManager>(argc, argv); },
+                    StateManager::create_default,
+                    PresetManager::create_default,
+                    std::make_unique<FileAudioManager>,
+                    ClockManager::create_default,
+                    std::make_unique<HeadlessUIManager>,
+                    std::make_unique<ScriptedController>,
+                    EngineManager::create_default};
+
+    auto cli = lyra::cli_parser();
+    FileAudioManager::current().add_args(cli);
+    ThreadPolicy::current().add_args(cli);
+    ScriptedController::current().add_args(cli);
+
+    cli.parse({argc, argv});
+
+    FileAudioManager::current().open();
+    ScriptedController::current().open();
+    ThreadPolicy::current().apply();
+
+    // Overwrite the logger signal handlers
+    std::signal(SIGABRT, Application::handle_signal);
+    std::signal(SIGTERM, Application::handle_signal);
+    std::signal(SIGINT, Application::handle_signal);
+
+    app.engine_manager->start();
+    app.audio_manager->start();
+    app.ui_manager->main_ui_loop();
+
+  } catch (const char* e) {
+    return handle_exception(e);
+  } catch (std::exception& e) {
+    return handle_exception(e);
+  } catch (...) {
+    return handle_exception();
+  }
+
+  LOG_F(INFO, "Exiting");
+  return 0;
+}
+
+int handle_exception(const char* e)
+{
+  LOGE("{}", e);
+  LOGE("Exception thrown, exitting!");
+  return 1;
+}
+
+int handle_exception(std::exception& e)
+{
+  LOGE("{}", e.what());
+  LOGE("Exception thrown, exitting!");
+  return 1;
+}
+
+int handle_exception()
+{
+  LOGE("Unknown exception thrown, exitting!");
+  return 1;
+}
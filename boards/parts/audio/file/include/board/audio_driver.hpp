@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/audio/midi.hpp"
+#include "core/audio/processor.hpp"
+
+#include "services/audio_manager.hpp"
+
+namespace otto::services {
+
+  /// Audio manager which reads and writes files, instead of a sound card.
+  ///
+  /// Audio is processed on its own thread, paced by a timer to run in real time,
+  /// or as fast as possible. Input and output may also be named pipes (FIFOs).
+  ///
+  /// Used to run the whole application on machines without sound hardware, and
+  /// to measure how much headroom the audio processing has.
+  struct FileAudioManager final : AudioManager {
+    struct Config {
+      /// Input audio. A WAV file (16 bit or float) if it ends in `.wav`, otherwise raw
+      /// 32 bit float mono. Empty for silence.
+      std::string input;
+      /// Output audio. A 32 bit float stereo WAV file if it ends in `.wav`, otherwise raw
+      /// interleaved 32 bit float stereo. Empty to discard the output.
+      std::string output;
+      /// Midi events. Each line holds the time in seconds, followed by the bytes of the event in hex:
+      /// `0.5 90 3c 7f`. Lines starting with `#` are ignored.
+      std::string midi;
+      /// Process as fast as possible, instead of pacing the processing to real time.
+      bool fast = false;
+      int samplerate = 48000;
+      int buffer_size = 256;
+      /// Exit the application after this many seconds. 0 to run until exit.
+      float duration = 0;
+    };
+
+    FileAudioManager();
+    ~FileAudioManager() noexcept;
+
+    template<typename Parser>
+    void add_args(Parser& cli);
+
+    /// Open the files, and start processing.
+    ///
+    /// Call this after the arguments have been parsed.
+    void open();
+
+    static FileAudioManager& current()
+    {
+      return dynamic_cast<FileAudioManager&>(AudioManager::current());
+    }
+
+  private:
+    struct TimedEvent {
+      /// Time in frames since the start
+      long frame;
+      core::midi::AnyMidiEvent event;
+    };
+
+    void open_input();
+    void open_output();
+    void load_midi();
+    void close_output() noexcept;
+
+    /// The processing thread
+    void run() noexcept;
+    void process() noexcept;
+    void read_input(int nframes) noexcept;
+    void write_output(int nframes) noexcept;
+    void gather_midi(int nframes) noexcept;
+
+    Config config_;
+
+    std::ifstream input_;
+    bool input_ended_ = false;
+    /// Format of the input samples
+    enum struct SampleFormat { float32, int16 } input_format_ = SampleFormat::float32;
+    int input_channels_ = 1;
+
+    std::ofstream output_;
+    bool output_wav_ = false;
+    long frames_written_ = 0;
+
+    std::vector<TimedEvent> midi_events_;
+    std::size_t next_midi_ = 0;
+
+    /// Buffers of `buffer_size`. Allocated in `open`
+    std::vector<float> in_buf_;
+    std::vector<float> out_l_;
+    std::vector<float> out_r_;
+    std::vector<char> io_buf_;
+
+    /// Frames processed since the start
+    long frame_ = 0;
+
+    long buffers_ = 0;
+    long overruns_ = 0;
+    float max_load_ = 0;
+    double total_load_ = 0;
+
+    std::atomic_bool stop_ = false;
+    std::thread thread_;
+  };
+
+#ifdef LYRA_OPT_HPP
+  template<typename Parser>
+  void FileAudioManager::add_args(Parser& cli)
+  {
+    cli |= lyra::opt(config_.input, "file")["--audio-in"]("Input audio file or fifo (.wav or raw float)");
+    cli |= lyra::opt(config_.output, "file")["--audio-out"]("Output audio file or fifo (.wav or raw float)");
+    cli |= lyra::opt(config_.midi, "file")["--midi-in"]("File with timestamped midi events");
+    cli |= lyra::opt(config_.fast)["--fast"]("Process as fast as possible, instead of in real time");
+    cli |= lyra::opt(config_.samplerate, "samplerate")["--samplerate"]("The samplerate");
+    cli |= lyra::opt(config_.buffer_size, "frames")["--buffer-size"]("The buffer size");
+    cli |= lyra::opt(config_.duration, "seconds")["--duration"]("Exit after this many seconds");
+  }
+#endif
+
+} // namespace otto::services
+
+// kak: other_file=../../src/file_audio.cpp
@@ -0,0 +1,353 @@
+#include "board/audio_driver.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#include "util/algorithm.hpp"
+
+#include "services/application.hpp"
+#include "services/engine_manager.hpp"
+#include "services/log_manager.hpp"
+#include "services/thread_policy.hpp"
+
+#include <Gamma/Domain.h>
+
+namespace otto::services {
+
+  using clock = std::chrono::steady_clock;
+
+  namespace {
+    bool ends_with(const std::string& str, std::string_view suffix)
+    {
+      return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    template<typename T>
+    T read_le(std::istream& is)
+    {
+      T res{};
+      is.read(reinterpret_cast<char*>(&res), sizeof(T));
+      return res;
+    }
+
+    template<typename T>
+    void write_le(std::ostream& os, T val)
+    {
+      os.write(reinterpret_cast<const char*>(&val), sizeof(T));
+    }
+
+    /// Write a WAV header for 32 bit float stereo
+    void write_wav_header(std::ostream& os, std::uint32_t samplerate, std::uint32_t frames)
+    {
+      constexpr std::uint16_t channels = 2;
+      constexpr std::uint16_t bytes_per_frame = channels * sizeof(float);
+      const std::uint32_t data_size = frames * bytes_per_frame;
+      os.write("RIFF", 4);
+      write_le<std::uint32_t>(os, 36 + data_size);
+      os.write("WAVEfmt ", 8);
+      write_le<std::uint32_t>(os, 16);
+      write_le<std::uint16_t>(os, 3); // IEEE float
+      write_le<std::uint16_t>(os, channels);
+      write_le<std::uint32_t>(os, samplerate);
+      write_le<std::uint32_t>(os, samplerate * bytes_per_frame);
+      write_le<std::uint16_t>(os, bytes_per_frame);
+      write_le<std::uint16_t>(os, 32);
+      os.write("data", 4);
+      write_le<std::uint32_t>(os, data_size);
+    }
+  } // namespace
+
+  FileAudioManager::FileAudioManager() = default;
+
+  FileAudioManager::~FileAudioManager() noexcept
+  {
+    stop_ = true;
+    if (thread_.joinable()) thread_.join();
+    close_output();
+    if (buffers_ > 0) {
+      LOGI("Processed {} buffers ({:.1f}s of audio). Average load: {:.1f}%, max load: {:.1f}%, {} overruns", buffers_,
+           float(frame_) / _samplerate, 100 * total_load_ / buffers_, 100 * max_load_, overruns_);
+    }
+    if (key_to_sound_latency.count() > 0) {
+      LOGI("Key to sound latency: {}", key_to_sound_latency.summary());
+    }
+  }
+
+  void FileAudioManager::open()
+  {
+    if (config_.samplerate <= 0 || config_.buffer_size <= 0) {
+      throw Application::exception(Application::ErrorCode::audio_error, "Invalid samplerate {} or buffer size {}",
+                                   config_.samplerate, config_.buffer_size);
+    }
+    _samplerate = config_.samplerate;
+    gam::sampleRate(config_.samplerate);
+
+    auto bs = config_.buffer_size;
+    buffer_pool().reserve_buffer_size(bs);
+    buffer_pool().set_buffer_size(bs);
+    _buffer_size = bs;
+    events.buffer_size_change.emit(bs);
+
+    in_buf_.assign(bs, 0.f);
+    out_l_.assign(bs, 0.f);
+    out_r_.assign(bs, 0.f);
+
+    open_input();
+    open_output();
+    load_midi();
+
+    LOGI("Processing {}, buffers of {} frames at {}Hz, {}", config_.fast ? "as fast as possible" : "in real time",
+         bs, config_.samplerate, config_.duration > 0 ? fmt::format("for {}s", config_.duration) : "until exit");
+
+    thread_ = std::thread([this] { run(); });
+  }
+
+  void FileAudioManager::open_input()
+  {
+    if (config_.input.empty()) {
+      input_ended_ = true;
+      return;
+    }
+    input_.open(config_.input, std::ios::binary);
+    if (!input_) {
+      throw Application::exception(Application::ErrorCode::audio_error, "Could not open audio input '{}'",
+                                   config_.input);
+    }
+    auto bad_wav = [&](std::string_view why) {
+      return Application::exception(Application::ErrorCode::audio_error, "Invalid WAV file '{}': {}", config_.input,
+                                    why);
+    };
+    if (ends_with(config_.input, ".wav")) {
+      char id[4];
+      input_.read(id, 4);
+      read_le<std::uint32_t>(input_);
+      char wave[4];
+      input_.read(wave, 4);
+      if (!input_ || std::memcmp(id, "RIFF", 4) != 0 || std::memcmp(wave, "WAVE", 4) != 0) {
+        throw bad_wav("missing RIFF header");
+      }
+      bool has_fmt = false;
+      // Skip chunks until the data chunk
+      while (true) {
+        input_.read(id, 4);
+        auto size = read_le<std::uint32_t>(input_);
+        if (!input_) throw bad_wav("no data chunk");
+        if (std::memcmp(id, "fmt ", 4) == 0) {
+          auto format = read_le<std::uint16_t>(input_);
+          input_channels_ = read_le<std::uint16_t>(input_);
+          auto samplerate = read_le<std::uint32_t>(input_);
+          read_le<std::uint32_t>(input_);
+          read_le<std::uint16_t>(input_);
+          auto bits = read_le<std::uint16_t>(input_);
+          if (format == 1 && bits == 16) {
+            input_format_ = SampleFormat::int16;
+          } else if (format == 3 && bits == 32) {
+            input_format_ = SampleFormat::float32;
+          } else {
+            throw bad_wav(fmt::format("unsupported format {} with {} bits", format, bits));
+          }
+          if (input_channels_ < 1) throw bad_wav("no channels");
+          LOGW_IF(int(samplerate) != config_.samplerate, "The samplerate of '{}' is {}Hz, but audio runs at {}Hz",
+                  config_.input, samplerate, config_.samplerate);
+          input_.ignore(size - 16 + (size & 1));
+          has_fmt = true;
+        } else if (std::memcmp(id, "data", 4) == 0) {
+          if (!has_fmt) throw bad_wav("data chunk before fmt chunk");
+          break;
+        } else {
+          // Chunks are padded to an even size
+          input_.ignore(size + (size & 1));
+        }
+      }
+    }
+    auto sample_size = input_format_ == SampleFormat::int16 ? sizeof(std::int16_t) : sizeof(float);
+    io_buf_.resize(std::max(io_buf_.size(), config_.buffer_size * input_channels_ * sample_size));
+  }
+
+  void FileAudioManager::open_output()
+  {
+    if (config_.output.empty()) return;
+    output_.open(config_.output, std::ios::binary | std::ios::trunc);
+    if (!output_) {
+      throw Application::exception(Application::ErrorCode::audio_error, "Could not open audio output '{}'",
+                                   config_.output);
+    }
+    output_wav_ = ends_with(config_.output, ".wav");
+    // The sizes are unknown until the file is closed. They are patched in `close_output`
+    if (output_wav_) write_wav_header(output_, config_.samplerate, 0);
+    io_buf_.resize(std::max<std::size_t>(io_buf_.size(), config_.buffer_size * 2 * sizeof(float)));
+  }
+
+  void FileAudioManager::close_output() noexcept
+  {
+    if (!output_.is_open()) return;
+    if (output_wav_) {
+      output_.seekp(0);
+      // Seeking fails on pipes, in which case the header keeps its placeholder sizes
+      if (output_) write_wav_header(output_, config_.samplerate, frames_written_);
+    }
+    output_.close();
+  }
+
+  void FileAudioManager::load_midi()
+  {
+    if (config_.midi.empty()) return;
+    std::ifstream file(config_.midi);
+    if (!file) {
+      throw Application::exception(Application::ErrorCode::audio_error, "Could not open midi file '{}'", config_.midi);
+    }
+    std::string line;
+    for (int line_no = 1; std::getline(file, line); line_no++) {
+      std::istringstream ss(line);
+      double seconds;
+      // Skips comments and empty lines
+      if (!(ss >> seconds)) continue;
+      std::vector<unsigned char> bytes;
+      unsigned byte;
+      while (ss >> std::hex >> byte) bytes.push_back(byte);
+      try {
+        midi_events_.push_back({long(seconds * config_.samplerate), core::midi::from_bytes(bytes)});
+      } catch (util::exception& e) {
+        LOGE("{}:{}: Error parsing midi: {}", config_.midi, line_no, e.what());
+      }
+    }
+    std::stable_sort(midi_events_.begin(), midi_events_.end(),
+                     [](const TimedEvent& a, const TimedEvent& b) { return a.frame < b.frame; });
+    LOGI("Loaded {} midi events from '{}'", midi_events_.size(), config_.midi);
+  }
+
+  void FileAudioManager::run() noexcept
+  {
+    ThreadPolicy::set_role(ThreadPolicy::Role::audio);
+    const auto buffer_duration =
+      std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(double(_buffer_size) / _samplerate));
+    const long duration_frames = long(config_.duration * config_.samplerate);
+    auto deadline = clock::now() + buffer_duration;
+    while (!stop_) {
+      if (!running() || !Application::current().running()) {
+        // Wait for `start`, without spinning
+        std::this_thread::sleep_for(buffer_duration);
+        deadline = clock::now() + buffer_duration;
+        continue;
+      }
+
+      auto t0 = clock::now();
+      process();
+      auto load = std::chrono::duration<float>(clock::now() - t0) / buffer_duration;
+      record_dsp_load(load);
+      max_load_ = std::max(max_load_, load);
+      total_load_ += load;
+      if (load > 1) overruns_++;
+
+      if (duration_frames > 0 && frame_ >= duration_frames) {
+        Application::current().exit(Application::ErrorCode::none);
+        return;
+      }
+
+      if (!config_.fast) {
+        // Keep the pace against the absolute deadline, so small delays do not accumulate.
+        // After an overrun, the schedule restarts from now instead of trying to catch up.
+        auto now = clock::now();
+        if (deadline < now) deadline = now;
+        std::this_thread::sleep_until(deadline);
+        deadline += buffer_duration;
+      }
+    }
+  }
+
+  void FileAudioManager::process() noexcept
+  {
+    pre_process_tasks();
+    const int nframes = _buffer_size;
+
+    read_input(nframes);
+
+    midi_bufs.swap();
+    gather_midi(nframes);
+
+    int ref_count = 0;
+    auto in_buf = core::audio::AudioBufferHandle(in_buf_.data(), nframes, ref_count);
+    auto out = Application::current().engine_manager->process(
+      {in_buf, {std::move(midi_bufs.inner())}, core::clock::ClockRange{}}, {out_l_.data(), out_r_.data()});
+
+    write_output(nframes);
+
+    // return the midi buffer
+    midi_bufs.inner() = out.midi.move_vector_out();
+
+    frame_ += nframes;
+    buffers_++;
+  }
+
+  void FileAudioManager::read_input(int nframes) noexcept
+  {
+    if (input_ended_) {
+      std::fill_n(in_buf_.begin(), nframes, 0.f);
+      return;
+    }
+    const int sample_size = input_format_ == SampleFormat::int16 ? sizeof(std::int16_t) : sizeof(float);
+    const int frame_size = sample_size * input_channels_;
+    input_.read(io_buf_.data(), nframes * frame_size);
+    const int frames_read = input_.gcount() / frame_size;
+    if (frames_read < nframes) {
+      RT_LOGI("Reached the end of the audio input");
+      input_ended_ = true;
+    }
+    for (int i = 0; i < frames_read; i++) {
+      float sum = 0;
+      for (int c = 0; c < input_channels_; c++) {
+        const char* src = io_buf_.data() + i * frame_size + c * sample_size;
+        if (input_format_ == SampleFormat::int16) {
+          std::int16_t s;
+          std::memcpy(&s, src, sizeof(s));
+          sum += s / 32768.f;
+        } else {
+          float s;
+          std::memcpy(&s, src, sizeof(s));
+          sum += s;
+        }
+      }
+      in_buf_[i] = sum / input_channels_;
+    }
+    std::fill(in_buf_.begin() + frames_read, in_buf_.begin() + nframes, 0.f);
+  }
+
+  void FileAudioManager::write_output(int nframes) noexcept
+  {
+    if (!output_.is_open()) return;
+    auto* dst = reinterpret_cast<float*>(io_buf_.data());
+    for (int i = 0; i < nframes; i++) {
+      dst[2 * i] = out_l_[i];
+      dst[2 * i + 1] = out_r_[i];
+    }
+    output_.write(io_buf_.data(), nframes * 2 * sizeof(float));
+    if (!output_) {
+      // The reading end of a pipe was closed, or the disk is full
+      RT_LOGE("Could not write to the audio output '{}'. Stopping", config_.output.c_str());
+      Application::current().exit(Application::ErrorCode::audio_error);
+      stop_ = true;
+      return;
+    }
+    frames_written_ += nframes;
+  }
+
+  void FileAudioManager::gather_midi(int nframes) noexcept
+  {
+    const long end = frame_ + nframes;
+    for (; next_midi_ < midi_events_.size() && midi_events_[next_midi_].frame < end; next_midi_++) {
+      auto event = midi_events_[next_midi_].event;
+      const int offset = std::max(0L, midi_events_[next_midi_].frame - frame_);
+      // The file is the input of the system, so the events enter it when they are handled
+      util::match(event, [&](auto& ev) {
+        ev.time = offset;
+        ev.input_time = buffer_time();
+      });
+      midi_bufs.inner().push_back(std::move(event));
+    }
+  }
+
+} // namespace otto::services
+
+// kak: other_file=../include/board/audio_driver.hpp
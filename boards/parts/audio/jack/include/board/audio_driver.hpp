@@ -6,69 +6,72 @@
 
 #include <jack/jack.h>
 #include <jack/midiport.h>
+
 #include "core/audio/midi.hpp"
 #include "core/audio/processor.hpp"
-#include "util/locked.hpp"
 
-#include "util/locked.hpp"
+#include "services/audio_manager.hpp"
 
-namespace otto::service::audio {
-  struct JackAudioDriver {
-    static JackAudioDriver& get() noexcept;
+namespace otto::services {
 
-    void init();
-    void shutdown();
+  /// Audio manager for the JACK audio connection kit.
+  ///
+  /// The engine chain renders straight into the port buffers of Jack, so
+  /// neither the input nor the output is copied.
+  struct JackAudioManager final : AudioManager {
+    JackAudioManager();
+    ~JackAudioManager() noexcept;
 
-    std::atomic_int samplerate;
+    /// Enable or disable freewheel mode.
+    ///
+    /// In freewheel mode, Jack runs the process callback as fast as possible, instead of in sync
+    /// with the sound card, which is useful for rendering faster than real time.
+    /// Must not be called from the audio thread.
+    void set_freewheel(bool on) noexcept;
 
-    void send_midi_event(core::midi::AnyMidiEvent) noexcept;
+    /// Whether Jack is currently running in freewheel mode
+    bool freewheeling() const noexcept
+    {
+      return freewheeling_;
+    }
 
-    core::audio::AudioBufferPool& buffer_pool();
+    static JackAudioManager& current()
+    {
+      return dynamic_cast<JackAudioManager&>(AudioManager::current());
+    }
 
   private:
-    JackAudioDriver() = default;
-    ~JackAudioDriver() noexcept = default;
-
-    using AudioSample = jack_default_audio_sample_t;
-    static constexpr const size_t sampleSize = sizeof(AudioSample);
-    static constexpr const char* const clientName = "OTTO";
-
-    struct {
-      jack_port_t *outL;
-      jack_port_t *outR;
-      jack_port_t *input;
-      jack_port_t *midiIn;
-      jack_port_t *midiOut;
-    } ports;
+    static constexpr const char* client_name = "OTTO";
 
-    std::size_t bufferSize;
+    enum struct PortType { audio, midi };
 
-    jack_client_t* client;
-    jack_status_t jackStatus;
+    void register_ports();
+    void connect_ports();
+    std::vector<std::string> find_ports(unsigned long flags, PortType type = PortType::audio);
+    /// Connect the output port `src` to the input port `dest`
+    bool connect(const std::string& src, const std::string& dest);
 
-    util::atomic_swap<core::midi::shared_vector<core::midi::AnyMidiEvent>> midi_bufs = {{}, {}};
+    int process(jack_nframes_t nframes) noexcept;
+    void gather_midi(jack_nframes_t nframes) noexcept;
+    void write_midi(core::midi::shared_vector<core::midi::AnyMidiEvent>& events, jack_nframes_t nframes) noexcept;
 
-    enum class PortType {
-      Audio,
-      Midi
-    };
+    /// Called by Jack from a non-realtime thread, while process is not running
+    int on_buffer_size(jack_nframes_t nframes) noexcept;
+    int on_samplerate(jack_nframes_t samplerate) noexcept;
 
-    void setupPorts();
-    std::vector<std::string> findPorts(int criteria, PortType type = PortType::Audio);
+    jack_client_t* client_ = nullptr;
 
-    // Helper function for connections
-    bool connectPorts(const std::string& src, const std::string& dest);
-    void samplerateCallback(unsigned srate);
-    void buffersizeCallback(unsigned buffsize);
-    void new_port_callback(jack_port_id_t id);
-    void gatherMidiInput(int nFrames);
-    void process(int nframes);
-
-    /// Jack cannot connect to a port from the notification thread, so we just add them here, and process them from the main one instead.
-    std::vector<jack_port_id_t> new_ports;
-
-    std::unique_ptr<core::audio::AudioBufferPool> _buffer_pool;
+    struct {
+      jack_port_t* input = nullptr;
+      jack_port_t* out_l = nullptr;
+      jack_port_t* out_r = nullptr;
+      jack_port_t* midi_in = nullptr;
+      jack_port_t* midi_out = nullptr;
+    } ports_;
+
+    std::atomic_bool freewheeling_ = false;
   };
 
-  using AudioDriver = JackAudioDriver;
-} // otto::audio
+} // namespace otto::services
+
+// kak: other_file=../../src/jack.cpp
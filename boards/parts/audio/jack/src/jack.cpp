@@ -1,325 +1,242 @@
 #include "board/audio_driver.hpp"
 
-#include <string>
-#include <vector>
-
-#include <fmt/format.h>
-#include <jack/jack.h>
-#include <jack/midiport.h>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
 
 #include "util/algorithm.hpp"
-#include "util/timer.hpp"
-
-#include "core/audio/processor.hpp"
-#include "core/globals.hpp"
 
-#include "services/audio.hpp"
-#include "services/engines.hpp"
-#include "services/logger.hpp"
-
-namespace otto::service::audio {
-  namespace {
-    void jackError(const char* s)
-    {
-      LOGE("JACK: {}", s);
-    }
+#include "services/application.hpp"
+#include "services/engine_manager.hpp"
+#include "services/log_manager.hpp"
+#include "services/thread_policy.hpp"
 
-    void jackLogInfo(const char* s)
-    {
-      LOGI("JACK: {}", s);
-    }
-
-    void jackShutdown(void* arg)
-    {
-      LOGI("JACK shut down, exiting");
-    }
-  } // namespace
+#include <Gamma/Domain.h>
 
-  JackAudioDriver& JackAudioDriver::get() noexcept
-  {
-    static JackAudioDriver instance{};
-    return instance;
-  }
+namespace otto::services {
 
-  core::audio::AudioBufferPool& JackAudioDriver::buffer_pool()
-  {
-    return *_buffer_pool;
-  }
+  using clock = std::chrono::high_resolution_clock;
 
-  void JackAudioDriver::init()
+  JackAudioManager::JackAudioManager()
   {
-    jack_set_error_function(jackError);
-    jack_set_info_function(jackLogInfo);
+    jack_set_error_function([](const char* s) { LOGE("JACK: {}", s); });
+    jack_set_info_function([](const char* s) { LOGI("JACK: {}", s); });
 
-    client = jack_client_open(clientName, JackNullOption, &jackStatus);
-
-    if ((!jackStatus) & JackServerStarted) {
-      throw global::exception(global::ErrorCode::audio_error, "Failed to start jack server");
+    jack_status_t status;
+    client_ = jack_client_open(client_name, JackNullOption, &status);
+    if (client_ == nullptr) {
+      throw Application::exception(Application::ErrorCode::audio_error, "Could not open a Jack client (status {:#x})",
+                                   status);
     }
+    if (status & JackServerStarted) LOGI("Started the Jack server");
 
-    LOGI("Jack server started");
-    LOGI("Jack client status: {}", jackStatus);
-
-    jack_set_process_callback(client,
-                              [](jack_nframes_t nframes, void* arg) {
-                                (static_cast<JackAudioDriver*>(arg))->process(nframes);
-                                return 0;
-                              },
-                              this);
-
-    jack_set_sample_rate_callback(
-      client,
-      [](jack_nframes_t nframes, void* arg) {
-        (static_cast<JackAudioDriver*>(arg))->samplerateCallback(nframes);
-        return 0;
-      },
+    jack_set_process_callback(
+      client_, [](jack_nframes_t nframes, void* self) { return static_cast<JackAudioManager*>(self)->process(nframes); },
       this);
-
     jack_set_buffer_size_callback(
-      client,
-      [](jack_nframes_t nframes, void* arg) {
-        (static_cast<JackAudioDriver*>(arg))->buffersizeCallback(nframes);
-        return 0;
-      },
+      client_,
+      [](jack_nframes_t nframes, void* self) { return static_cast<JackAudioManager*>(self)->on_buffer_size(nframes); },
       this);
-
-    jack_set_port_registration_callback(
-      client,
-      [](jack_port_id_t id, int is_register, void* data) {
-        if (is_register) (static_cast<JackAudioDriver*>(data))->new_ports.push_back(id);
+    jack_set_sample_rate_callback(
+      client_, [](jack_nframes_t sr, void* self) { return static_cast<JackAudioManager*>(self)->on_samplerate(sr); },
+      this);
+    jack_set_freewheel_callback(
+      client_,
+      [](int starting, void* self) {
+        static_cast<JackAudioManager*>(self)->freewheeling_ = starting != 0;
+        LOGI("Jack freewheel mode {}", starting ? "started" : "stopped");
       },
       this);
+    jack_on_shutdown(
+      client_,
+      [](void*) {
+        LOGE("The Jack server shut down");
+        Application::current().exit(Application::ErrorCode::audio_error);
+      },
+      nullptr);
 
-    jack_on_shutdown(client, jackShutdown, nullptr);
+    on_samplerate(jack_get_sample_rate(client_));
+    on_buffer_size(jack_get_buffer_size(client_));
 
-    bufferSize = jack_get_buffer_size(client);
+    register_ports();
 
-    if (jack_activate(client)) {
-      throw global::exception(global::ErrorCode::audio_error, "Cannot activate jack client");
+    if (jack_activate(client_)) {
+      throw Application::exception(Application::ErrorCode::audio_error, "Could not activate the Jack client");
     }
 
-    setupPorts();
-
-    LOG_F(INFO, "Initialized JackAudio");
+    // Ports can only be connected once the client is active
+    connect_ports();
   }
 
-  void JackAudioDriver::shutdown()
+  JackAudioManager::~JackAudioManager() noexcept
   {
-    LOG_F(INFO, "Closing Jack client");
-    jack_client_close(client);
+    if (client_ == nullptr) return;
+    jack_deactivate(client_);
+    jack_client_close(client_);
   }
 
-  void JackAudioDriver::send_midi_event(core::midi::AnyMidiEvent evt) noexcept
+  void JackAudioManager::set_freewheel(bool on) noexcept
   {
-    midi_bufs.outer().emplace_back(std::move(evt));
+    LOGE_IF(jack_set_freewheel(client_, on) != 0, "Could not {} Jack freewheel mode", on ? "start" : "stop");
   }
 
-  void JackAudioDriver::setupPorts()
+  void JackAudioManager::register_ports()
   {
-    // Audio ports
-    ports.input = jack_port_register(client, "input", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-
-    if (ports.input == NULL) {
-      throw global::exception(global::ErrorCode::audio_error, "Couldn't register input port");
-    }
-
-    ports.outL =
-      jack_port_register(client, "outLeft", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-    ports.outR =
-      jack_port_register(client, "outRight", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-
-    auto inputs = findPorts(JackPortIsPhysical | JackPortIsOutput);
-    auto outputs = findPorts(JackPortIsPhysical | JackPortIsInput);
-
-    if (outputs.empty()) {
-      throw global::exception(global::ErrorCode::audio_error,
-                              "Couldn't find physical output ports");
-    }
-
-    bool s;
-
-    for (auto& p : inputs) {
-      s = connectPorts(jack_port_name(ports.input), p);
-      if (!s) {
-        global::exit(global::ErrorCode::audio_error);
-        return;
+    auto reg = [&](const char* name, const char* type, unsigned long flags) {
+      auto* port = jack_port_register(client_, name, type, flags, 0);
+      if (port == nullptr) {
+        throw Application::exception(Application::ErrorCode::audio_error, "Could not register Jack port '{}'", name);
       }
-    }
+      return port;
+    };
+    ports_.input = reg("in", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput);
+    ports_.out_l = reg("out_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput);
+    ports_.out_r = reg("out_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput);
+    ports_.midi_in = reg("midi_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput);
+    ports_.midi_out = reg("midi_out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput);
+  }
 
-    s = connectPorts(outputs[0 % outputs.size()], jack_port_name(ports.outL));
-    if (!s) {
-      global::exit(global::ErrorCode::audio_error);
-      return;
-    }
+  void JackAudioManager::connect_ports()
+  {
+    auto capture = find_ports(JackPortIsPhysical | JackPortIsOutput);
+    auto playback = find_ports(JackPortIsPhysical | JackPortIsInput);
 
-    s = connectPorts(outputs[1 % outputs.size()], jack_port_name(ports.outR));
-    if (!s) {
-      global::exit(global::ErrorCode::audio_error);
-      return;
+    if (!capture.empty()) {
+      LOGE_IF(!connect(capture[0], jack_port_name(ports_.input)), "Could not connect {} to the input", capture[0]);
+    } else {
+      LOGW("No physical capture ports found");
     }
 
-    // Midi ports
-    ports.midiIn = jack_port_register(client, "midiIn", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
-
-    if (ports.midiIn == NULL) {
-      throw global::exception(global::ErrorCode::audio_error, "Couldn't register midi_in port");
+    if (!playback.empty()) {
+      auto& left = playback[0];
+      auto& right = playback[1 % playback.size()];
+      LOGE_IF(!connect(jack_port_name(ports_.out_l), left), "Could not connect the left output to {}", left);
+      LOGE_IF(!connect(jack_port_name(ports_.out_r), right), "Could not connect the right output to {}", right);
+    } else {
+      LOGW("No physical playback ports found");
     }
 
-    ports.midiOut =
-      jack_port_register(client, "midiOut", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
-
-    auto midiIn = findPorts(JackPortIsPhysical | JackPortIsOutput, PortType::Midi);
-    auto midiOut = findPorts(JackPortIsPhysical | JackPortIsInput, PortType::Midi);
-
-    if (midiIn.empty()) {
-      LOGE("Couldn't find physical midi input port");
-      return;
+    for (auto& port : find_ports(JackPortIsPhysical | JackPortIsOutput, PortType::midi)) {
+      LOGE_IF(!connect(port, jack_port_name(ports_.midi_in)), "Could not connect {} to the midi input", port);
     }
-    if (midiOut.empty()) {
-      LOGE("Couldn't find physical midi output port");
-      return;
+    for (auto& port : find_ports(JackPortIsPhysical | JackPortIsInput, PortType::midi)) {
+      LOGE_IF(!connect(jack_port_name(ports_.midi_out), port), "Could not connect the midi output to {}", port);
     }
-
-    s = connectPorts(jack_port_name(ports.midiIn), midiIn[0]);
-    LOGE_IF(!s, "Couldn't connect midi input");
-
-    s = connectPorts(midiOut[0], jack_port_name(ports.midiOut));
-    LOGE_IF(!s, "Couldn't connect midi output");
   }
 
-  std::vector<std::string> JackAudioDriver::findPorts(int criteria, PortType type)
+  std::vector<std::string> JackAudioManager::find_ports(unsigned long flags, PortType type)
   {
     const char** ports =
-      jack_get_ports(client, nullptr, (type == PortType::Audio) ? "audio" : "midi", criteria);
-    std::vector<std::string> ret;
-    if (ports == nullptr) return ret;
+      jack_get_ports(client_, nullptr, type == PortType::audio ? JACK_DEFAULT_AUDIO_TYPE : JACK_DEFAULT_MIDI_TYPE, flags);
+    std::vector<std::string> res;
+    if (ports == nullptr) return res;
     for (int i = 0; ports[i] != nullptr; i++) {
-      ret.emplace_back(ports[i]);
+      res.emplace_back(ports[i]);
     }
     jack_free(ports);
-    return ret;
+    return res;
   }
 
-  /// Helper function for connections
-  bool JackAudioDriver::connectPorts(const std::string& src, const std::string& dest)
+  bool JackAudioManager::connect(const std::string& src, const std::string& dest)
   {
-    return !jack_connect(client, dest.c_str(), src.c_str());
+    int err = jack_connect(client_, src.c_str(), dest.c_str());
+    return err == 0 || err == EEXIST;
   }
 
-  void JackAudioDriver::samplerateCallback(unsigned srate)
+  int JackAudioManager::on_buffer_size(jack_nframes_t nframes) noexcept
   {
-    LOG_F(INFO, "Jack changed the sample rate to {}", srate);
-    samplerate = srate;
-    audio::events::samplerate_change().fire(srate);
+    LOGI("Jack buffer size: {}", nframes);
+    // The pool only reallocates if the buffers grow, and this is not the audio thread
+    buffer_pool().reserve_buffer_size(nframes);
+    buffer_pool().set_buffer_size(nframes);
+    _buffer_size = nframes;
+    events.buffer_size_change.emit(nframes);
+    return 0;
   }
 
-  void JackAudioDriver::buffersizeCallback(unsigned buffsize)
+  int JackAudioManager::on_samplerate(jack_nframes_t samplerate) noexcept
   {
-    LOG_F(INFO, "Jack changed the buffer size to {}", buffsize);
-    bufferSize = buffsize;
-    audio::events::buffersize_change().fire(buffsize);
-    _buffer_pool = std::make_unique<AudioBufferPool>(bufferSize);
+    LOGI("Jack samplerate: {}", samplerate);
+    _samplerate = samplerate;
+    gam::sampleRate(samplerate);
+    return 0;
   }
 
-  void JackAudioDriver::new_port_callback(jack_port_id_t id)
+  void JackAudioManager::gather_midi(jack_nframes_t nframes) noexcept
   {
-    DLOGI("New port");
-    auto* port = jack_port_by_id(client, id);
-    auto flags = jack_port_flags(port);
-    auto type = jack_port_type(port);
-    if (type != nullptr && strcmp(type, JACK_DEFAULT_MIDI_TYPE) == 0) {
-      if (flags & JackPortIsInput) {
-        auto portname = jack_port_name(port);
-        auto port2name = jack_port_name(ports.midiOut);
-        if (portname && port2name) connectPorts(portname, port2name);
-      } else if (flags & JackPortIsOutput) {
-        auto portname = jack_port_name(port);
-        auto port2name = jack_port_name(ports.midiIn);
-        if (portname && port2name) connectPorts(port2name, portname);
+    void* buf = jack_port_get_buffer(ports_.midi_in, nframes);
+    auto count = jack_midi_get_event_count(buf);
+    jack_midi_event_t event;
+    for (std::uint32_t i = 0; i < count; i++) {
+      if (jack_midi_event_get(&event, buf, i) != 0) continue;
+      try {
+        midi_bufs.inner().push_back(core::midi::from_bytes({event.buffer, event.size}, event.time));
+      } catch (util::exception& e) {
+        LOGE("Error parsing midi: {}", e.what());
       }
     }
   }
 
-  void JackAudioDriver::gatherMidiInput(int nframes)
+  void JackAudioManager::write_midi(core::midi::shared_vector<core::midi::AnyMidiEvent>& events,
+                                    jack_nframes_t nframes) noexcept
   {
-    midi_bufs.swap();
-
-    // Get new midi events
-    void* midiBuf = jack_port_get_buffer(ports.midiIn, nframes);
-    int nevents = jack_midi_get_event_count(midiBuf);
-
-    jack_midi_event_t event;
-    for (int i = 0; i < nevents; i++) {
-      using namespace core::midi;
-
-      jack_midi_event_get(&event, midiBuf, i);
-      MidiEvent mEvent;
-
-      mEvent.channel = event.buffer[0] & 0b00001111;
-      std::copy_n(event.buffer + 1, std::min(event.size - 1, mEvent.max_data_size),
-                  mEvent.data.begin());
-      mEvent.time = event.time;
-
-      auto type = MidiEvent::Type(event.buffer[0] >> 4);
-      switch (type) {
-      case MidiEvent::Type::NoteOff:
-        mEvent.type = MidiEvent::Type::NoteOff;
-        midi_bufs.inner().emplace_back(NoteOffEvent(mEvent));
-        break;
-      case MidiEvent::Type::NoteOn:
-        mEvent.type = MidiEvent::Type::NoteOn;
-        midi_bufs.inner().emplace_back(NoteOnEvent(mEvent));
-        break;
-      case MidiEvent::Type::ControlChange:
-        mEvent.type = MidiEvent::Type::ControlChange;
-        midi_bufs.inner().emplace_back(ControlChangeEvent(mEvent));
-        break;
-      }
+    void* buf = jack_port_get_buffer(ports_.midi_out, nframes);
+    jack_midi_clear_buffer(buf);
+    // Jack requires the events to be written in order
+    int last_time = 0;
+    for (auto& ev : events) {
+      util::match(ev, [&](auto& ev) {
+        auto bytes = ev.to_bytes();
+        last_time = std::clamp<int>(ev.time, last_time, nframes - 1);
+        jack_midi_event_write(buf, last_time, bytes.data(), bytes.size());
+      });
     }
   }
 
-  void JackAudioDriver::process(int nframes)
+  int JackAudioManager::process(jack_nframes_t nframes) noexcept
   {
-    auto running = audio::running() && global::running();
-    if (!running) {
-      return;
-    }
+    // Jack owns the thread, so it can only be configured from the callback
+    ThreadPolicy::set_role(ThreadPolicy::Role::audio);
+    pre_process_tasks();
 
-    if (!new_ports.empty()) {
-      for (auto port : new_ports) {
-        new_port_callback(port);
-      }
-      new_ports.clear();
-    }
-
-    TIME_SCOPE("JackAudio::Process");
+    auto* out_l = static_cast<float*>(jack_port_get_buffer(ports_.out_l, nframes));
+    auto* out_r = static_cast<float*>(jack_port_get_buffer(ports_.out_r, nframes));
+    auto* in = static_cast<float*>(jack_port_get_buffer(ports_.input, nframes));
 
-    if ((size_t) nframes > bufferSize) {
-      LOGE("Jack requested more frames than expected");
-      return;
+    auto running = this->running() && Application::current().running();
+    if (!running || nframes > _buffer_size) {
+      RT_LOGE_IF(running, "Jack requested {} frames. expected at most {}", nframes, int(_buffer_size));
+      std::fill_n(out_l, nframes, 0.f);
+      std::fill_n(out_r, nframes, 0.f);
+      jack_midi_clear_buffer(jack_port_get_buffer(ports_.midi_out, nframes));
+      return 0;
     }
 
-    gatherMidiInput(nframes);
+    clock::time_point t0 = clock::now();
 
-    float* outLData = (float*) jack_port_get_buffer(ports.outL, nframes);
-    float* outRData = (float*) jack_port_get_buffer(ports.outR, nframes);
-    float* inData = (float*) jack_port_get_buffer(ports.input, nframes);
+    midi_bufs.swap();
+    gather_midi(nframes);
 
     int ref_count = 0;
-    auto in_buf = AudioBufferHandle(inData, nframes, ref_count);
-    auto out_data =
-      engines::process({in_buf,
-                        {midi_bufs.inner()},
-                        nframes});
+    auto in_buf = core::audio::AudioBufferHandle(in, nframes, ref_count);
+    // The master stage writes directly to the port buffers
+    auto out = Application::current().engine_manager->process(
+      {in_buf, {std::move(midi_bufs.inner())}, core::clock::ClockRange{}}, {out_l, out_r});
 
-    audio::process_audio_output(out_data);
+    write_midi(out.midi, nframes);
 
-    LOGW_IF(out_data.nframes != nframes, "Frames went missing!");
+    // return the midi buffer
+    midi_bufs.inner() = out.midi.move_vector_out();
 
-    // Separate channels
-    for (int i = 0; i < nframes; i++) {
-      outLData[i] = std::get<0>(out_data.audio[i]);
-      outRData[i] = std::get<1>(out_data.audio[i]);
+    // In freewheel mode, there is no deadline to measure against
+    if (!freewheeling_) {
+      clock::time_point t1 = clock::now();
+      record_dsp_load(std::chrono::nanoseconds(t1 - t0).count() / (1e9 / float(_samplerate) * nframes));
     }
+
+    return 0;
   }
-} // namespace otto::service::audio
+
+} // namespace otto::services
+
+// kak: other_file=../include/board/audio_driver.hpp
@@ -40,6 +40,8 @@ namespace otto::services {
     std::optional<RtMidiIn> midi_in = std::nullopt;
     std::optional<RtMidiOut> midi_out = std::nullopt;
     bool enable_input = true;
+    /// Used as the input when there is no input device
+    std::vector<float> silent_input_;
 
     int device_in_ = client.getDefaultInputDevice();
     int device_out_ = client.getDefaultOutputDevice();
@@ -14,6 +14,7 @@
 #include "services/clock_manager.hpp"
 #include "services/engine_manager.hpp"
 #include "services/log_manager.hpp"
+#include "services/thread_policy.hpp"
 
 #include <Gamma/Domain.h>
 
@@ -66,7 +67,8 @@ namespace otto::services {
     inParameters.firstChannel = 0;
 
     RtAudio::StreamOptions options;
-    options.flags = RTAUDIO_SCHEDULE_REALTIME;
+    // Non-interleaved, so the master stage can write straight into the output buffer
+    options.flags = RTAUDIO_SCHEDULE_REALTIME | RTAUDIO_NONINTERLEAVED;
     options.numberOfBuffers = 1;
     options.streamName = "OTTO";
     unsigned buf_siz = _buffer_size;
@@ -81,6 +83,8 @@ namespace otto::services {
         this, &options);
       _buffer_size = buf_siz;
       buffer_pool().set_buffer_size(buf_siz);
+      silent_input_.assign(buf_siz, 0.f);
+      events.buffer_size_change.emit(buf_siz);
       client.startStream();
       gam::sampleRate(samplerate());
     } catch (RtAudioError& e) {
@@ -136,6 +140,8 @@ namespace otto::services {
                                    double stream_time,
                                    RtAudioStreamStatus stream_status)
   {
+    // RtAudio owns the thread, so it can only be configured from the callback
+    ThreadPolicy::set_role(ThreadPolicy::Role::audio);
     pre_process_tasks();
     auto running = this->running() && Application::current().running();
     if (!running) {
@@ -143,37 +149,26 @@ namespace otto::services {
     }
 
     if ((unsigned) nframes != _buffer_size) {
-      LOGE("RTAudio requested {} frames. expected {}", nframes, _buffer_size);
+      RT_LOGE("RTAudio requested {} frames. expected {}", nframes, int(_buffer_size));
       return 0;
     }
 
     if (stream_status != 0) {
-      LOGE("RTAudioStreamStatus == {:x}", stream_status);
+      RT_LOGE("RTAudioStreamStatus == {:x}", stream_status);
     }
 
     clock::time_point t0 = clock::now();
 
     midi_bufs.swap();
 
+    // The input is only read by the engines, so it is processed in place
     int ref_count = 0;
-    auto in_buf = enable_input ? core::audio::AudioBufferHandle(in_data, nframes, ref_count)
-                               : Application::current().audio_manager->buffer_pool().allocate_clear();
-    // steal the inner midi buffer
+    auto in_buf = core::audio::AudioBufferHandle(enable_input ? in_data : silent_input_.data(), nframes, ref_count);
+    // steal the inner midi buffer. The output buffer is planar, so the master stage writes to it directly
     auto out = Application::current().engine_manager->process(
-      {in_buf, {std::move(midi_bufs.inner())}, core::clock::ClockRange{}});
+      {in_buf, {std::move(midi_bufs.inner())}, core::clock::ClockRange{}}, {out_data, out_data + nframes});
 
-    core::audio::validate_audio(out.audio[0]);
-    core::audio::validate_audio(out.audio[1]);
-
-    // process_audio_output(out);
-
-    LOGE_IF(out.nframes != nframes, "Frames went missing!");
-
-    // Separate channels
-    for (int i = 0; i < nframes; i++) {
-      out_data[i * 2] = out.audio[0][i];
-      out_data[i * 2 + 1] = out.audio[1][i];
-    }
+    RT_LOGE_IF(out.nframes != nframes, "Frames went missing!");
 
     if (midi_out) {
       for (auto& ev : out.midi) {
@@ -189,7 +184,7 @@ namespace otto::services {
 
     clock::time_point t1 = clock::now();
 
-    _cpu_time.add(std::chrono::nanoseconds(t1 - t0).count() / (1e9 / float(_samplerate) * nframes));
+    record_dsp_load(std::chrono::nanoseconds(t1 - t0).count() / (1e9 / float(_samplerate) * nframes));
 
     return 0;
   }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "util/enum.hpp"
 
 #include "core/ui/canvas.hpp"
@@ -16,16 +18,39 @@ namespace otto::board {
 
     void draw(core::ui::vg::Canvas& ctx) override;
 
+    /// Draw the static body, with all LEDs off and no keys pressed
+    ///
+    /// This only needs to be drawn once, so it can be cached in an image. Draw @ref draw_dynamic
+    /// on top of it.
+    void draw_body(core::ui::vg::Canvas& ctx);
+
+    /// Draw the LEDs which are on, and the keys which are pressed
+    void draw_dynamic(core::ui::vg::Canvas& ctx);
+
     void set_color(services::LED, services::LEDColor) override;
     void flush_leds() override;
     void clear_leds() override;
 
+    /// Check if the LEDs have changed since the last call
+    bool leds_changed() noexcept
+    {
+      return _leds_changed.exchange(false);
+    }
+
     void handle_click(core::ui::vg::Point p, ClickAction);
     void handle_scroll(core::ui::vg::Point p, float offset);
 
     constexpr static core::ui::vg::Size size = {1115, 352};
 
   private:
+    /// The parts drawn by the `draw_*` functions
+    enum struct Layer { all, body, dynamic };
+
+    void draw_layer(core::ui::vg::Canvas& ctx, Layer layer);
+    services::LEDColor led_color(core::input::Key key);
+    bool is_btn_pressed(core::input::Key key);
+    bool is_led_drawn(core::input::Key key);
+    bool is_btn_drawn(core::input::Key key);
 
     template<typename LEDFunc, typename BTNFunc>
     void draw_btn(core::ui::vg::Canvas& ctx, core::input::Key key, LEDFunc&& lf, BTNFunc&& bf);
@@ -41,6 +66,8 @@ namespace otto::board {
     void draw_encoders(core::ui::vg::Canvas& ctx);
 
     util::enum_map<core::input::Key, services::LEDColor> _led_colors = {};
+    std::atomic_bool _leds_changed = true;
+    Layer _layer = Layer::all;
   };
 
 }
@@ -10,6 +10,7 @@ namespace otto::board {
   void Emulator::set_color(LED led, LEDColor color)
   {
     _led_colors[led.key] = color;
+    _leds_changed = true;
   }
   void Emulator::flush_leds()
   {
@@ -20,53 +21,116 @@ namespace otto::board {
     for (auto& col : _led_colors) {
       col = LEDColor::Black;
     }
+    _leds_changed = true;
   }
 
   template<typename LEDFunc, typename BTNFunc>
   void Emulator::draw_btn(core::ui::vg::Canvas& ctx, Key key, LEDFunc&& lf, BTNFunc&& bf)
   {
-    auto c = _led_colors[key];
-    lf();
-    ctx.fill(Color::bytes(c.r, c.g, c.b));
+    if (is_led_drawn(key)) {
+      auto c = led_color(key);
+      lf();
+      ctx.fill(Color::bytes(c.r, c.g, c.b));
+    }
 
-    auto fill = is_pressed(key) ? Color::bytes(128, 128, 128) : Color::bytes(26, 26, 26);
-    ctx.lineWidth(1);
-    ctx.beginPath();
-    bf();
-    ctx.fill(fill);
-    ctx.stroke(Color::bytes(0, 0, 0));
+    if (is_btn_drawn(key)) {
+      auto fill = is_btn_pressed(key) ? Color::bytes(128, 128, 128) : Color::bytes(26, 26, 26);
+      ctx.lineWidth(1);
+      ctx.beginPath();
+      bf();
+      ctx.fill(fill);
+      ctx.stroke(Color::bytes(0, 0, 0));
+    }
   }
 
   template<typename BTNFunc, typename LEDFunc>
   void Emulator::draw_c_btn(core::ui::vg::Canvas& ctx, Key key, BTNFunc&& bf, LEDFunc&& lf)
   {
-    auto c = _led_colors[key];
-    lf();
-    ctx.fill(Color::bytes(c.r, c.g, c.b));
+    if (is_led_drawn(key)) {
+      auto c = led_color(key);
+      lf();
+      ctx.fill(Color::bytes(c.r, c.g, c.b));
+    }
 
-    auto fill = is_pressed(key) ? Color::bytes(128, 128, 128) : Color::bytes(26, 26, 26);
-    ctx.lineWidth(1);
-    bf();
-    ctx.fill(fill);
-    ctx.stroke(Color::bytes(0, 0, 0));
+    if (is_btn_drawn(key)) {
+      auto fill = is_btn_pressed(key) ? Color::bytes(128, 128, 128) : Color::bytes(26, 26, 26);
+      ctx.lineWidth(1);
+      bf();
+      ctx.fill(fill);
+      ctx.stroke(Color::bytes(0, 0, 0));
+    }
   }
 
   template<typename BTNFunc, typename LEDFunc>
   void Emulator::draw_s_btn(core::ui::vg::Canvas& ctx, Key key, BTNFunc&& bf, LEDFunc&& lf)
   {
+    if (is_led_drawn(key)) {
+      auto c = led_color(key);
+      lf();
+      ctx.fill(Color::bytes(c.r, c.g, c.b));
+    }
+
+    if (is_btn_drawn(key)) {
+      auto fill = is_btn_pressed(key) ? Color::bytes(108, 108, 108) : Color::bytes(255, 255, 255);
+      ctx.lineWidth(1);
+      bf();
+      ctx.fill(fill);
+      ctx.stroke(Color::bytes(179, 179, 179));
+    }
+  }
+
+  LEDColor Emulator::led_color(Key key)
+  {
+    if (_layer == Layer::body) return LEDColor::Black;
+    return _led_colors[key];
+  }
+
+  bool Emulator::is_btn_pressed(Key key)
+  {
+    return _layer != Layer::body && is_pressed(key);
+  }
+
+  bool Emulator::is_led_drawn(Key key)
+  {
+    if (_layer != Layer::dynamic) return true;
     auto c = _led_colors[key];
-    lf();
-    ctx.fill(Color::bytes(c.r, c.g, c.b));
+    return c.r != 0 || c.g != 0 || c.b != 0;
+  }
 
-    auto fill = is_pressed(key) ? Color::bytes(108, 108, 108) : Color::bytes(255, 255, 255);
-    ctx.lineWidth(1);
-    bf();
-    ctx.fill(fill);
-    ctx.stroke(Color::bytes(179, 179, 179));
+  bool Emulator::is_btn_drawn(Key key)
+  {
+    // The key is drawn on top of a lit LED again, since they may overlap
+    return _layer != Layer::dynamic || is_pressed(key) || is_led_drawn(key);
   }
 
   void Emulator::draw(Canvas& ctx)
   {
+    draw_layer(ctx, Layer::all);
+  }
+
+  void Emulator::draw_body(Canvas& ctx)
+  {
+    draw_layer(ctx, Layer::body);
+  }
+
+  void Emulator::draw_dynamic(Canvas& ctx)
+  {
+    draw_layer(ctx, Layer::dynamic);
+  }
+
+  void Emulator::draw_layer(Canvas& ctx, Layer layer)
+  {
+    _layer = layer;
+    if (layer == Layer::dynamic) {
+      // The draw_*_btn helpers skip the LEDs and keys which look the same as in the body
+      ctx.lineJoin(LineJoin::ROUND);
+      ctx.lineCap(LineCap::ROUND);
+      ctx.miterLimit(4);
+      draw_func_btns(ctx);
+      draw_sc_btns(ctx);
+      return;
+    }
+
     // #BKGRND
     ctx.lineJoin(LineJoin::ROUND);
     ctx.lineCap(LineCap::ROUND);
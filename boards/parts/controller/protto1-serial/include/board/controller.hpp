@@ -3,6 +3,7 @@
 #include <gsl/span>
 
 #include "util/locked.hpp"
+#include "util/reactor.hpp"
 #include "util/thread.hpp"
 
 #include "services/controller.hpp"
@@ -83,11 +84,15 @@ namespace otto::services {
 
     void handle_keyevent(Command cmd, BytesView args, bool do_send_midi);
 
-    util::Serial serial = {"/dev/ttyACM0", 10, 0};
+    util::Serial serial = {"/dev/ttyACM0", 0, 0};
     util::double_buffered<EventBag, util::clear_inner> events_;
     util::double_buffered<std::vector<std::uint8_t>, util::clear_outer> write_buffer_;
-    util::thread read_thread;
+    /// Only the LEDs which changed are sent to the MCU
+    LEDFramebuffer leds_;
     bool send_midi_ = true;
+    util::Reactor::LinkId serial_link_ = 0;
+    /// Reads and writes the links. Declared last, so its thread is stopped first
+    util::Reactor reactor_;
   };
 
 } // namespace otto::services
@@ -5,6 +5,7 @@
 #include "util/utility.hpp"
 
 #include "services/log_manager.hpp"
+#include "services/thread_policy.hpp"
 #include "services/ui_manager.hpp"
 #include "services/audio_manager.hpp"
 
@@ -110,18 +111,13 @@ namespace otto::services {
   }
 
   P1SC::PrOTTO1SerialController()
-    : read_thread([this](auto should_run) noexcept {
-        while (should_run()) {
-          serial.read_line()
-            .map([&](auto&& bytes) { handle_message(bytes); })
-            .map_error([&](auto&& error) {
-              if (error.data() != util::Serial::ErrorCode::empty_buffer) {
-                LOGE("Error reading serial data {}", error.what());
-              }
-            });
-        }
-      })
-  {}
+  {
+    serial_link_ = reactor_.add(serial.file_descriptor(), [this](auto frame, auto received) {
+      input_time_ = received;
+      handle_message(frame);
+    });
+    reactor_.start([] { ThreadPolicy::set_role(ThreadPolicy::Role::io); });
+  }
 
   std::unique_ptr<Controller> P1SC::make_or_dummy() {
     try {
@@ -143,21 +139,23 @@ namespace otto::services {
 
   void P1SC::set_color(LED led, LEDColor color)
   {
-    std::array<std::uint8_t, 6> msg = {0xEC, led.key._to_integral(), color.r, color.g, color.b,
-                                       '\n'};
-    queue_message(msg);
+    leds_.set(led, color);
   }
 
   void P1SC::flush_leds()
   {
+    leds_.take_changes([&](LED led, LEDColor color) {
+      std::array<std::uint8_t, 6> msg = {0xEC, led.key._to_integral(), color.r, color.g, color.b, '\n'};
+      queue_message(msg);
+    });
     write_buffer_.swap();
-    serial.write(write_buffer_.inner());
+    if (write_buffer_.inner().empty()) return;
+    reactor_.write(serial_link_, write_buffer_.inner());
   }
+
   void P1SC::clear_leds()
   {
-    auto c = LEDColor::Black;
-    std::array<std::uint8_t, 5> msg = {0xE0, c.r, c.g, c.b, '\n'};
-    queue_message(msg);
+    leds_.fill(LEDColor::Black);
   }
 
 } // namespace otto::services
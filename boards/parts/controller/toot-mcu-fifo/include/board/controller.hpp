@@ -3,6 +3,7 @@
 #include <gsl/span>
 
 #include "util/locked.hpp"
+#include "util/reactor.hpp"
 #include "util/thread.hpp"
 
 #include "services/controller.hpp"
@@ -86,8 +87,13 @@ namespace otto::services {
     util::FIFO fifo1 = {"/dev/toot-mcu-fifo1"};
     util::double_buffered<EventBag, util::clear_inner> events_;
     util::double_buffered<std::vector<std::uint8_t>, util::clear_outer> write_buffer_;
-    util::thread read_thread;
+    /// Only the LEDs which changed are sent to the MCU
+    LEDFramebuffer leds_;
     bool send_midi_ = true;
+    util::Reactor::LinkId read_link_ = 0;
+    util::Reactor::LinkId write_link_ = 0;
+    /// Reads and writes the links. Declared last, so its thread is stopped first
+    util::Reactor reactor_;
   };
 } // namespace otto::services
 
@@ -5,6 +5,7 @@
 #include "util/utility.hpp"
 
 #include "services/log_manager.hpp"
+#include "services/thread_policy.hpp"
 #include "services/ui_manager.hpp"
 
 namespace otto::services {
@@ -108,18 +109,14 @@ namespace otto::services {
   }
 
   TMFC::McuFifoController()
-    : read_thread([this](auto should_run) noexcept {
-        while (should_run()) {
-          fifo0.read_line()
-            .map([&](auto&& bytes) { handle_message(bytes); })
-            .map_error([&](auto&& error) {
-              if (error.data() != util::FIFO::ErrorCode::empty_buffer) {
-                LOGE("Error reading fifo data {}", error.what());
-              }
-            });
-        }
-      })
-  {}
+  {
+    read_link_ = reactor_.add(fifo0.file_descriptor(), [this](auto frame, auto received) {
+      input_time_ = received;
+      handle_message(frame);
+    });
+    write_link_ = reactor_.add(fifo1.file_descriptor());
+    reactor_.start([] { ThreadPolicy::set_role(ThreadPolicy::Role::io); });
+  }
 
   std::unique_ptr<Controller> TMFC::make_or_dummy() {
     try {
@@ -132,20 +129,23 @@ namespace otto::services {
 
   void TMFC::set_color(LED led, LEDColor color)
   {
-    std::array<std::uint8_t, 6> msg = {0xEC, led.key._to_integral(), color.r, color.g, color.b,
-                                       '\n'};
-    queue_message(msg);
+    leds_.set(led, color);
   }
+
   void TMFC::flush_leds()
   {
+    leds_.take_changes([&](LED led, LEDColor color) {
+      std::array<std::uint8_t, 6> msg = {0xEC, led.key._to_integral(), color.r, color.g, color.b, '\n'};
+      queue_message(msg);
+    });
     write_buffer_.swap();
-    fifo1.write(write_buffer_.inner());
+    if (write_buffer_.inner().empty()) return;
+    reactor_.write(write_link_, write_buffer_.inner());
   }
+
   void TMFC::clear_leds()
   {
-    auto c = LEDColor::Black;
-    std::array<std::uint8_t, 5> msg = {0xE0, c.r, c.g, c.b, '\n'};
-    queue_message(msg);
+    leds_.fill(LEDColor::Black);
   }
 
 } // namespace otto::services
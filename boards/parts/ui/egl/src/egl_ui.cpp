@@ -8,6 +8,7 @@
 
 #include "core/ui/canvas.hpp"
 #include "core/ui/vector_graphics.hpp"
+#include "services/thread_policy.hpp"
 #include "services/ui_manager.hpp"
 
 #define NANOVG_GLES2_IMPLEMENTATION
@@ -26,6 +27,7 @@ namespace otto::services {
 
   void EGLUIManager::main_ui_loop()
   {
+    ThreadPolicy::set_role(ThreadPolicy::Role::ui);
     EGLConnection egl;
     egl.init();
 #if OTTO_USE_FBCP
@@ -75,17 +77,23 @@ namespace otto::services {
 
 //    std::thread kbd_thread = std::thread([this] { read_keyboard(); });
 
+    // The UI logic and the LEDs are handled on their own thread. This thread only renders.
+    start_logic_thread(targetFPS);
+
     while (Application::current().running()) {
       t0 = clock::now();
 
-      Controller::current().flush_leds();
+      if (!has_new_frame()) {
+        std::this_thread::sleep_for(waitTime - (clock::now() - t0));
+        continue;
+      }
 
-      // Update and render
+      // Render the frame recorded by the logic thread
       egl.beginFrame();
       canvas.clearColor(vg::Colours::Black);
       canvas.beginFrame(egl.draw_size.width, egl.draw_size.height);
       canvas.scale(xscale, yscale);
-      draw_frame(canvas);
+      render_frame(canvas);
 
       if (showFps) {
         canvas.beginPath();
@@ -110,6 +118,7 @@ namespace otto::services {
       fps = one_second / ms;
     }
 
+    stop_logic_thread();
     nvgDeleteGLES2(nvg);
 
     egl.exit();
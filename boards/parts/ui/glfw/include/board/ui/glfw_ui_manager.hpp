@@ -7,6 +7,7 @@
 #include "core/ui/canvas.hpp"
 
 struct GLFWwindow;
+struct NVGLUframebuffer;
 namespace otto::glfw {
 
   using board::ui::Button;
@@ -46,6 +47,36 @@ namespace otto::glfw {
     GLFWwindow* _glfw_win;
   };
 
+  /// An offscreen framebuffer, which can be drawn on a canvas as an image
+  ///
+  /// Used to cache drawings which rarely change
+  struct OffscreenImage {
+    OffscreenImage(vg::Canvas& canvas);
+    ~OffscreenImage() noexcept;
+
+    OffscreenImage(const OffscreenImage&) = delete;
+    OffscreenImage& operator=(const OffscreenImage&) = delete;
+
+    /// False if the framebuffer could not be created
+    bool valid() const noexcept;
+
+    /// Render `draw` to the image, if its size changed
+    ///
+    /// Uses the canvas the image was created with. Must be called outside of a frame.
+    /// \param width, height the size in framebuffer pixels
+    /// \param scale the scale to draw with
+    void update(int width, int height, float scale, const std::function<void(vg::Canvas&)>& draw);
+
+    /// Draw the image stretched to `box`
+    void draw(vg::Canvas& ctx, vg::Box box);
+
+  private:
+    vg::Canvas& _canvas;
+    NVGLUframebuffer* _fb = nullptr;
+    int _width = 0;
+    int _height = 0;
+  };
+
   struct NVGWindow : Window {
     NVGWindow(int width, int height, const std::string& name);
     ~NVGWindow() noexcept;
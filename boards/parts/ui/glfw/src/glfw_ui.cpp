@@ -1,6 +1,7 @@
 #include "board/ui/glfw_ui_manager.hpp"
 
 #include <chrono>
+#include <cmath>
 #include <thread>
 #include <gsl/gsl_util>
 
@@ -9,6 +10,7 @@
 #include "core/ui/vector_graphics.hpp"
 
 #include "services/log_manager.hpp"
+#include "services/thread_policy.hpp"
 #include "services/ui_manager.hpp"
 
 #define NANOVG_GL3_IMPLEMENTATION
@@ -21,6 +23,7 @@
 #include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
 #include <nanovg_gl.h>
+#include <nanovg_gl_utils.h>
 
 #include "board/emulator.hpp"
 
@@ -155,6 +158,62 @@ namespace otto::glfw {
   }
 
 
+  OffscreenImage::OffscreenImage(vg::Canvas& canvas) : _canvas(canvas) {}
+
+  OffscreenImage::~OffscreenImage() noexcept
+  {
+    if (_fb) nvgluDeleteFramebuffer(_fb);
+  }
+
+  bool OffscreenImage::valid() const noexcept
+  {
+    return _fb != nullptr;
+  }
+
+  void OffscreenImage::update(int width, int height, float scale, const std::function<void(vg::Canvas&)>& draw)
+  {
+    // Also skipped if creating the framebuffer failed for this size
+    if (width == _width && height == _height) return;
+    _width = width;
+    _height = height;
+    if (_fb) nvgluDeleteFramebuffer(_fb);
+    // GL textures start at the bottom, and nanovg renders premultiplied alpha
+    _fb = nvgluCreateFramebuffer(_canvas.nvgContext(), width, height, NVG_IMAGE_FLIPY | NVG_IMAGE_PREMULTIPLIED);
+    if (!_fb) {
+      LOGW("Could not create an offscreen framebuffer of {}x{}", width, height);
+      return;
+    }
+
+    nvgluBindFramebuffer(_fb);
+    glViewport(0, 0, width, height);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    _canvas.setSize(width, height);
+    _canvas.beginFrame(width, height);
+    _canvas.scale(scale, scale);
+    draw(_canvas);
+    _canvas.endFrame();
+    nvgluBindFramebuffer(nullptr);
+  }
+
+  void OffscreenImage::draw(vg::Canvas& ctx, vg::Box box)
+  {
+    if (!_fb) return;
+    nvg::Paint pattern;
+    pattern.type = nvg::Paint::Type::ImagePattern;
+    pattern.imageID = _fb->image;
+    pattern.xx = box.x;
+    pattern.yy = box.y;
+    pattern.aa = box.width;
+    pattern.bb = box.height;
+    pattern.cc = 0;
+    pattern.dd = 1;
+    ctx.beginPath();
+    ctx.rect(box);
+    ctx.fillStyle(pattern);
+    ctx.fill();
+  }
+
   NVGWindow::NVGWindow(int width, int height, const std::string& name)
     : Window(width, height, name),
       _vg(OTTO_NVG_CREATE(NVG_ANTIALIAS | NVG_STENCIL_STROKES | NVG_DEBUG)),
@@ -213,6 +272,7 @@ namespace otto::services {
 
   void GLFWUIManager::main_ui_loop()
   {
+    ThreadPolicy::set_role(ThreadPolicy::Role::ui);
     glfwSetErrorCallback(error_callback);
 
     if (!glfwInit()) {
@@ -252,24 +312,58 @@ namespace otto::services {
 
     glfwSetTime(0);
 
+    // The body of the emulator is static. It is drawn to an image, and only drawn again on resize.
+    glfw::OffscreenImage emulator_body{main_win.canvas()};
+
+    // The UI logic and the LEDs are handled on their own thread. This thread only renders.
+    start_logic_thread(120);
+
     double t, spent;
+    auto last_window_size = main_win.window_size();
+    // Set when the window needs to be drawn again, without a new frame from the logic thread
+    bool redraw = true;
     while (!main_win.should_close() && Application::current().running()) {
 
       t = glfwGetTime();
 
-      auto [winWidth, winHeight] = main_win.window_size();
+      if (main_win.window_size() != last_window_size) redraw = true;
+      last_window_size = main_win.window_size();
+      auto [winWidth, winHeight] = last_window_size;
+      if (emulator && emulator->leds_changed()) redraw = true;
+
+      if (!redraw && !has_new_frame()) {
+        glfwPollEvents();
+        std::this_thread::sleep_for(std::chrono::milliseconds(int(1000 / 120 - (glfwGetTime() - t) * 1000)));
+        continue;
+      }
+      redraw = false;
+
       // Calculate pixel ration for hi-dpi devices.
+      scale = std::min((float) winWidth / (float) canvas_size.w, (float) winHeight / (float) canvas_size.h);
+
+      if (emulator) {
+        // The image is drawn one to one on the framebuffer, which is larger than the window on hi-dpi screens
+        auto [fbWidth, fbHeight] = main_win.framebuffer_size();
+        float px_ratio = winWidth > 0 ? (float) fbWidth / (float) winWidth : 1.f;
+        float body_scale = scale * px_ratio;
+        emulator_body.update(std::lround(canvas_size.w * body_scale), std::lround(canvas_size.h * body_scale),
+                             body_scale, [&](vg::Canvas& ctx) { emulator->draw_body(ctx); });
+      }
 
       main_win.begin_frame();
-      scale = std::min((float) winWidth / (float) canvas_size.w, (float) winHeight / (float) canvas_size.h);
       main_win.canvas().scale(scale, scale);
 
       if (emulator) {
-        emulator->draw(main_win.canvas());
+        if (emulator_body.valid()) {
+          emulator_body.draw(main_win.canvas(), {{0, 0}, canvas_size});
+          emulator->draw_dynamic(main_win.canvas());
+        } else {
+          emulator->draw(main_win.canvas());
+        }
         main_win.canvas().translate(518, 28);
         main_win.canvas().scale(215.f / 320.f, 161.f / 240.f);
       }
-      draw_frame(main_win.canvas());
+      render_frame(main_win.canvas());
 
       main_win.end_frame();
 
@@ -280,6 +374,7 @@ namespace otto::services {
       std::this_thread::sleep_for(std::chrono::milliseconds(int(1000 / 120 - spent * 1000)));
 
     }
+    stop_logic_thread();
   }
 } // namespace otto::services
 
@@ -4,3 +4,5 @@ otto_include_board(parts/controller/toot-mcu-fifo)
 set(CMAKE_LINKER_FLAGS_RELEASE "${CMAKE_LINKER_FLAGS_RELEASE} -ffast-math -funsafe-math-optimizations -mfpu=neon-vfpv4")
 set(CMAKE_CXX_FLAGS_RELEASE "${CMAKE_CXX_FLAGS_RELEASE} -ffast-math -funsafe-math-optimizations -mfpu=neon-vfpv4")
 add_compile_definitions("LOGURU_STACKTRACES=0")
+# The looper tape is kept in locked memory. Two tracks of two minutes take about 90 MiB
+add_compile_definitions("OTTO_LOOPER_TRACKS=2" "OTTO_LOOPER_SECONDS=120")
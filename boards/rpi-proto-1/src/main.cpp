@@ -1,5 +1,7 @@
 #include <csignal>
 
+#include <lyra/lyra.hpp>
+
 #include "core/audio/midi.hpp"
 
 #include "services/audio_manager.hpp"
@@ -7,6 +9,7 @@
 #include "services/log_manager.hpp"
 #include "services/preset_manager.hpp"
 #include "services/state_manager.hpp"
+#include "services/thread_policy.hpp"
 #include "services/ui_manager.hpp"
 #include "services/clock_manager.hpp"
 #include "services/controller.hpp"
@@ -36,6 +39,13 @@ int main(int argc, char* argv[])
       EngineManager::create_default
     };
 
+    auto cli = lyra::cli_parser();
+    ThreadPolicy::current().add_args(cli);
+
+    cli.parse({argc, argv});
+
+    ThreadPolicy::current().apply();
+
     Controller::current().register_key_handler(core::input::Key::settings, [] (auto) {
       if (Controller::current().is_pressed(core::input::Key::shift)) {
         Application::current().exit(Application::ErrorCode::user_exit);
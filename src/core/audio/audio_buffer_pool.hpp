@@ -153,7 +153,7 @@ namespace otto::core::audio {
 
   struct AudioBufferPool {
     static constexpr int number_of_buffers = 8;
-    AudioBufferPool(std::size_t buffer_size) : buffer_size(buffer_size)
+    AudioBufferPool(std::size_t buffer_size) : buffer_size(buffer_size), capacity(buffer_size)
     {
       // For now this is hardcoded, which is nice, cause we notice if we suddenly are using too many
       // buffers
@@ -165,11 +165,11 @@ namespace otto::core::audio {
       for (std::size_t i = 0; i < reference_counts.size(); i++) {
         if (reference_counts[i] < 1) {
           if (i > _max_val) {
-            LOGI("Using {} buffers", i + 1);
+            RT_LOGI("Using {} buffers", i + 1);
             _max_val = i;
           }
           reference_counts[i] = 0;
-          int index = i * buffer_size;
+          int index = i * capacity;
           return {data.get() + index, buffer_size, reference_counts[i]};
         }
       }
@@ -197,21 +197,37 @@ namespace otto::core::audio {
       return util::generate_array<NN>([this](int) { return allocate_clear(); });
     }
 
+    /// Set the size of the buffers handed out.
+    ///
+    /// Only allocates if `bs` is larger than the capacity, so this is safe to call from
+    /// the audio thread, as long as the capacity has been reserved with @ref reserve_buffer_size
     void set_buffer_size(std::size_t bs) noexcept
     {
+      if (bs > capacity) reserve_buffer_size(bs);
       buffer_size = bs;
+    }
+
+    /// Allocate room for buffers of up to `bs` samples.
+    ///
+    /// Invalidates all buffers. Must not be called while audio is being processed.
+    void reserve_buffer_size(std::size_t bs) noexcept
+    {
+      if (bs <= capacity) return;
+      capacity = bs;
       reserve(number_of_buffers);
     }
 
   private:
     void reserve(std::size_t n) noexcept
     {
-      data = std::make_unique<float[]>(n * buffer_size);
+      data = std::make_unique<float[]>(n * capacity);
       _avaliable_buffers = n;
       reference_counts.resize(_avaliable_buffers, 0);
     }
 
     std::size_t buffer_size;
+    /// The allocated size of each buffer
+    std::size_t capacity;
     std::vector<int> reference_counts;
     std::size_t _avaliable_buffers = 0;
     std::unique_ptr<float[]> data;
@@ -67,6 +67,24 @@ namespace otto::core::clock {
       OTTO_ASSERT(n > 0);
       return begin / n;
     }
+
+    /// The first multiple of n (plus offset) which is not before the beginning of the range.
+    ///
+    /// This may be after the end of the range. Check with @ref contains_multiple first.
+    Time first_multiple(Time n, Time offset = 0) const noexcept
+    {
+      OTTO_ASSERT(n > 0);
+      return (begin - offset - 1 + n) / n * n + offset;
+    }
+
+    /// The offset in samples of time `t`, when this range spans a buffer of `nframes` samples.
+    ///
+    /// Returns 0 for an empty range, i.e. when the clock is stopped.
+    int sample_offset(Time t, int nframes) const noexcept
+    {
+      if (end == begin) return 0;
+      return (t - begin) * nframes / (end - begin);
+    }
   };
 
   struct ClockCounter {
@@ -7,6 +7,7 @@
 
 #include "util/algorithm.hpp"
 #include "util/exception.hpp"
+#include "util/latency.hpp"
 
 #include "services/log_manager.hpp"
 #include "util/utility.hpp"
@@ -64,6 +65,11 @@ namespace otto::core::midi {
 
     int channel;
     int time;
+
+    /// When the event entered the system, at the controller or midi input
+    ///
+    /// Used to measure the key-to-sound latency. Default constructed if unknown.
+    util::latency_clock::time_point input_time = {};
   };
 
   struct NoteEvent : MidiEvent {
@@ -8,17 +8,17 @@ namespace otto::core::audio {
 #ifndef NDEBUG
     for (auto& frm : audio) {
       if (std::isnan(frm)) {
-        LOGE("ProcessData was constructed with a frame containing NAN");
+        RT_LOGE("ProcessData was constructed with a frame containing NAN");
       } else if (frm == INFINITY) {
-        LOGE("ProcessData was constructed with a frame containing INFINITY");
+        RT_LOGE("ProcessData was constructed with a frame containing INFINITY");
       } else if (frm == -INFINITY) {
-        LOGE("ProcessData was constructed with a frame containing -INFINITY");
+        RT_LOGE("ProcessData was constructed with a frame containing -INFINITY");
       } else {
         break;
       }
       // Set breakpoint here to catch error where it happens
       frm = 0;
-      LOGE("The frame was set to zero here, but will crash the audio service in release builds!");
+      RT_LOGE("The frame was set to zero here, but will crash the audio service in release builds!");
     }
 #endif
   }
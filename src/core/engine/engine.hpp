@@ -11,6 +11,7 @@
 #include "services/audio_manager.hpp"
 #include "services/ui_manager.hpp"
 #include "util/algorithm.hpp"
+#include "util/binary_serialize.hpp"
 #include "util/crtp.hpp"
 #include "util/exception.hpp"
 #include "util/jsonfile.hpp"
@@ -84,6 +85,7 @@ namespace otto::core::engine {
     ///
     /// \effects
     /// If a preset was set, apply it. Then deserialize the properties.
+    /// The resulting actions are pushed as one @ref itc::ActionTransaction.
     ///
     /// \see to_json
     ///
@@ -92,6 +94,18 @@ namespace otto::core::engine {
     /// [nlohmann::json::exception](), see it for details.
     virtual void from_json(const nlohmann::json& j) = 0;
 
+    /// Serialize the properties to `out` in the binary format
+    ///
+    /// Much cheaper than [to_json](), so it can be used for frequent snapshots.
+    ///
+    /// \see util::to_binary
+    virtual void to_binary(std::vector<std::uint8_t>& out) const = 0;
+
+    /// Deserialize the properties from the output of [to_binary]()
+    ///
+    /// \throws [util::exception]() if the data is invalid
+    virtual void from_binary(gsl::span<const std::uint8_t> data) = 0;
+
   private:
     int _current_preset = -1;
   };
@@ -153,8 +167,20 @@ namespace otto::core::engine {
       }
       void from_json(const nlohmann::json& j) override
       {
+        // Each prop pushes its own actions. Send them as one queue entry, so the audio thread
+        // never processes a buffer with only some of the props set.
+        itc::ActionTransaction transaction;
         util::deserialize(this->derived(), j);
       }
+      void to_binary(std::vector<std::uint8_t>& out) const override
+      {
+        util::to_binary(out, this->derived());
+      }
+      void from_binary(gsl::span<const std::uint8_t> data) override
+      {
+        itc::ActionTransaction transaction;
+        util::from_binary(this->derived(), data);
+      }
 
       static constexpr auto reflect_name()
       {
@@ -5,6 +5,7 @@
 
 #include "internal/property.hpp"
 #include "mixins/all.hpp"
+#include "util/binary_serialize.hpp"
 #include "util/serialize.hpp"
 
 /// The property system
@@ -78,6 +79,26 @@ namespace otto::core::props {
     prop.set(std::move(v));
   }
 
+  /// Serialize a property to binary
+  template<typename ValueType, typename TagList>
+  inline void serialize_binary(util::CborWriter& w, const PropertyImpl<ValueType, TagList>& prop)
+  {
+    using ::otto::util::serialize_binary;
+    serialize_binary(w, prop.get());
+  }
+
+  /// Deserialize a property from binary
+  template<typename ValueType, typename TagList>
+  inline void deserialize_binary(util::CborReader& r, PropertyImpl<ValueType, TagList>& prop)
+  {
+    using ::otto::util::deserialize_binary;
+    static_assert(std::is_default_constructible_v<ValueType>,
+                  "A property type must be default constructible to be deserializable");
+    ValueType v{};
+    deserialize_binary(r, v);
+    prop.set(std::move(v));
+  }
+
 
   template<typename ValueType, typename TagList>
   void to_json(nlohmann::json& j, PropertyImpl<ValueType, TagList>& t)
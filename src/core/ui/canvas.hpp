@@ -5,6 +5,8 @@
 #include <valarray>
 
 #include "nvg/Canvas.hpp"
+#include "nvg/DisplayList.hpp"
+#include "nvg/RecordingCanvas.hpp"
 
 #include "choreograph/Choreograph.h"
 
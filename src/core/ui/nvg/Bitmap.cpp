@@ -0,0 +1,219 @@
+#include "Bitmap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+#include "util/exception.hpp"
+
+namespace otto::nvg {
+
+  namespace {
+    constexpr std::array<std::uint8_t, 8> png_signature = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc = 0)
+    {
+      static const auto table = [] {
+        std::array<std::uint32_t, 256> res;
+        for (std::uint32_t n = 0; n < 256; n++) {
+          std::uint32_t c = n;
+          for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+          res[n] = c;
+        }
+        return res;
+      }();
+      crc = ~crc;
+      for (std::size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+      return ~crc;
+    }
+
+    std::uint32_t adler32(const std::vector<std::uint8_t>& data)
+    {
+      std::uint32_t a = 1, b = 0;
+      for (auto byte : data) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+      }
+      return (b << 16) | a;
+    }
+
+    void put_be32(std::vector<std::uint8_t>& out, std::uint32_t v)
+    {
+      for (int i = 3; i >= 0; i--) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+    }
+
+    std::uint32_t get_be32(const std::uint8_t* data)
+    {
+      return (std::uint32_t(data[0]) << 24) | (std::uint32_t(data[1]) << 16) | (std::uint32_t(data[2]) << 8) | data[3];
+    }
+
+    void put_chunk(std::vector<std::uint8_t>& out, std::string_view type, const std::vector<std::uint8_t>& data)
+    {
+      put_be32(out, data.size());
+      auto start = out.size();
+      out.insert(out.end(), type.begin(), type.end());
+      out.insert(out.end(), data.begin(), data.end());
+      put_be32(out, crc32(out.data() + start, out.size() - start));
+    }
+
+    /// Wrap `raw` in a zlib stream of stored (uncompressed) deflate blocks
+    std::vector<std::uint8_t> zlib_store(const std::vector<std::uint8_t>& raw)
+    {
+      constexpr std::size_t max_block = 0xFFFF;
+      std::vector<std::uint8_t> res = {0x78, 0x01};
+      res.reserve(raw.size() + raw.size() / max_block * 5 + 16);
+      std::size_t pos = 0;
+      do {
+        auto size = std::min(max_block, raw.size() - pos);
+        bool final = pos + size == raw.size();
+        res.push_back(final ? 1 : 0);
+        res.push_back(size & 0xFF);
+        res.push_back(size >> 8);
+        res.push_back(~size & 0xFF);
+        res.push_back((~size >> 8) & 0xFF);
+        res.insert(res.end(), raw.begin() + pos, raw.begin() + pos + size);
+        pos += size;
+      } while (pos < raw.size());
+      put_be32(res, adler32(raw));
+      return res;
+    }
+
+    /// Unwrap a zlib stream of stored deflate blocks
+    std::vector<std::uint8_t> zlib_unstore(const std::vector<std::uint8_t>& data)
+    {
+      if (data.size() < 2 || (data[0] & 0x0F) != 8) throw util::exception("Error: invalid zlib stream in PNG");
+      std::vector<std::uint8_t> res;
+      std::size_t pos = 2;
+      bool final = false;
+      while (!final) {
+        if (pos + 5 > data.size()) throw util::exception("Error: truncated zlib stream in PNG");
+        auto header = data[pos];
+        final = header & 1;
+        if ((header >> 1) != 0) throw util::exception("Error: compressed PNG files are not supported");
+        std::size_t size = data[pos + 1] | (data[pos + 2] << 8);
+        pos += 5;
+        if (pos + size > data.size()) throw util::exception("Error: truncated zlib stream in PNG");
+        res.insert(res.end(), data.begin() + pos, data.begin() + pos + size);
+        pos += size;
+      }
+      return res;
+    }
+  } // namespace
+
+  Bitmap::Bitmap(int width, int height, Color color) : width_(width), height_(height), data_(4 * width * height)
+  {
+    fill(color);
+  }
+
+  Color Bitmap::at(int x, int y) const noexcept
+  {
+    auto p = data_.data() + 4 * (y * width_ + x);
+    return Color(p[0], p[1], p[2], p[3]);
+  }
+
+  void Bitmap::fill(Color color) noexcept
+  {
+    for (std::size_t i = 0; i < data_.size(); i += 4) {
+      data_[i] = color.r;
+      data_[i + 1] = color.g;
+      data_[i + 2] = color.b;
+      data_[i + 3] = color.a;
+    }
+  }
+
+  int Bitmap::count_different_pixels(const Bitmap& other, int tolerance) const noexcept
+  {
+    if (width_ != other.width_ || height_ != other.height_) {
+      return std::max(width_ * height_, other.width_ * other.height_);
+    }
+    int res = 0;
+    for (std::size_t i = 0; i < data_.size(); i += 4) {
+      for (std::size_t c = 0; c < 4; c++) {
+        if (std::abs(data_[i + c] - other.data_[i + c]) > tolerance) {
+          res++;
+          break;
+        }
+      }
+    }
+    return res;
+  }
+
+  void Bitmap::write_png(const fs::path& path) const
+  {
+    std::vector<std::uint8_t> header;
+    put_be32(header, width_);
+    put_be32(header, height_);
+    // Bit depth 8, color type 6 (RGBA), default compression and filter method, no interlacing
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+
+    std::vector<std::uint8_t> raw;
+    raw.reserve((4 * width_ + 1) * height_);
+    for (int y = 0; y < height_; y++) {
+      // Filter type 0 (none)
+      raw.push_back(0);
+      auto row = data_.begin() + 4 * width_ * y;
+      raw.insert(raw.end(), row, row + 4 * width_);
+    }
+
+    std::vector<std::uint8_t> out(png_signature.begin(), png_signature.end());
+    put_chunk(out, "IHDR", header);
+    put_chunk(out, "IDAT", zlib_store(raw));
+    put_chunk(out, "IEND", {});
+
+    std::ofstream stream(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!stream) throw util::exception("Error: could not open {} for writing", path);
+    stream.write(reinterpret_cast<const char*>(out.data()), out.size());
+  }
+
+  Bitmap Bitmap::read_png(const fs::path& path)
+  {
+    std::ifstream stream(path.c_str(), std::ios::binary);
+    if (!stream) throw util::exception("Error: could not open {}", path);
+    std::vector<std::uint8_t> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    if (file.size() < png_signature.size() || !std::equal(png_signature.begin(), png_signature.end(), file.begin())) {
+      throw util::exception("Error: {} is not a PNG file", path);
+    }
+
+    Bitmap res;
+    std::vector<std::uint8_t> idat;
+    std::size_t pos = png_signature.size();
+    while (pos + 12 <= file.size()) {
+      std::size_t size = get_be32(&file[pos]);
+      std::string_view type(reinterpret_cast<const char*>(&file[pos + 4]), 4);
+      if (pos + 12 + size > file.size()) break;
+      auto data = &file[pos + 8];
+      if (type == "IHDR") {
+        if (size < 13 || data[8] != 8 || data[9] != 6 || data[12] != 0) {
+          throw util::exception("Error: {} is not an 8 bit RGBA PNG file", path);
+        }
+        res.width_ = get_be32(data);
+        res.height_ = get_be32(data + 4);
+      } else if (type == "IDAT") {
+        idat.insert(idat.end(), data, data + size);
+      } else if (type == "IEND") {
+        break;
+      }
+      pos += 12 + size;
+    }
+
+    auto raw = zlib_unstore(idat);
+    std::size_t stride = 4 * res.width_;
+    if (res.width_ <= 0 || raw.size() < (stride + 1) * res.height_) {
+      throw util::exception("Error: {} has missing image data", path);
+    }
+    res.data_.resize(stride * res.height_);
+    for (int y = 0; y < res.height_; y++) {
+      auto row = raw.begin() + (stride + 1) * y;
+      if (*row != 0) throw util::exception("Error: {} uses PNG filters, which are not supported", path);
+      std::copy(row + 1, row + 1 + stride, res.data_.begin() + stride * y);
+    }
+    return res;
+  }
+
+} // namespace otto::nvg
+
+// kak: other_file=Bitmap.hpp
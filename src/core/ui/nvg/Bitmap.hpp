@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Color.hpp"
+#include "util/filesystem.hpp"
+
+namespace otto::nvg {
+
+  /// An RGBA image in memory, with 8 bits per channel and straight (not premultiplied) alpha
+  ///
+  /// Rows are stored top to bottom, without padding.
+  struct Bitmap {
+    Bitmap() = default;
+    Bitmap(int width, int height, Color color = Color(0x000000FFU));
+
+    int width() const noexcept
+    {
+      return width_;
+    }
+
+    int height() const noexcept
+    {
+      return height_;
+    }
+
+    /// The pixel at `x`, `y`. Must be inside the bitmap.
+    Color at(int x, int y) const noexcept;
+
+    /// The first byte of the pixel at `x`, `y`
+    std::uint8_t* pixel(int x, int y) noexcept
+    {
+      return data_.data() + 4 * (y * width_ + x);
+    }
+
+    const std::uint8_t* data() const noexcept
+    {
+      return data_.data();
+    }
+
+    void fill(Color color) noexcept;
+
+    /// The number of pixels where any channel differs by more than `tolerance`
+    ///
+    /// If the sizes differ, all pixels of the larger bitmap are counted as different.
+    int count_different_pixels(const Bitmap& other, int tolerance = 0) const noexcept;
+
+    /// Write the bitmap as an 8 bit RGBA PNG file
+    ///
+    /// The image data is stored without compression, so no compression library is needed. The
+    /// files are larger than they could be, but are read by any PNG viewer.
+    void write_png(const fs::path& path) const;
+
+    /// Read a PNG file written by @ref write_png
+    ///
+    /// Only uncompressed 8 bit RGBA files are supported.
+    /// \throws @ref util::exception if the file can't be read, or is in another format
+    static Bitmap read_png(const fs::path& path);
+
+  private:
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<std::uint8_t> data_;
+  };
+
+} // namespace otto::nvg
+
+// kak: other_file=Bitmap.cpp
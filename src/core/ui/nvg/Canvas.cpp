@@ -1,4 +1,5 @@
 #include "Canvas.hpp"
+#include "DisplayList.hpp"
 
 #include <nanovg.h>
 
@@ -66,12 +67,14 @@ namespace otto::nvg {
 
   Canvas& Canvas::globalAlpha(float alpha)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::globalAlpha, {alpha});
     nvgGlobalAlpha(m_nvgCtx, alpha);
     return *this;
   }
 
   Canvas& Canvas::lineCap(LineCap cap)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::lineCap, {float(cap)});
     int nvgCap = NVG_BUTT;
     if (cap == LineCap::SQUARE)
       nvgCap = NVG_SQUARE;
@@ -83,6 +86,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::lineJoin(LineJoin join)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::lineJoin, {float(join)});
     int nvgJoin = NVG_BEVEL;
     if (join == LineJoin::ROUND)
       nvgJoin = NVG_ROUND;
@@ -94,12 +98,14 @@ namespace otto::nvg {
 
   Canvas& Canvas::lineWidth(float width)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::lineWidth, {width});
     nvgStrokeWidth(m_nvgCtx, width);
     return *this;
   }
 
   Canvas& Canvas::miterLimit(float limit)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::miterLimit, {limit});
     nvgMiterLimit(m_nvgCtx, limit);
     return *this;
   }
@@ -107,6 +113,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::fillStyle(const Color& color)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::fillColor, color);
     nvgFillColor(m_nvgCtx, nvgRGBA(color.r, color.g, color.b, color.a));
     return *this;
   }
@@ -114,6 +121,7 @@ namespace otto::nvg {
   Canvas& Canvas::fillStyle(const Paint& paint)
   {
     if (paint.type != Paint::Type::None) {
+      if (m_recording) m_recording->push(DisplayList::Op::fillPaint, paint);
       NVGpaint npaint = nvgPaint(*this, paint);
       nvgFillPaint(m_nvgCtx, npaint);
     }
@@ -123,6 +131,7 @@ namespace otto::nvg {
   Canvas& Canvas::strokeStyle(const Paint& paint)
   {
     if (paint.type != Paint::Type::None) {
+      if (m_recording) m_recording->push(DisplayList::Op::strokePaint, paint);
       NVGpaint npaint = nvgPaint(*this, paint);
       nvgStrokePaint(m_nvgCtx, npaint);
     }
@@ -131,6 +140,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::strokeStyle(const Color& color)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::strokeColor, color);
     nvgStrokeColor(m_nvgCtx, nvgRGBA(color.r, color.g, color.b, color.a));
     return *this;
   }
@@ -192,18 +202,21 @@ namespace otto::nvg {
 
   Canvas& Canvas::font(const Font& font)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::fontFace, {float(font.face)});
     if (font.valid()) nvgFontFaceId(m_nvgCtx, font.face);
     return *this;
   }
 
   Canvas& Canvas::font(float size)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::fontSize, {size});
     nvgFontSize(m_nvgCtx, size);
     return *this;
   }
 
   Canvas& Canvas::textAlign(HorizontalAlign hAlign, VerticalAlign vAlign)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::textAlign, {float(hAlign), float(vAlign)});
     nvgTextAlign(m_nvgCtx, hAlign | vAlign);
     return *this;
   }
@@ -220,6 +233,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::fillStyle(const TextStyle& textStyle)
   {
+    if (m_recording) m_recording->push(textStyle);
     applyTextStyle(*this, textStyle);
     nvgFillColor(m_nvgCtx, nvgColor(textStyle.color));
     return *this;
@@ -252,6 +266,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::globalCompositeOperation(CompositeOperation op)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::compositeOperation, {float(op)});
     auto nvgOp = [&] {
       switch (op) {
         case CompositeOperation::SOURCE_OVER: return NVG_SOURCE_OVER;
@@ -276,6 +291,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::moveTo(float x, float y)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::moveTo, {x, y});
     local2Global(x, y);
     nvgMoveTo(m_nvgCtx, x, y);
     return *this;
@@ -283,6 +299,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::lineTo(float x, float y)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::lineTo, {x, y});
     local2Global(x, y);
     nvgLineTo(m_nvgCtx, x, y);
     return *this;
@@ -290,6 +307,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::arcTo(float x1, float y1, float x2, float y2, float r)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::arcTo, {x1, y1, x2, y2, r});
     local2Global(x1, y1);
     local2Global(x2, y2);
     nvgArcTo(m_nvgCtx, x1, y1, x2, y2, r);
@@ -298,6 +316,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::quadraticCurveTo(float cpx, float cpy, float x, float y)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::quadTo, {cpx, cpy, x, y});
     local2Global(cpx, cpy);
     local2Global(x, y);
     nvgQuadTo(m_nvgCtx, cpx, cpy, x, y);
@@ -306,6 +325,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::bezierCurveTo(float cp1x, float cp1y, float cp2x, float cp2y, float x, float y)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::bezierTo, {cp1x, cp1y, cp2x, cp2y, x, y});
     local2Global(cp1x, cp1y);
     local2Global(cp2x, cp2y);
     local2Global(x, y);
@@ -315,6 +335,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::arc(float x, float y, float r, float sAngle, float eAngle, bool counterclockwise)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::arc, {x, y, r, sAngle, eAngle, float(counterclockwise)});
     local2Global(x, y);
     int dir = counterclockwise ? NVG_CCW : NVG_CW;
     nvgArc(m_nvgCtx, x, y, r, sAngle, eAngle, dir);
@@ -324,6 +345,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::closePath()
   {
+    if (m_recording) m_recording->push(DisplayList::Op::closePath);
     nvgClosePath(m_nvgCtx);
     return *this;
   }
@@ -334,6 +356,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::rect(float x, float y, float w, float h)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::rect, {x, y, w, h});
     local2Global(x, y);
     nvgRect(m_nvgCtx, x, y, w, h);
     return *this;
@@ -341,6 +364,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::roundedRect(float x, float y, float w, float h, float r)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::roundedRect, {x, y, w, h, r});
     local2Global(x, y);
     nvgRoundedRect(m_nvgCtx, x, y, w, h, r);
     return *this;
@@ -348,6 +372,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::circle(float cx, float cy, float r)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::circle, {cx, cy, r});
     local2Global(cx, cy);
     nvgCircle(m_nvgCtx, cx, cy, r);
     return *this;
@@ -355,6 +380,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::ellipse(float cx, float cy, float rx, float ry)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::ellipse, {cx, cy, rx, ry});
     local2Global(cx, cy);
     nvgEllipse(m_nvgCtx, cx, cy, rx, ry);
     return *this;
@@ -364,18 +390,21 @@ namespace otto::nvg {
 
   Canvas& Canvas::fill()
   {
+    if (m_recording) m_recording->push(DisplayList::Op::fill);
     nvgFill(m_nvgCtx);
     return *this;
   }
 
   Canvas& Canvas::stroke()
   {
+    if (m_recording) m_recording->push(DisplayList::Op::stroke);
     nvgStroke(m_nvgCtx);
     return *this;
   }
 
   Canvas& Canvas::fillRect(float x, float y, float w, float h)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::fillRect, {x, y, w, h});
     local2Global(x, y);
     nvgBeginPath(m_nvgCtx);
     nvgRect(m_nvgCtx, x, y, w, h);
@@ -385,6 +414,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::strokeRect(float x, float y, float w, float h)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::strokeRect, {x, y, w, h});
     local2Global(x, y);
     nvgBeginPath(m_nvgCtx);
     nvgRect(m_nvgCtx, x, y, w, h);
@@ -406,6 +436,7 @@ namespace otto::nvg {
   Canvas& Canvas::fillText(util::string_ref text, float x, float y, float rowWidth)
   {
     if (text.length()) {
+      if (m_recording) m_recording->push(text, x, y, rowWidth);
       local2Global(x, y);
       if (std::isnan(rowWidth))
         nvgText(m_nvgCtx, x, y, text.c_str(), nullptr);
@@ -460,18 +491,21 @@ namespace otto::nvg {
 
   Canvas& Canvas::save()
   {
+    if (m_recording) m_recording->push(DisplayList::Op::save);
     nvgSave(m_nvgCtx);
     return *this;
   }
 
   Canvas& Canvas::restore()
   {
+    if (m_recording) m_recording->push(DisplayList::Op::restore);
     nvgRestore(m_nvgCtx);
     return *this;
   }
 
   Canvas& Canvas::reset()
   {
+    if (m_recording) m_recording->push(DisplayList::Op::reset);
     nvgReset(m_nvgCtx);
     return *this;
   }
@@ -480,30 +514,35 @@ namespace otto::nvg {
 
   Canvas& Canvas::scale(float scalewidth, float scaleheight)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::scale, {scalewidth, scaleheight});
     nvgScale(m_nvgCtx, scalewidth, scaleheight);
     return *this;
   }
 
   Canvas& Canvas::rotate(float angle)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::rotate, {angle});
     nvgRotate(m_nvgCtx, angle);
     return *this;
   }
 
   Canvas& Canvas::translate(float x, float y)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::translate, {x, y});
     nvgTranslate(m_nvgCtx, x, y);
     return *this;
   }
 
   Canvas& Canvas::transform(float a, float b, float c, float d, float e, float f)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::transform, {a, b, c, d, e, f});
     nvgTransform(m_nvgCtx, a, b, c, d, e, f);
     return *this;
   }
 
   Canvas& Canvas::setTransform(float a, float b, float c, float d, float e, float f)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::setTransform, {a, b, c, d, e, f});
     nvgResetTransform(m_nvgCtx);
     nvgTransform(m_nvgCtx, a, b, c, d, e, f);
     return *this;
@@ -511,6 +550,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::restTransform()
   {
+    if (m_recording) m_recording->push(DisplayList::Op::resetTransform);
     nvgResetTransform(m_nvgCtx);
     return *this;
   }
@@ -538,12 +578,14 @@ namespace otto::nvg {
 
   Canvas& Canvas::beginPath()
   {
+    if (m_recording) m_recording->push(DisplayList::Op::beginPath);
     nvgBeginPath(m_nvgCtx);
     return *this;
   }
 
   Canvas& Canvas::pathWinding(Winding dir)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::pathWinding, {float(dir)});
     int windingDir = NVG_CW;
     if (dir == Winding::CCW) windingDir = NVG_CCW;
     nvgPathWinding(m_nvgCtx, windingDir);
@@ -552,6 +594,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::clip(float x, float y, float w, float h)
   {
+    if (m_recording) m_recording->push(DisplayList::Op::clip, {x, y, w, h});
     local2Global(x, y);
     nvgIntersectScissor(m_nvgCtx, x, y, w, h);
     return *this;
@@ -559,6 +602,7 @@ namespace otto::nvg {
 
   Canvas& Canvas::resetClip()
   {
+    if (m_recording) m_recording->push(DisplayList::Op::resetClip);
     nvgResetScissor(m_nvgCtx);
     return *this;
   }
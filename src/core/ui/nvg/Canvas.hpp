@@ -16,6 +16,7 @@ namespace otto::nvg {
   using namespace TextAlign;
 
   struct Canvas; // FWDCL
+  struct DisplayList; // FWDCL
 
   /// Anything that can be drawn on screen.
   ///
@@ -379,6 +380,15 @@ namespace otto::nvg {
     template<typename FuncRef, typename = std::enable_if_t<std::is_invocable_v<FuncRef>>>
     Canvas& drawAt(Point p, FuncRef&& f);
 
+    /// Call `func`, and record the commands it draws into `list`
+    ///
+    /// The commands are drawn as usual while recording. `list` is cleared first. Recordings can be
+    /// nested, the outer list also gets the commands recorded into the inner one.
+    ///
+    /// Defined in DisplayList.hpp
+    template<typename FuncRef>
+    Canvas& record(DisplayList& list, FuncRef&& func);
+
     template<typename It>
     Canvas& plotBezier(It pointB, It pointE, float f = 0.5, float t = 1);
 
@@ -905,6 +915,8 @@ namespace otto::nvg {
     float m_xPos;
     /// The y-coordinate of the canvas in window
     float m_yPos;
+    /// The display list being recorded, if any
+    DisplayList* m_recording = nullptr;
   };
 
   // Template definitions
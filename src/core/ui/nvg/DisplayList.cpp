@@ -0,0 +1,181 @@
+#include "DisplayList.hpp"
+
+#include <cstring>
+
+namespace otto::nvg {
+
+  void DisplayList::push(Op op, std::initializer_list<float> args)
+  {
+    ops_.push_back(op);
+    args_.insert(args_.end(), args.begin(), args.end());
+  }
+
+  void DisplayList::push(Op op, const Color& color)
+  {
+    ops_.push_back(op);
+    colors_.push_back(color);
+  }
+
+  void DisplayList::push(Op op, const Paint& paint)
+  {
+    ops_.push_back(op);
+    paints_.push_back(paint);
+  }
+
+  void DisplayList::push(const TextStyle& style)
+  {
+    ops_.push_back(Op::textStyle);
+    text_styles_.push_back(style);
+  }
+
+  void DisplayList::push(util::string_ref text, float x, float y, float rowWidth)
+  {
+    push(Op::text, {x, y, rowWidth});
+    strings_.append(text.begin(), text.end());
+    strings_.push_back('\0');
+  }
+
+  void DisplayList::append(const DisplayList& other)
+  {
+    ops_.insert(ops_.end(), other.ops_.begin(), other.ops_.end());
+    args_.insert(args_.end(), other.args_.begin(), other.args_.end());
+    colors_.insert(colors_.end(), other.colors_.begin(), other.colors_.end());
+    paints_.insert(paints_.end(), other.paints_.begin(), other.paints_.end());
+    text_styles_.insert(text_styles_.end(), other.text_styles_.begin(), other.text_styles_.end());
+    strings_.append(other.strings_);
+  }
+
+  void DisplayList::clear() noexcept
+  {
+    ops_.clear();
+    args_.clear();
+    colors_.clear();
+    paints_.clear();
+    text_styles_.clear();
+    strings_.clear();
+  }
+
+  void DisplayList::replay(Canvas& ctx) const
+  {
+    // Every op consumes its data from the front of the matching buffer, in the order they were pushed
+    auto arg = args_.begin();
+    auto color = colors_.begin();
+    auto paint = paints_.begin();
+    auto text_style = text_styles_.begin();
+    const char* string = strings_.c_str();
+    auto next = [&arg] { return *arg++; };
+
+    for (Op op : ops_) {
+      switch (op) {
+        case Op::globalAlpha: ctx.globalAlpha(next()); break;
+        case Op::lineCap: ctx.lineCap(static_cast<LineCap>(next())); break;
+        case Op::lineJoin: ctx.lineJoin(static_cast<LineJoin>(next())); break;
+        case Op::lineWidth: ctx.lineWidth(next()); break;
+        case Op::miterLimit: ctx.miterLimit(next()); break;
+        case Op::fillColor: ctx.fillStyle(*color++); break;
+        case Op::fillPaint: ctx.fillStyle(*paint++); break;
+        case Op::strokeColor: ctx.strokeStyle(*color++); break;
+        case Op::strokePaint: ctx.strokeStyle(*paint++); break;
+        case Op::fontFace: {
+          Font font;
+          font.face = static_cast<int>(next());
+          ctx.font(font);
+        } break;
+        case Op::fontSize: ctx.font(next()); break;
+        case Op::textAlign: {
+          auto h = static_cast<HorizontalAlign>(next());
+          auto v = static_cast<VerticalAlign>(next());
+          ctx.textAlign(h, v);
+        } break;
+        case Op::textStyle: ctx.fillStyle(*text_style++); break;
+        case Op::compositeOperation: ctx.globalCompositeOperation(static_cast<CompositeOperation>(next())); break;
+        case Op::moveTo: {
+          float x = next(), y = next();
+          ctx.moveTo(x, y);
+        } break;
+        case Op::lineTo: {
+          float x = next(), y = next();
+          ctx.lineTo(x, y);
+        } break;
+        case Op::arcTo: {
+          float x1 = next(), y1 = next(), x2 = next(), y2 = next(), r = next();
+          ctx.arcTo(x1, y1, x2, y2, r);
+        } break;
+        case Op::quadTo: {
+          float cpx = next(), cpy = next(), x = next(), y = next();
+          ctx.quadraticCurveTo(cpx, cpy, x, y);
+        } break;
+        case Op::bezierTo: {
+          float cp1x = next(), cp1y = next(), cp2x = next(), cp2y = next(), x = next(), y = next();
+          ctx.bezierCurveTo(cp1x, cp1y, cp2x, cp2y, x, y);
+        } break;
+        case Op::arc: {
+          float x = next(), y = next(), r = next(), s = next(), e = next();
+          bool ccw = next() != 0;
+          ctx.arc(x, y, r, s, e, ccw);
+        } break;
+        case Op::closePath: ctx.closePath(); break;
+        case Op::rect: {
+          float x = next(), y = next(), w = next(), h = next();
+          ctx.rect(x, y, w, h);
+        } break;
+        case Op::roundedRect: {
+          float x = next(), y = next(), w = next(), h = next(), r = next();
+          ctx.roundedRect(x, y, w, h, r);
+        } break;
+        case Op::circle: {
+          float cx = next(), cy = next(), r = next();
+          ctx.circle(cx, cy, r);
+        } break;
+        case Op::ellipse: {
+          float cx = next(), cy = next(), rx = next(), ry = next();
+          ctx.ellipse(cx, cy, rx, ry);
+        } break;
+        case Op::fill: ctx.fill(); break;
+        case Op::stroke: ctx.stroke(); break;
+        case Op::fillRect: {
+          float x = next(), y = next(), w = next(), h = next();
+          ctx.fillRect(x, y, w, h);
+        } break;
+        case Op::strokeRect: {
+          float x = next(), y = next(), w = next(), h = next();
+          ctx.strokeRect(x, y, w, h);
+        } break;
+        case Op::text: {
+          float x = next(), y = next(), row_width = next();
+          ctx.fillText(string, x, y, row_width);
+          string += std::strlen(string) + 1;
+        } break;
+        case Op::save: ctx.save(); break;
+        case Op::restore: ctx.restore(); break;
+        case Op::reset: ctx.reset(); break;
+        case Op::scale: {
+          float x = next(), y = next();
+          ctx.scale(x, y);
+        } break;
+        case Op::rotate: ctx.rotate(next()); break;
+        case Op::translate: {
+          float x = next(), y = next();
+          ctx.translate(x, y);
+        } break;
+        case Op::transform: [[fallthrough]];
+        case Op::setTransform: {
+          float a = next(), b = next(), c = next(), d = next(), e = next(), f = next();
+          if (op == Op::transform) ctx.transform(a, b, c, d, e, f);
+          else ctx.setTransform(a, b, c, d, e, f);
+        } break;
+        case Op::resetTransform: ctx.restTransform(); break;
+        case Op::beginPath: ctx.beginPath(); break;
+        case Op::pathWinding: ctx.pathWinding(static_cast<Winding>(next())); break;
+        case Op::clip: {
+          float x = next(), y = next(), w = next(), h = next();
+          ctx.clip(x, y, w, h);
+        } break;
+        case Op::resetClip: ctx.resetClip(); break;
+      }
+    }
+  }
+
+} // namespace otto::nvg
+
+// kak: other_file=DisplayList.hpp
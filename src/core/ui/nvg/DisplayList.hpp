@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Canvas.hpp"
+
+namespace otto::nvg {
+
+  /// A recorded sequence of draw commands, which can be replayed on a @ref Canvas
+  ///
+  /// Record a list with @ref Canvas::record. The commands are stored compactly, as one opcode and a
+  /// few floats each, in the local coordinates they were given in. Replaying calls the same
+  /// @ref Canvas methods again, so a list drawn under a different transform is drawn transformed.
+  ///
+  /// Only the draw commands are recorded, not the computations that produced them. Replaying a list
+  /// is cheap compared to running a screen's draw code, which looks up props, formats strings and
+  /// builds paths point by point.
+  ///
+  /// Images and fonts are referenced by their NanoVG id, so they must outlive the list.
+  struct DisplayList {
+    /// Replay the recorded commands on `ctx`
+    void replay(Canvas& ctx) const;
+
+    /// Append the commands from another list
+    void append(const DisplayList& other);
+
+    void clear() noexcept;
+
+    bool empty() const noexcept
+    {
+      return ops_.empty();
+    }
+
+    /// The number of recorded commands
+    std::size_t size() const noexcept
+    {
+      return ops_.size();
+    }
+
+  private:
+    friend Canvas;
+
+    enum struct Op : std::uint8_t {
+      globalAlpha,
+      lineCap,
+      lineJoin,
+      lineWidth,
+      miterLimit,
+      fillColor,
+      fillPaint,
+      strokeColor,
+      strokePaint,
+      fontFace,
+      fontSize,
+      textAlign,
+      textStyle,
+      compositeOperation,
+      moveTo,
+      lineTo,
+      arcTo,
+      quadTo,
+      bezierTo,
+      arc,
+      closePath,
+      rect,
+      roundedRect,
+      circle,
+      ellipse,
+      fill,
+      stroke,
+      fillRect,
+      strokeRect,
+      text,
+      save,
+      restore,
+      reset,
+      scale,
+      rotate,
+      translate,
+      transform,
+      setTransform,
+      resetTransform,
+      beginPath,
+      pathWinding,
+      clip,
+      resetClip,
+    };
+
+    void push(Op op, std::initializer_list<float> args = {});
+    void push(Op op, const Color& color);
+    void push(Op op, const Paint& paint);
+    void push(const TextStyle& style);
+    void push(util::string_ref text, float x, float y, float rowWidth);
+
+    std::vector<Op> ops_;
+    std::vector<float> args_;
+    std::vector<Color> colors_;
+    std::vector<Paint> paints_;
+    std::vector<TextStyle> text_styles_;
+    /// Null terminated strings for @ref Op::text
+    std::string strings_;
+  };
+
+  /// A display list which is recorded again when its inputs change
+  ///
+  /// Keep one per screen or widget, for the parts of it that only depend on a few values:
+  ///
+  /// ```cpp
+  /// background_.draw(ctx, [&] { draw_background(ctx); }, shift, cur_op);
+  /// ```
+  ///
+  /// The first time, and whenever `shift` or `cur_op` changed since the last call, the function is
+  /// called, and recorded while it draws. Otherwise the recorded list is replayed instead.
+  /// Anything the function draws which is not derived from the inputs must not change.
+  struct CachedDrawing {
+    template<typename FuncRef, typename... Inputs>
+    Canvas& draw(Canvas& ctx, FuncRef&& f, const Inputs&... inputs);
+
+    /// Record the list again on the next call to @ref draw
+    void invalidate() noexcept
+    {
+      valid_ = false;
+    }
+
+  private:
+    DisplayList list_;
+    std::size_t key_ = 0;
+    bool valid_ = false;
+  };
+
+  // Template definitions
+
+  template<typename FuncRef>
+  Canvas& Canvas::record(DisplayList& list, FuncRef&& f)
+  {
+    list.clear();
+    DisplayList* outer = std::exchange(m_recording, &list);
+    f();
+    m_recording = outer;
+    if (outer) outer->append(list);
+    return *this;
+  }
+
+  template<typename FuncRef, typename... Inputs>
+  Canvas& CachedDrawing::draw(Canvas& ctx, FuncRef&& f, const Inputs&... inputs)
+  {
+    std::size_t key = 0;
+    ((key ^= std::hash<Inputs>()(inputs) + 0x9e3779b9 + (key << 6) + (key >> 2)), ...);
+    if (valid_ && key == key_) {
+      list_.replay(ctx);
+    } else {
+      ctx.record(list_, std::forward<FuncRef>(f));
+      key_ = key;
+      valid_ = true;
+    }
+    return ctx;
+  }
+
+} // namespace otto::nvg
+
+// kak: other_file=DisplayList.cpp
@@ -0,0 +1,53 @@
+#include "RecordingCanvas.hpp"
+
+#include <atomic>
+
+#include <nanovg.h>
+
+#include "util/exception.hpp"
+
+namespace otto::nvg {
+
+  namespace {
+    /// A NanoVG renderer which discards everything
+    ///
+    /// Textures are never sampled, so only their ids are handed out. NanoVG needs one for its
+    /// font atlas.
+    NVGcontext* create_null_context()
+    {
+      static std::atomic_int next_texture = 1;
+      NVGparams params = {};
+      params.edgeAntiAlias = 0;
+      params.renderCreate = [](void*) { return 1; };
+      params.renderCreateTexture = [](void*, int, int, int, int, const unsigned char*) { return next_texture++; };
+      params.renderDeleteTexture = [](void*, int) { return 1; };
+      params.renderUpdateTexture = [](void*, int, int, int, int, int, const unsigned char*) { return 1; };
+      params.renderGetTextureSize = [](void*, int, int*, int*) { return 0; };
+      params.renderViewport = [](void*, float, float, float) {};
+      params.renderCancel = [](void*) {};
+      params.renderFlush = [](void*) {};
+      params.renderFill = [](void*, NVGpaint*, NVGcompositeOperationState, NVGscissor*, float, const float*,
+                             const NVGpath*, int) {};
+      params.renderStroke = [](void*, NVGpaint*, NVGcompositeOperationState, NVGscissor*, float, float,
+                               const NVGpath*, int) {};
+      params.renderTriangles = [](void*, NVGpaint*, NVGcompositeOperationState, NVGscissor*, const NVGvertex*,
+                                  int, float) {};
+      params.renderDelete = [](void*) {};
+      auto res = nvgCreateInternal(&params);
+      if (!res) throw util::exception("Error: could not create the recording NanoVG context");
+      return res;
+    }
+  } // namespace
+
+  RecordingCanvas::RecordingCanvas(float width, float height)
+    : nvg_(create_null_context()), canvas_(nvg_, width, height)
+  {}
+
+  RecordingCanvas::~RecordingCanvas() noexcept
+  {
+    nvgDeleteInternal(nvg_);
+  }
+
+} // namespace otto::nvg
+
+// kak: other_file=RecordingCanvas.hpp
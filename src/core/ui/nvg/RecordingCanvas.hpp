@@ -0,0 +1,47 @@
+#pragma once
+
+#include "DisplayList.hpp"
+
+namespace otto::nvg {
+
+  /// A @ref Canvas which records into a @ref DisplayList, and does not draw anything
+  ///
+  /// It has its own NanoVG context, with a renderer that discards everything, so it does not need
+  /// a GPU, and can be used on another thread than the one drawing. The recorded list is then
+  /// replayed on the canvas of the display.
+  ///
+  /// No fonts are loaded into the context, so text can not be measured while recording. Fonts and
+  /// images are recorded by id, and must be loaded into the canvas the list is replayed on.
+  struct RecordingCanvas {
+    RecordingCanvas(float width, float height);
+    ~RecordingCanvas() noexcept;
+
+    RecordingCanvas(const RecordingCanvas&) = delete;
+    RecordingCanvas& operator=(const RecordingCanvas&) = delete;
+
+    Canvas& canvas() noexcept
+    {
+      return canvas_;
+    }
+
+    /// Record a frame, drawn by `f(canvas())`, into `list`
+    template<typename FuncRef>
+    void record_frame(DisplayList& list, FuncRef&& f);
+
+  private:
+    NVGcontext* nvg_;
+    Canvas canvas_;
+  };
+
+  template<typename FuncRef>
+  void RecordingCanvas::record_frame(DisplayList& list, FuncRef&& f)
+  {
+    auto size = canvas_.size();
+    canvas_.beginFrame(size.w, size.h);
+    canvas_.record(list, [&] { f(canvas_); });
+    canvas_.cancelFrame();
+  }
+
+} // namespace otto::nvg
+
+// kak: other_file=RecordingCanvas.cpp
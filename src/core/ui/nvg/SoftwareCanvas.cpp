@@ -0,0 +1,440 @@
+#include "SoftwareCanvas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <nanovg.h>
+
+#include "util/exception.hpp"
+
+namespace otto::nvg {
+
+  namespace {
+    struct Texture {
+      int type = 0;
+      int width = 0;
+      int height = 0;
+      int flags = 0;
+      std::vector<std::uint8_t> data;
+
+      int bytes_per_pixel() const noexcept
+      {
+        return type == NVG_TEXTURE_RGBA ? 4 : 1;
+      }
+    };
+
+    /// A color with premultiplied alpha, with channels in [0, 1]
+    struct Premul {
+      float r = 0, g = 0, b = 0, a = 0;
+    };
+
+    Premul premultiply(const NVGcolor& c) noexcept
+    {
+      return {c.r * c.a, c.g * c.a, c.b * c.a, c.a};
+    }
+
+    Premul operator*(const Premul& lhs, const Premul& rhs) noexcept
+    {
+      return {lhs.r * rhs.r, lhs.g * rhs.g, lhs.b * rhs.b, lhs.a * rhs.a};
+    }
+
+    /// Distance from `(x, y)` to the edge of a rounded rectangle centered on the origin
+    ///
+    /// Negative inside. The same function is used by the GL backends for gradients.
+    float sdroundrect(float x, float y, float ext_x, float ext_y, float rad) noexcept
+    {
+      float dx = std::abs(x) - (ext_x - rad);
+      float dy = std::abs(y) - (ext_y - rad);
+      return std::min(std::max(dx, dy), 0.f) + std::hypot(std::max(dx, 0.f), std::max(dy, 0.f)) - rad;
+    }
+
+    /// Calls `f(x, y, w0, w1, w2)` for each pixel whose center is inside the triangle `a`, `b`, `c`
+    ///
+    /// The `w`s are the barycentric coordinates of the pixel center, for `a`, `b` and `c`. Pixels on
+    /// an edge shared by two triangles are only visited for one of them.
+    template<typename F>
+    void rasterize_triangle(const NVGvertex& a, NVGvertex b, NVGvertex c, int width, int height, F&& f)
+    {
+      float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+      if (area == 0 || !std::isfinite(area)) return;
+      bool swapped = area < 0;
+      if (swapped) {
+        std::swap(b, c);
+        area = -area;
+      }
+
+      int x0 = std::max(0, int(std::floor(std::min({a.x, b.x, c.x}))));
+      int x1 = std::min(width - 1, int(std::ceil(std::max({a.x, b.x, c.x}))));
+      int y0 = std::max(0, int(std::floor(std::min({a.y, b.y, c.y}))));
+      int y1 = std::min(height - 1, int(std::ceil(std::max({a.y, b.y, c.y}))));
+
+      auto edge = [](const NVGvertex& p, const NVGvertex& q, float x, float y) {
+        return (q.x - p.x) * (y - p.y) - (q.y - p.y) * (x - p.x);
+      };
+      // Top-left rule, so shared edges belong to exactly one of the triangles
+      auto owns = [](const NVGvertex& p, const NVGvertex& q) {
+        float dx = q.x - p.x, dy = q.y - p.y;
+        return dy > 0 || (dy == 0 && dx < 0);
+      };
+      bool own_bc = owns(b, c), own_ca = owns(c, a), own_ab = owns(a, b);
+
+      for (int y = y0; y <= y1; y++) {
+        float py = y + 0.5f;
+        for (int x = x0; x <= x1; x++) {
+          float px = x + 0.5f;
+          float w0 = edge(b, c, px, py);
+          float w1 = edge(c, a, px, py);
+          float w2 = edge(a, b, px, py);
+          if (w0 < 0 || w1 < 0 || w2 < 0) continue;
+          if ((w0 == 0 && !own_bc) || (w1 == 0 && !own_ca) || (w2 == 0 && !own_ab)) continue;
+          if (swapped) std::swap(w1, w2);
+          f(x, y, w0 / area, w1 / area, w2 / area);
+        }
+      }
+    }
+  } // namespace
+
+  struct SoftwareCanvas::Renderer {
+    Renderer(int width, int height) : target(width, height), mask(width * height) {}
+
+    Bitmap target;
+    /// Indexed by NanoVG image id - 1. Deleted textures have no data.
+    std::vector<Texture> textures;
+    /// Coverage of the current stroke, to draw overlapping parts of it only once
+    std::vector<std::uint8_t> mask;
+
+    Texture* texture(int image) noexcept
+    {
+      if (image <= 0 || image > static_cast<int>(textures.size())) return nullptr;
+      auto& tex = textures[image - 1];
+      return tex.data.empty() ? nullptr : &tex;
+    }
+
+    /// Sample a texture at normalized coordinates, with nearest neighbour filtering
+    Premul sample(const Texture& tex, float u, float v) const noexcept
+    {
+      auto wrap = [](float t, bool repeat) { return repeat ? t - std::floor(t) : std::clamp(t, 0.f, 1.f); };
+      u = wrap(u, tex.flags & NVG_IMAGE_REPEATX);
+      v = wrap(v, tex.flags & NVG_IMAGE_REPEATY);
+      if (tex.flags & NVG_IMAGE_FLIPY) v = 1 - v;
+      int x = std::min(int(u * tex.width), tex.width - 1);
+      int y = std::min(int(v * tex.height), tex.height - 1);
+      auto p = tex.data.data() + (y * tex.width + x) * tex.bytes_per_pixel();
+      if (tex.type != NVG_TEXTURE_RGBA) {
+        float alpha = p[0] / 255.f;
+        return {alpha, alpha, alpha, alpha};
+      }
+      Premul res = {p[0] / 255.f, p[1] / 255.f, p[2] / 255.f, p[3] / 255.f};
+      if (!(tex.flags & NVG_IMAGE_PREMULTIPLIED)) {
+        res.r *= res.a;
+        res.g *= res.a;
+        res.b *= res.a;
+      }
+      return res;
+    }
+
+    /// Blend a premultiplied color over the pixel at `x`, `y`
+    void blend(int x, int y, const Premul& src) noexcept
+    {
+      if (src.a <= 0) return;
+      auto p = target.pixel(x, y);
+      float dst_a = p[3] / 255.f;
+      float keep = dst_a * (1 - src.a);
+      float out_a = src.a + keep;
+      for (int c = 0; c < 3; c++) {
+        float src_c = (&src.r)[c];
+        float out = (src_c + p[c] / 255.f * keep) / out_a;
+        p[c] = static_cast<std::uint8_t>(std::clamp(out, 0.f, 1.f) * 255.f + 0.5f);
+      }
+      p[3] = static_cast<std::uint8_t>(std::clamp(out_a, 0.f, 1.f) * 255.f + 0.5f);
+    }
+
+    /// Evaluates an `NVGpaint` and the scissor at pixel centers
+    struct Shader {
+      Shader(Renderer& r, const NVGpaint& paint, const NVGscissor& scissor)
+        : paint(paint), scissor(scissor), tex(r.texture(paint.image)), renderer(r)
+      {
+        if (!nvgTransformInverse(paint_inv, paint.xform)) std::fill(paint_inv, paint_inv + 6, 0.f);
+        has_scissor = scissor.extent[0] >= -0.5f && scissor.extent[1] >= -0.5f;
+        if (has_scissor && !nvgTransformInverse(scissor_inv, scissor.xform)) std::fill(scissor_inv, scissor_inv + 6, 0.f);
+        inner = premultiply(paint.innerColor);
+        outer = premultiply(paint.outerColor);
+      }
+
+      bool scissored(float x, float y) const noexcept
+      {
+        if (!has_scissor) return false;
+        float sx, sy;
+        nvgTransformPoint(&sx, &sy, scissor_inv, x, y);
+        return std::abs(sx) > scissor.extent[0] || std::abs(sy) > scissor.extent[1];
+      }
+
+      /// The paint color at `x`, `y`, for fills and strokes
+      Premul at(float x, float y) const noexcept
+      {
+        float px, py;
+        nvgTransformPoint(&px, &py, paint_inv, x, y);
+        if (tex) return renderer.sample(*tex, px / paint.extent[0], py / paint.extent[1]) * inner;
+        float feather = std::max(paint.feather, 1e-5f);
+        float d = sdroundrect(px, py, paint.extent[0], paint.extent[1], paint.radius);
+        d = std::clamp((d + feather * 0.5f) / feather, 0.f, 1.f);
+        return {inner.r + (outer.r - inner.r) * d, inner.g + (outer.g - inner.g) * d,
+                inner.b + (outer.b - inner.b) * d, inner.a + (outer.a - inner.a) * d};
+      }
+
+      /// The paint color for texture coordinates `u`, `v`, for triangles
+      Premul at_uv(float u, float v) const noexcept
+      {
+        if (!tex) return inner;
+        return renderer.sample(*tex, u, v) * inner;
+      }
+
+      void shade(int x, int y) const noexcept
+      {
+        float px = x + 0.5f, py = y + 0.5f;
+        if (scissored(px, py)) return;
+        renderer.blend(x, y, at(px, py));
+      }
+
+      const NVGpaint& paint;
+      const NVGscissor& scissor;
+      const Texture* tex;
+      Renderer& renderer;
+      float paint_inv[6];
+      float scissor_inv[6];
+      bool has_scissor;
+      Premul inner;
+      Premul outer;
+    };
+
+    // NanoVG callbacks //
+
+    static Renderer& self(void* uptr) noexcept
+    {
+      return *static_cast<Renderer*>(uptr);
+    }
+
+    static int create(void*)
+    {
+      return 1;
+    }
+
+    static int create_texture(void* uptr, int type, int w, int h, int flags, const unsigned char* data)
+    {
+      auto& r = self(uptr);
+      Texture tex;
+      tex.type = type;
+      tex.width = w;
+      tex.height = h;
+      tex.flags = flags;
+      tex.data.resize(w * h * tex.bytes_per_pixel());
+      if (data) std::memcpy(tex.data.data(), data, tex.data.size());
+      // Reuse the slot of a deleted texture
+      auto slot = std::find_if(r.textures.begin(), r.textures.end(), [](auto& t) { return t.data.empty(); });
+      if (slot != r.textures.end()) {
+        *slot = std::move(tex);
+        return static_cast<int>(slot - r.textures.begin()) + 1;
+      }
+      r.textures.push_back(std::move(tex));
+      return static_cast<int>(r.textures.size());
+    }
+
+    static int delete_texture(void* uptr, int image)
+    {
+      auto tex = self(uptr).texture(image);
+      if (!tex) return 0;
+      *tex = {};
+      return 1;
+    }
+
+    /// `data` points to the full image, like for `glTexSubImage2D` with the row length set
+    static int update_texture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+    {
+      auto tex = self(uptr).texture(image);
+      if (!tex) return 0;
+      int bpp = tex->bytes_per_pixel();
+      for (int row = y; row < y + h; row++) {
+        auto offset = (row * tex->width + x) * bpp;
+        std::memcpy(tex->data.data() + offset, data + offset, w * bpp);
+      }
+      return 1;
+    }
+
+    static int get_texture_size(void* uptr, int image, int* w, int* h)
+    {
+      auto tex = self(uptr).texture(image);
+      if (!tex) return 0;
+      *w = tex->width;
+      *h = tex->height;
+      return 1;
+    }
+
+    // Paths are rasterized right away, so there is nothing to do at the start or end of a frame
+    static void viewport(void*, float, float, float) {}
+    static void cancel(void*) {}
+    static void flush(void*) {}
+
+    /// Scanline fill with the nonzero winding rule, like the stencil fill in the GL backends
+    static void fill(void* uptr,
+                     NVGpaint* paint,
+                     NVGcompositeOperationState,
+                     NVGscissor* scissor,
+                     float,
+                     const float* bounds,
+                     const NVGpath* paths,
+                     int npaths)
+    {
+      auto& r = self(uptr);
+      Shader shader = {r, *paint, *scissor};
+      int width = r.target.width();
+      int y0 = std::max(0, int(std::floor(bounds[1])));
+      int y1 = std::min(r.target.height() - 1, int(std::ceil(bounds[3])));
+
+      struct Crossing {
+        float x;
+        int winding;
+      };
+      std::vector<Crossing> crossings;
+      for (int y = y0; y <= y1; y++) {
+        float cy = y + 0.5f;
+        crossings.clear();
+        for (int i = 0; i < npaths; i++) {
+          auto& path = paths[i];
+          for (int j = 0; j < path.nfill; j++) {
+            auto& a = path.fill[j];
+            auto& b = path.fill[(j + 1) % path.nfill];
+            if ((a.y <= cy) == (b.y <= cy)) continue;
+            float x = a.x + (cy - a.y) * (b.x - a.x) / (b.y - a.y);
+            crossings.push_back({x, b.y > a.y ? 1 : -1});
+          }
+        }
+        std::sort(crossings.begin(), crossings.end(), [](auto& l, auto& r) { return l.x < r.x; });
+        int winding = 0;
+        for (std::size_t i = 0; i + 1 < crossings.size(); i++) {
+          winding += crossings[i].winding;
+          if (winding == 0) continue;
+          // Pixels with their center in [crossings[i].x, crossings[i + 1].x)
+          int x0 = std::max(0, int(std::ceil(crossings[i].x - 0.5f)));
+          int x1 = std::min(width, int(std::ceil(crossings[i + 1].x - 0.5f)));
+          for (int x = x0; x < x1; x++) shader.shade(x, y);
+        }
+      }
+    }
+
+    /// Draws the triangle strips of the paths into a mask first, so overlapping parts are only
+    /// drawn once
+    static void stroke(void* uptr,
+                       NVGpaint* paint,
+                       NVGcompositeOperationState,
+                       NVGscissor* scissor,
+                       float,
+                       float,
+                       const NVGpath* paths,
+                       int npaths)
+    {
+      auto& r = self(uptr);
+      int width = r.target.width(), height = r.target.height();
+      int x0 = width, y0 = height, x1 = -1, y1 = -1;
+      for (int i = 0; i < npaths; i++) {
+        auto& path = paths[i];
+        for (int j = 0; j + 2 < path.nstroke; j++) {
+          rasterize_triangle(path.stroke[j], path.stroke[j + 1], path.stroke[j + 2], width, height,
+                             [&](int x, int y, float, float, float) {
+                               r.mask[y * width + x] = 1;
+                               x0 = std::min(x0, x);
+                               x1 = std::max(x1, x);
+                               y0 = std::min(y0, y);
+                               y1 = std::max(y1, y);
+                             });
+        }
+      }
+      Shader shader = {r, *paint, *scissor};
+      for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+          auto& m = r.mask[y * width + x];
+          if (!m) continue;
+          m = 0;
+          shader.shade(x, y);
+        }
+      }
+    }
+
+    /// Used for text, with the glyph atlas as the paint image
+    static void triangles(void* uptr,
+                          NVGpaint* paint,
+                          NVGcompositeOperationState,
+                          NVGscissor* scissor,
+                          const NVGvertex* verts,
+                          int nverts,
+                          float)
+    {
+      auto& r = self(uptr);
+      Shader shader = {r, *paint, *scissor};
+      for (int i = 0; i + 2 < nverts; i += 3) {
+        auto& a = verts[i];
+        auto& b = verts[i + 1];
+        auto& c = verts[i + 2];
+        rasterize_triangle(a, b, c, r.target.width(), r.target.height(), [&](int x, int y, float w0, float w1, float w2) {
+          if (shader.scissored(x + 0.5f, y + 0.5f)) return;
+          float u = w0 * a.u + w1 * b.u + w2 * c.u;
+          float v = w0 * a.v + w1 * b.v + w2 * c.v;
+          r.blend(x, y, shader.at_uv(u, v));
+        });
+      }
+    }
+
+    /// The renderer is owned by the @ref SoftwareCanvas, not the context
+    static void delete_renderer(void*) {}
+  };
+
+  SoftwareCanvas::SoftwareCanvas(int width, int height)
+    : renderer_(std::make_unique<Renderer>(width, height)), nvg_([this] {
+        NVGparams params = {};
+        params.userPtr = renderer_.get();
+        params.edgeAntiAlias = 0;
+        params.renderCreate = Renderer::create;
+        params.renderCreateTexture = Renderer::create_texture;
+        params.renderDeleteTexture = Renderer::delete_texture;
+        params.renderUpdateTexture = Renderer::update_texture;
+        params.renderGetTextureSize = Renderer::get_texture_size;
+        params.renderViewport = Renderer::viewport;
+        params.renderCancel = Renderer::cancel;
+        params.renderFlush = Renderer::flush;
+        params.renderFill = Renderer::fill;
+        params.renderStroke = Renderer::stroke;
+        params.renderTriangles = Renderer::triangles;
+        params.renderDelete = Renderer::delete_renderer;
+        auto res = nvgCreateInternal(&params);
+        if (!res) throw util::exception("Error: could not create the software NanoVG context");
+        return res;
+      }()),
+      canvas_(nvg_, width, height)
+  {}
+
+  SoftwareCanvas::~SoftwareCanvas() noexcept
+  {
+    nvgDeleteInternal(nvg_);
+  }
+
+  Canvas& SoftwareCanvas::begin_frame(Color background)
+  {
+    renderer_->target.fill(background);
+    return canvas_.beginFrame(renderer_->target.width(), renderer_->target.height());
+  }
+
+  const Bitmap& SoftwareCanvas::end_frame()
+  {
+    canvas_.endFrame();
+    return renderer_->target;
+  }
+
+  const Bitmap& SoftwareCanvas::bitmap() const noexcept
+  {
+    return renderer_->target;
+  }
+
+} // namespace otto::nvg
+
+// kak: other_file=SoftwareCanvas.hpp
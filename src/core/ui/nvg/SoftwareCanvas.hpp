@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+
+#include "Bitmap.hpp"
+#include "Canvas.hpp"
+
+namespace otto::nvg {
+
+  /// A @ref Canvas which renders into a @ref Bitmap in memory, without a GPU
+  ///
+  /// This is a NanoVG backend, so everything drawn on the canvas goes through the same path
+  /// tesselation and text layout as on the device. Only the rasterization is done on the CPU:
+  ///
+  ///  - Shapes are not antialiased. Pixels are covered if their center is inside the shape.
+  ///  - Gradients, image patterns, text and scissoring are supported like in the GL backends.
+  ///  - Only the default composite operation (source over) is supported.
+  ///
+  /// It is meant for drawing screens in tests and benchmarks, not for looking at them on a
+  /// display.
+  ///
+  /// ```cpp
+  /// SoftwareCanvas sc = {320, 240};
+  /// auto& ctx = sc.begin_frame();
+  /// screen.draw(ctx);
+  /// sc.end_frame().write_png("screen.png");
+  /// ```
+  struct SoftwareCanvas {
+    SoftwareCanvas(int width, int height);
+    ~SoftwareCanvas() noexcept;
+
+    SoftwareCanvas(const SoftwareCanvas&) = delete;
+    SoftwareCanvas& operator=(const SoftwareCanvas&) = delete;
+
+    Canvas& canvas() noexcept
+    {
+      return canvas_;
+    }
+
+    /// Fill the bitmap with `background`, and begin a frame on the canvas
+    Canvas& begin_frame(Color background = Color(0x000000FFU));
+
+    /// End the frame on the canvas
+    ///
+    /// \returns the rendered bitmap
+    const Bitmap& end_frame();
+
+    /// The bitmap rendered to
+    const Bitmap& bitmap() const noexcept;
+
+  private:
+    struct Renderer;
+
+    std::unique_ptr<Renderer> renderer_;
+    NVGcontext* nvg_;
+    Canvas canvas_;
+  };
+
+} // namespace otto::nvg
+
+// kak: other_file=SoftwareCanvas.cpp
@@ -29,6 +29,18 @@ namespace otto::core::ui {
 
     /// Run by MainUI when switching to another screen
     virtual void on_hide() {}
+
+    /// Frame rate at which this screen is redrawn while it is shown, even if nothing changed
+    ///
+    /// The UI is only redrawn when it is dirty, i.e. after a UI action, an input event, or while
+    /// an animation is running. Screens which show live data from the audio thread through
+    /// `itc::Shared` values can not report when it changes, so they override this instead.
+    ///
+    /// \returns `0` if the screen only needs to be redrawn when dirty
+    virtual int live_fps() const noexcept
+    {
+      return 0;
+    }
   };
 
 
@@ -64,6 +64,10 @@ namespace otto::core::voices {
   {
     if (play_mode == +PlayMode::interval) aux_value = fmt::format("{:+}", interval);
   }
+  void SettingsScreen::action(polyphony_tag::action, int polyphony) noexcept
+  {
+    polyphony_str = fmt::format("{} voices", polyphony);
+  }
 
   void SettingsScreen::draw(ui::vg::Canvas& ctx)
   {
@@ -81,6 +85,13 @@ namespace otto::core::voices {
     ctx.textAlign(HorizontalAlign::Center, VerticalAlign::Bottom);
     ctx.fillText(play_mode_str, {3.5f * x_pad, y_pad + 0.6f * space + y_shift});
 
+    // Set with shift and the blue encoder
+    ctx.font(Fonts::Norm, 25);
+    ctx.beginPath();
+    ctx.fillStyle(Colours::Blue);
+    ctx.textAlign(HorizontalAlign::Center, VerticalAlign::Top);
+    ctx.fillText(polyphony_str, {3.5f * x_pad, y_pad + 0.6f * space + y_shift});
+
     ctx.font(Fonts::Norm, 35);
     ctx.beginPath();
     ctx.fillStyle(Colours::Green);
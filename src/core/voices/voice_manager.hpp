@@ -2,6 +2,7 @@
 
 #include <Gamma/Envelope.h>
 
+#include <algorithm>
 #include <deque>
 #include <type_traits>
 #include <vector>
@@ -83,6 +84,12 @@ namespace otto::core::voices {
     /// release stage
     bool is_triggered() noexcept;
 
+    /// Is this voice processed by the VoiceManager?
+    ///
+    /// A voice becomes inactive once it is released and has been silent for a while, or when the
+    /// voice limiter has faded it out. It is skipped entirely until it is triggered again.
+    bool is_active() noexcept;
+
     /// Calculate the next glide points, envelope etc..
     /// 
     /// @note Must be called before calling operator(). VoiceManager::operator() and ::process do this.
@@ -124,6 +131,15 @@ namespace otto::core::voices {
     /// Points to the VoiceManager pitch_bend variable.
     float* pitch_bend_ = nullptr;
 
+    /// Voices start out active, until they are found to be silent
+    bool active_ = true;
+    /// The number of samples the voice has been silent for since it was released
+    int silent_frames_ = 0;
+    /// Gain of a voice being faded out by the voice limiter
+    float fade_ = 1.f;
+    /// Decrement of `fade_` per sample. 0 when the voice is not being faded out.
+    float fade_step_ = 0.f;
+
     util::dsp::SegExpBypass<> glide_{1.f};
 
     // Note that the voicemanager does not contain the envelope of the voice by default
@@ -138,13 +154,23 @@ namespace otto::core::voices {
     static_assert(std::is_base_of_v<VoiceBase<Voice>, Voice>,
                   "VoiceManager<Voice, N>: Voice must derive from VoiceBase<Voice>");
 
-    /// The number of voices
+    /// The maximum number of voices
     static constexpr int voice_count_v = NumberOfVoices;
     static constexpr int sub_voice_count_v = 2;
+    /// The lowest polyphony, so mono mode has room for its sub voices
+    static constexpr int min_polyphony = std::min(1 + sub_voice_count_v, voice_count_v);
     /// Voice range is approximately -1 to 1. This ensures the synth range is
     /// approximately the same.
+    ///
+    /// This is the volume at full polyphony, see @ref voice_volume
     static constexpr float normal_volume = 1.f/(float)NumberOfVoices;
 
+    /// Released voices are skipped once their output has stayed below this for `silence_frames`
+    static constexpr float silence_threshold = 1e-5f;
+    static constexpr int silence_frames = 256;
+    /// Time the voice limiter takes to fade out a voice, in seconds
+    static constexpr float limiter_fade_time = 0.005f;
+
     /// Constructor
     ///
     /// Any parameters passed to this will be passed to the constructors of the voices
@@ -153,12 +179,23 @@ namespace otto::core::voices {
 
 
     /// Process audio, applying Preprocessing, each voice and then postprocessing
+    ///
+    /// Calls @ref next_buffer.
     audio::ProcessData<1> process(audio::ProcessData<1> data) noexcept;
 
     /// Process audio, applying Preprocessing, each voice and then postprocessing.
     /// Individual volume of voices are applied here.
+    ///
+    /// Call @ref next_buffer once per buffer when processing with this.
     float operator()() noexcept;
 
+    /// Update the voice limiter with the DSP load of the last buffer
+    ///
+    /// If the load is getting close to the deadline, fewer voices are allowed to sound. Released
+    /// voices above that number are faded out, and new notes steal voices instead of taking free
+    /// ones. When the load has been low for a while, the limit is raised again, up to the polyphony.
+    void next_buffer() noexcept;
+
     void handle_midi(const midi::AnyMidiEvent&) noexcept;
     void handle_pitch_bend(const midi::PitchBendEvent&) noexcept;
     void handle_control_change(const midi::ControlChangeEvent&) noexcept;
@@ -168,6 +205,18 @@ namespace otto::core::voices {
 
     Voice& last_triggered_voice() noexcept;
 
+    /// The number of voices in use, between @ref min_polyphony and @ref voice_count_v
+    int polyphony() const noexcept;
+
+    /// The number of voices which may sound at once, as limited by the DSP load
+    int voice_limit() const noexcept;
+
+    /// The number of active voices, not counting the ones the voice limiter is fading out
+    int active_voices() noexcept;
+
+    /// The volume of a voice, 1 divided by the polyphony
+    float voice_volume() const noexcept;
+
     // -- PROPERTY SETTERS -- //
 
     void action(play_mode_tag::action, PlayMode) noexcept;
@@ -177,6 +226,8 @@ namespace otto::core::voices {
     void action(sub_tag::action, float sub) noexcept;
     void action(detune_tag::action, float detune) noexcept;
     void action(interval_tag::action, int interval) noexcept;
+    /// Releases all voices
+    void action(polyphony_tag::action, int polyphony) noexcept;
 
     /// If avaliable, call the action receivers in the voices for all other actions.
     template<typename Action, typename... Args>
@@ -255,12 +306,13 @@ namespace otto::core::voices {
     };
 
     struct UnisonAllocator final : VoiceAllocatorBase {
-      /// Largest odd number less or equal to number of voices
-      constexpr static int num_voices_used = voice_count_v - (voice_count_v + 1) % 2;
       float detune_ = 0;
 
       UnisonAllocator(VoiceManager& vm_in);
 
+      /// Largest odd number less or equal to the polyphony, and the number of detune values
+      int num_voices_used() const noexcept;
+
       void handle_midi_on(const midi::NoteOnEvent&) noexcept override;
       void set_detune(float detune) noexcept;
     };
@@ -279,9 +331,57 @@ namespace otto::core::voices {
 
     void set_sustain(bool s) noexcept;
 
+    /// Fade out a voice over @ref limiter_fade_time, after which it becomes inactive
+    void fade_out(Voice& v) noexcept;
+    void deactivate(Voice& v) noexcept;
+
+    /// Track whether `v` is still sounding, given its next sample
+    ///
+    /// \returns the sample, faded out if the voice limiter is fading out the voice.
+    float track_output(Voice& v, float out) noexcept;
+
+    /// Caps the number of voices which may sound at once, by the DSP load of the last buffer
+    struct VoiceLimiter {
+      /// Above this load, the limit is lowered below the number of active voices
+      static constexpr float high_load = 0.8f;
+      /// Below this load for `raise_after` buffers in a row, the limit is raised by one voice
+      static constexpr float low_load = 0.6f;
+      static constexpr int raise_after = 32;
+
+      /// \param fading whether a voice shed by the limiter is still fading out
+      /// \param frames the number of frames in the buffer
+      /// \param fade_frames the number of frames a voice takes to fade out
+      void update(float load, int active, int polyphony, bool fading, int frames, int fade_frames) noexcept;
+
+      int limit = std::min(default_polyphony, voice_count_v);
+      int calm_buffers = 0;
+      /// Frames left before the limit may be lowered again. A voice shed to lower the load has to fade
+      /// out before the load can show it, so a long spike does not shed all the voices at once.
+      int hold_frames = 0;
+    };
+    VoiceLimiter limiter_;
+
+    /// Measures the key-to-sound latency of the last note on event
+    ///
+    /// Follows the voice triggered by the event, and records the latency in
+    /// @ref services::AudioManager::key_to_sound_latency at its first non-zero sample.
+    struct OnsetProbe {
+      /// Start following `v`, if `evt` has an input time
+      void start(Voice& v, const midi::NoteOnEvent& evt) noexcept;
+      /// Called with each sample produced by `voice`, from the start of the buffer `evt` was handled in
+      void sample(float f) noexcept;
+
+      /// The voice being followed, or `nullptr`
+      Voice* voice = nullptr;
+      util::latency_clock::time_point input_time;
+      util::latency_clock::time_point buffer_time;
+      int frames = 0;
+    };
+    OnsetProbe onset_probe_;
+
     util::local_vector<float, 7> detune_values;
     util::local_vector<float, voice_count_v> rand_values;
-    // Random values. 100% random, organic and fresh. Works for up to 12 voices.
+    // Random values. 100% random, organic and fresh. Repeats after 12 voices.
     static inline std::array<float, 12> rand_max = {0.94, 0.999, 1.03, 1.06, 0.92, 1.01,
                                                     1.02, 0.98,  1.0,  1.09, 0.94, 1.05};
 
@@ -290,10 +390,11 @@ namespace otto::core::voices {
 
     float pitch_bend_ = 1;
     bool sustain_ = false;
+    int polyphony_ = std::min(default_polyphony, voice_count_v);
 
     // The actual voices
     std::array<Voice, voice_count_v> voices_;
-    // Contains the currently untriggered voices
+    // Contains the currently untriggered voices, of the first `polyphony_`
     util::local_vector<Voice*, voice_count_v> free_voices;
     // Contains informatins about the currently held keys/playing voices.
     // One key pushes more than one entry in other playmodes than poly 
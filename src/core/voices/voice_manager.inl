@@ -74,11 +74,21 @@ namespace otto::core::voices {
     return triggered_;
   }
 
+  template<typename D>
+  bool VoiceBase<D>::is_active() noexcept
+  {
+    return active_;
+  }
+
   template<typename D>
   void VoiceBase<D>::trigger(int midi_note, float detune, float velocity, bool legato, bool jump) noexcept
   {
     midi_note_ = midi_note;
     triggered_ = true;
+    active_ = true;
+    silent_frames_ = 0;
+    fade_ = 1.f;
+    fade_step_ = 0.f;
     // Sets target value of portamento to new note
     frequency_ = midi::note_freq(midi_note) * detune;
     // So far, jump/retrig only works for MONO and UNISON
@@ -156,17 +166,16 @@ namespace otto::core::voices {
   template<typename V, int N>
   auto VoiceManager<V, N>::VoiceAllocatorBase::get_voice(int key, int note) noexcept -> Voice&
   {
-    if (vm.free_voices.size() > 0) {
-      // Usual behaviour is to return the next free voice
-      auto fvit = vm.free_voices.begin();
-      // Finds the voice that last played the note if it exists
-      auto it = nano::find_if(vm.voices_, [note](Voice& vp) { return vp.midi_note_ == note; });
-      // If there is/was a voice that is playing this note
-      if (it != vm.voices_.end()) {
-        // It's not currently playing; choose this voice
-        if (!it->is_triggered()) fvit = nano::find(vm.free_voices, it);
-        // Otherwise, do nothing - That would mean the voice is playing, and we should not steal it.
-      }
+    // At the voice limit, only free voices which are still sounding can be used, so the number of
+    // sounding voices does not grow
+    bool at_limit = vm.active_voices() >= vm.limiter_.limit;
+    auto usable = [at_limit](Voice* v) { return !at_limit || v->is_active(); };
+    // Usual behaviour is to return the next free voice
+    auto fvit = nano::find_if(vm.free_voices, usable);
+    if (fvit != vm.free_voices.end()) {
+      // Prefer a free voice which last played the note
+      auto it = nano::find_if(vm.free_voices, [note](Voice* vp) { return vp->midi_note_ == note; });
+      if (it != vm.free_voices.end() && usable(*it)) fvit = it;
       auto& v = **fvit;
       vm.free_voices.erase(fvit);
       return v;
@@ -224,7 +233,7 @@ namespace otto::core::voices {
   VoiceManager<V, N>::PolyAllocator::PolyAllocator(VoiceManager& vm_in) : VoiceAllocatorBase(vm_in)
   {
     for (auto& voice : this->vm.voices()) {
-      voice.volume(this->vm.normal_volume);
+      voice.volume(this->vm.voice_volume());
     }
     set_rand(0);
   };
@@ -246,7 +255,7 @@ namespace otto::core::voices {
     auto& vm = this->vm;
     vm.rand_values.clear();
     for (int i = 0; i < voice_count_v; i++) {
-      vm.rand_values.push_back(vm.rand_max[i] * r - r + 1.f);
+      vm.rand_values.push_back(vm.rand_max[i % vm.rand_max.size()] * r - r + 1.f);
     }
   }
 
@@ -255,7 +264,7 @@ namespace otto::core::voices {
   VoiceManager<V, N>::IntervalAllocator::IntervalAllocator(VoiceManager& vm_in) : VoiceAllocatorBase(vm_in)
   {
     for (auto& voice : this->vm.voices()) {
-      voice.volume(this->vm.normal_volume / 2.f);
+      voice.volume(this->vm.voice_volume() / 2.f);
     }
   };
 
@@ -286,7 +295,7 @@ namespace otto::core::voices {
   {
     // Set all normal voices
     for (auto& voice : this->vm.voices()) {
-      voice.volume(this->vm.normal_volume);
+      voice.volume(this->vm.voice_volume());
     }
     // Note that after allocation, a prop_change of sub property
     // should be sent, to change sub voice volume
@@ -298,7 +307,7 @@ namespace otto::core::voices {
     // The second and third voice are sub voices on mono mode. This sets their volume.
     int sub_number = 1;
     for (auto& voice : util::view::subrange(this->vm.voices(), 1, 3)) {
-      voice.volume(this->vm.normal_volume * sub / (float) sub_number);
+      voice.volume(this->vm.voice_volume() * sub / (float) sub_number);
       sub_number++;
     }
   }
@@ -343,10 +352,19 @@ namespace otto::core::voices {
   {
     for (int i = 0; i < N; ++i) {
       auto& voice = this->vm.voices_[i];
-      voice.volume(this->vm.normal_volume / (float) num_voices_used);
+      voice.volume(this->vm.voice_volume() / (float) num_voices_used());
     }
   }
 
+  template<typename V, int N>
+  int VoiceManager<V, N>::UnisonAllocator::num_voices_used() const noexcept
+  {
+    // The center voice, and a pair of detuned voices for each of `set_detune`
+    constexpr int max_voices = 5;
+    int n = std::min(this->vm.polyphony_, max_voices);
+    return n - (n + 1) % 2;
+  }
+
   template<typename V, int N>
   void VoiceManager<V, N>::UnisonAllocator::set_detune(float detune) noexcept
   {
@@ -367,10 +385,10 @@ namespace otto::core::voices {
     auto key = evt.key;
     this->stop_voice(key);
     if (vm.note_stack.size() > 0) {
-      for (int i = 0; i < num_voices_used; i++) {
+      for (int i = 0; i < num_voices_used(); i++) {
         // Find the correct voice to steal
         // Every iteration in the loop, a new entry is added to the notestack.
-        auto& note = *(vm.note_stack.end() - num_voices_used);
+        auto& note = *(vm.note_stack.end() - num_voices_used());
         // DLOGI("Stealing voice {} from key {}", (note.voice - vm.voices_.data()), note.note);
         Voice& v = *note.voice;
         // v.release calls on_note_off. Don't do this if legato is engaged.
@@ -381,7 +399,7 @@ namespace otto::core::voices {
         if (res) v.trigger(key, vm.detune_values[i], evt.fvelocity(), vm.legato_, false);
       }
     } else {
-      for (int i = 0; i < num_voices_used; i++) {
+      for (int i = 0; i < num_voices_used(); i++) {
         auto vit = vm.free_voices.begin() + i;
         auto& v = **vit;
         auto res = vm.note_stack.push_back(
@@ -432,12 +450,95 @@ namespace otto::core::voices {
   {
     float voice_sum = 0.f;
     for (auto& voice : voices_) {
+      if (!voice.active_) continue;
       voice.next();
-      voice_sum += voice() * voice.volume();
+      float out = track_output(voice, voice());
+      if (&voice == onset_probe_.voice) onset_probe_.sample(out);
+      voice_sum += out * voice.volume();
     }
     return voice_sum;
   }
 
+  template<typename V, int N>
+  void VoiceManager<V, N>::next_buffer() noexcept
+  {
+    auto& audio_manager = services::AudioManager::current();
+    bool fading = nano::any_of(voices_, [](Voice& v) { return v.active_ && v.fade_step_ > 0; });
+    int fade_frames = std::ceil(limiter_fade_time * audio_manager.samplerate());
+    limiter_.update(audio_manager.dsp_load(), active_voices(), polyphony_, fading, audio_manager.buffer_size(),
+                    fade_frames);
+    // Fade out released voices, longest released first, until no more voices sound than the limit
+    int excess = active_voices() - limiter_.limit;
+    for (Voice* v : free_voices) {
+      if (excess <= 0) break;
+      if (!v->active_ || v->fade_step_ > 0) continue;
+      fade_out(*v);
+      excess--;
+    }
+  }
+
+  template<typename V, int N>
+  void VoiceManager<V, N>::VoiceLimiter::update(float load,
+                                                int active,
+                                                int polyphony,
+                                                bool fading,
+                                                int frames,
+                                                int fade_frames) noexcept
+  {
+    hold_frames = std::max(0, hold_frames - frames);
+    if (load > high_load) {
+      if (hold_frames == 0 && !fading) {
+        limit = std::max(1, std::min(limit, active) - 1);
+        hold_frames = fade_frames;
+      }
+      calm_buffers = 0;
+    } else if (load < low_load && limit < polyphony) {
+      if (++calm_buffers >= raise_after) {
+        limit++;
+        calm_buffers = 0;
+      }
+    } else {
+      calm_buffers = 0;
+    }
+    limit = std::min(limit, polyphony);
+  }
+
+  template<typename V, int N>
+  void VoiceManager<V, N>::fade_out(Voice& v) noexcept
+  {
+    v.fade_step_ = 1.f / (limiter_fade_time * services::AudioManager::current().samplerate());
+  }
+
+  template<typename V, int N>
+  void VoiceManager<V, N>::deactivate(Voice& v) noexcept
+  {
+    v.active_ = false;
+    v.silent_frames_ = 0;
+    v.fade_ = 1.f;
+    v.fade_step_ = 0.f;
+    // Nothing is heard of the glide while the voice is inactive
+    v.glide_.finish();
+  }
+
+  template<typename V, int N>
+  float VoiceManager<V, N>::track_output(Voice& v, float out) noexcept
+  {
+    if (v.fade_step_ > 0) {
+      v.fade_ -= v.fade_step_;
+      if (v.fade_ <= 0) {
+        deactivate(v);
+        return 0.f;
+      }
+      out *= v.fade_;
+    }
+    if (v.triggered_ || std::abs(out) > silence_threshold) {
+      v.silent_frames_ = 0;
+    } else if (++v.silent_frames_ >= silence_frames) {
+      deactivate(v);
+    }
+    return out;
+  }
+
   template<typename V, int N>
   void VoiceManager<V, N>::handle_pitch_bend(const midi::PitchBendEvent& evt) noexcept
   {
@@ -455,12 +556,18 @@ namespace otto::core::voices {
   template<typename V, int N>
   audio::ProcessData<1> VoiceManager<V, N>::process(audio::ProcessData<1> data) noexcept
   {
+    next_buffer();
     for (auto& event : data.midi) handle_midi(event);
     auto buf = services::AudioManager::current().buffer_pool().allocate_clear();
     for (auto& v : voices()) {
+      if (!v.active_) continue;
       auto v_out = v.process(data.audio_only());
       for (auto&& [vf, b] : util::zip(v_out.audio, buf)) {
-        b += vf;
+        // The rest of the buffer is silent once the voice is faded out
+        if (!v.active_) break;
+        float f = track_output(v, vf);
+        if (&v == onset_probe_.voice) onset_probe_.sample(f);
+        b += f;
       }
     }
     return data.with(buf);
@@ -471,13 +578,41 @@ namespace otto::core::voices {
   {
     util::match(
       event, //
-      [&](const midi::NoteOnEvent& evt) { voice_allocator->handle_midi_on(evt); },
+      [&](const midi::NoteOnEvent& evt) {
+        voice_allocator->handle_midi_on(evt);
+        onset_probe_.start(last_triggered_voice(), evt);
+      },
       [&](const midi::NoteOffEvent& evt) { voice_allocator->handle_midi_off(evt); },
       [&](const midi::ControlChangeEvent& evt) { handle_control_change(evt); },
       [&](const midi::PitchBendEvent& evt) { handle_pitch_bend(evt); }, //
       [](auto&&) {});
   }
 
+  template<typename V, int N>
+  void VoiceManager<V, N>::OnsetProbe::start(Voice& v, const midi::NoteOnEvent& evt) noexcept
+  {
+    if (evt.input_time == util::latency_clock::time_point{}) return;
+    voice = &v;
+    input_time = evt.input_time;
+    buffer_time = services::AudioManager::current().buffer_time();
+    frames = 0;
+  }
+
+  template<typename V, int N>
+  void VoiceManager<V, N>::OnsetProbe::sample(float f) noexcept
+  {
+    auto& audio_manager = services::AudioManager::current();
+    if (f == 0) {
+      // Give up on voices which stay silent, like a note with zero velocity
+      if (++frames > audio_manager.samplerate()) voice = nullptr;
+      return;
+    }
+    auto offset = std::chrono::duration<double>(double(frames) / audio_manager.samplerate());
+    auto output_time = buffer_time + std::chrono::duration_cast<util::latency_clock::duration>(offset);
+    audio_manager.key_to_sound_latency.record(output_time - input_time);
+    voice = nullptr;
+  }
+
   template<typename V, int N>
   auto VoiceManager<V, N>::voices() noexcept -> std::array<Voice, voice_count_v>&
   {
@@ -493,6 +628,43 @@ namespace otto::core::voices {
     return *v;
   }
 
+  template<typename V, int N>
+  int VoiceManager<V, N>::polyphony() const noexcept
+  {
+    return polyphony_;
+  }
+
+  template<typename V, int N>
+  int VoiceManager<V, N>::voice_limit() const noexcept
+  {
+    return limiter_.limit;
+  }
+
+  template<typename V, int N>
+  int VoiceManager<V, N>::active_voices() noexcept
+  {
+    return nano::count_if(voices_, [](Voice& v) { return v.active_ && v.fade_step_ == 0; });
+  }
+
+  template<typename V, int N>
+  float VoiceManager<V, N>::voice_volume() const noexcept
+  {
+    return 1.f / (float) polyphony_;
+  }
+
+  template<typename V, int N>
+  void VoiceManager<V, N>::action(polyphony_tag::action, int polyphony) noexcept
+  {
+    polyphony_ = std::clamp(polyphony, min_polyphony, voice_count_v);
+    limiter_.limit = polyphony_;
+    limiter_.calm_buffers = 0;
+    // Resets the voice volumes and the free voices
+    set_playmode(play_mode());
+    for (auto& v : util::view::subrange(voices_, polyphony_, voice_count_v)) {
+      if (v.active_) fade_out(v);
+    }
+  }
+
   template<typename V, int N>
   void VoiceManager<V, N>::action(itc::prop_tag_change<play_mode_tag, PlayMode> a, PlayMode pm) noexcept
   {
@@ -512,8 +684,8 @@ namespace otto::core::voices {
     nano::for_each(voices(), &Voice::release);
     note_stack.clear();
     free_voices.clear();
-    for (auto&& voice : voices()) {
-      free_voices.push_back(&voice);
+    for (int i = 0; i < polyphony_; i++) {
+      free_voices.push_back(&voices_[i]);
     }
   }
 
@@ -2,6 +2,7 @@
 
 #include "core/input.hpp"
 #include "itc/prop.hpp"
+#include "services/controller.hpp"
 
 namespace otto::core::voices {
 
@@ -18,6 +19,11 @@ namespace otto::core::voices {
               /// Plays a given interval
               interval);
 
+  /// The number of voices the synth engines are built with. The polyphony can be set up to this.
+  constexpr int max_voices = 16;
+  /// The polyphony the synth engines start with
+  constexpr int default_polyphony = 6;
+
   /// Tag type for the attack property.
   struct attack_tag {
     using action = itc::Action<attack_tag, float>;
@@ -55,6 +61,10 @@ namespace otto::core::voices {
   struct interval_tag {
     using action = itc::Action<interval_tag, int>;
   };
+  /// Tag type for the polyphony property.
+  struct polyphony_tag {
+    using action = itc::Action<polyphony_tag, int>;
+  };
   /// Tag type for the portamento property.
   struct portamento_tag {
     using action = itc::Action<portamento_tag, float>;
@@ -124,8 +134,10 @@ namespace otto::core::voices {
     Prop<portamento_tag, float> portamento = {sender, 0, props::limits(0, 1), props::step_size(0.01)};
     Prop<legato_tag, bool> legato = {sender, false};
     Prop<retrig_tag, bool> retrig = {sender, false};
+    /// The lower limit leaves room for the sub voices of mono mode
+    Prop<polyphony_tag, int> polyphony = {sender, default_polyphony, props::limits(3, max_voices)};
 
-    DECL_REFLECTION(SettingsProps, play_mode, rand, sub, detune, interval, portamento, legato, retrig);
+    DECL_REFLECTION(SettingsProps, play_mode, rand, sub, detune, interval, portamento, legato, retrig, polyphony);
 
     // TODO: Move to some separate InputHandler
     void encoder(core::input::EncoderEvent ev) override
@@ -133,7 +145,12 @@ namespace otto::core::voices {
       using namespace input;
       auto& props = *this;
       switch (ev.encoder) {
-        case Encoder::blue: props.play_mode.step(ev.steps); break;
+        case Encoder::blue:
+          if (services::Controller::current().is_pressed(Key::shift))
+            props.polyphony.step(ev.steps);
+          else
+            props.play_mode.step(ev.steps);
+          break;
         case Encoder::green: {
           switch (props.play_mode.get()) {
             case PlayMode::poly: props.rand.step(ev.steps); break;
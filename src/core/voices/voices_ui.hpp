@@ -32,11 +32,13 @@ namespace otto::core::voices {
     void action(sub_tag::action, float sub) noexcept;
     void action(detune_tag::action, float detune) noexcept;
     void action(interval_tag::action, int interval) noexcept;
+    void action(polyphony_tag::action, int polyphony) noexcept;
 
   private:
     std::string play_mode_str;
     std::string aux_name;
     std::string aux_value;
+    std::string polyphony_str;
     PlayMode play_mode;
     float portamento = 0;
     bool legato = false;
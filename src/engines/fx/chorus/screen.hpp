@@ -11,6 +11,11 @@ namespace otto::engines::chorus {
   struct Screen : ui::Screen {
     Screen(itc::Shared<float> phase) noexcept;
     void draw(nvg::Canvas& ctx) override;
+    /// Follows the phase of the audio thread
+    int live_fps() const noexcept override
+    {
+      return 30;
+    }
     void draw_front_head(nvg::Canvas&, nvg::Point, ui::vg::Color, float);
     void draw_background_head(nvg::Canvas&, nvg::Point, ui::vg::Color, float);
     
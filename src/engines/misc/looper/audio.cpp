@@ -0,0 +1,198 @@
+#include "audio.hpp"
+
+#include "services/audio_manager.hpp"
+
+namespace otto::engines::looper {
+
+  using namespace core::clock;
+
+  Audio::Audio(Tape& tape, itc::Shared<float> progress, itc::Shared<int> mode) noexcept
+    : tape_(tape), shared_progress_(progress), shared_mode_(mode)
+  {}
+
+  void Audio::restore() noexcept
+  {
+    restored_ = true;
+    samplerate_ = services::AudioManager::current().samplerate();
+    // A loop recorded at another samplerate would play at the wrong speed
+    if (tape_.stored_samplerate() != samplerate_) return;
+    length_ = tape_.stored_length();
+    // Only tracks which held the whole loop are restored
+    for (int t = 0; t < Tape::track_count; t++) {
+      if (tape_.stored_tracks() & (1u << t)) tracks_[t].written = length_;
+    }
+  }
+
+  void Audio::action(itc::prop_change<&Props::mode>, Mode m) noexcept
+  {
+    requested_ = m;
+  }
+
+  void Audio::action(itc::prop_change<&Props::track>, int t) noexcept
+  {
+    track_ = t;
+  }
+
+  void Audio::action(itc::prop_change<&Props::bars>, int b) noexcept
+  {
+    bars_ = b;
+  }
+
+  void Audio::action(itc::prop_change<&Props::feedback>, float f) noexcept
+  {
+    feedback_ = f;
+  }
+
+  void Audio::action(itc::prop_change<&Props::volume>, float v) noexcept
+  {
+    volume_ = v;
+  }
+
+  void Audio::action(clear_action) noexcept
+  {
+    length_ = 0;
+    position_ = 0;
+    synced_ = false;
+    tracks_ = {};
+    tape_.set_length(0, samplerate_);
+    tape_.set_tracks(0);
+  }
+
+  void Audio::apply_requested_mode() noexcept
+  {
+    // Leaving the first pass of a recording closes the loop
+    if (mode_ == +Mode::recording && length_ == 0) close_loop();
+    mode_ = requested_;
+    if (mode_ == +Mode::recording && length_ == 0) position_ = 0;
+  }
+
+  void Audio::close_loop() noexcept
+  {
+    length_ = position_;
+    position_ = 0;
+    // Only the track which was recorded holds the new loop
+    tracks_ = {};
+    tracks_[track_].written = length_;
+    tape_.set_length(length_, samplerate_);
+    tape_.set_tracks(full_tracks());
+  }
+
+  std::uint32_t Audio::full_tracks() const noexcept
+  {
+    std::uint32_t res = 0;
+    for (int t = 0; t < Tape::track_count; t++) {
+      if (length_ > 0 && tracks_[t].full(length_)) res |= 1u << t;
+    }
+    return res;
+  }
+
+  void Audio::write(int track, Tape::Frame frame) noexcept
+  {
+    auto& t = tracks_[track];
+    if (length_ > 0 && !t.full(length_)) {
+      if (t.written == 0 || position_ != (t.start + t.written) % length_) {
+        t.start = position_;
+        t.written = 0;
+      }
+      t.written++;
+      if (t.full(length_)) tape_.set_tracks(full_tracks());
+    }
+    tape_.frames(track)[position_] = frame;
+    tape_.mark_dirty(track, position_);
+  }
+
+  audio::ProcessData<2> Audio::process(audio::ProcessData<2> data) noexcept
+  {
+    if (!restored_) restore();
+    const ClockRange clock = data.clock;
+    const int nframes = data.nframes;
+    const bool clock_running = clock.end != clock.begin;
+    const Time loop_time = bars_ * notes::whole;
+
+    // Frame at which the requested mode takes effect. -1 if it doesn't in this buffer
+    int mode_change = -1;
+    if (requested_ != mode_) {
+      bool starts_new_loop = requested_ == +Mode::recording && length_ == 0;
+      if (starts_new_loop && clock_running) {
+        // Quantize the start of the loop to the next bar
+        if (clock.contains_multiple(notes::whole)) {
+          loop_start_ = clock.first_multiple(notes::whole);
+          synced_ = true;
+          mode_change = clock.sample_offset(loop_start_, nframes);
+        }
+      } else {
+        if (starts_new_loop) synced_ = false;
+        mode_change = 0;
+      }
+    }
+
+    // Frame at which the loop restarts, when synced to the clock. -1 if it doesn't in this buffer
+    int loop_restart = -1;
+    if (synced_ && clock_running && clock.contains_multiple(loop_time, loop_start_)) {
+      loop_restart = clock.sample_offset(clock.first_multiple(loop_time, loop_start_), nframes);
+    }
+
+    // The frame of a track at the current position, or silence if it does not hold the loop there
+    auto read = [this](int track) {
+      if (length_ == 0 || !tracks_[track].holds(position_, length_)) return Tape::Frame{0, 0};
+      return tape_.frames(track)[position_];
+    };
+    // Add the playback of all tracks to `l` and `r`
+    auto play = [&](float& l, float& r) {
+      for (int t = 0; t < Tape::track_count; t++) {
+        auto f = read(t);
+        l += f[0] * volume_;
+        r += f[1] * volume_;
+      }
+    };
+
+    for (int i = 0; i < nframes; i++) {
+      if (i == mode_change) apply_requested_mode();
+      if (i == loop_restart && mode_ != +Mode::stopped) {
+        if (length_ == 0) {
+          // The first pass ends when the loop comes around
+          if (position_ > 0) close_loop();
+        } else {
+          position_ = 0;
+        }
+      }
+
+      float& l = data.audio[0][i];
+      float& r = data.audio[1][i];
+
+      switch (mode_) {
+        case Mode::stopped: continue;
+        case Mode::playing: {
+          if (length_ == 0) continue;
+          play(l, r);
+        } break;
+        case Mode::recording: {
+          auto in = Tape::Frame{l, r};
+          play(l, r);
+          write(track_, in);
+        } break;
+        case Mode::overdubbing: {
+          if (length_ == 0) continue;
+          auto in = Tape::Frame{l, r};
+          auto old = read(track_);
+          play(l, r);
+          write(track_, {old[0] * feedback_ + in[0], old[1] * feedback_ + in[1]});
+        } break;
+      }
+
+      position_++;
+      if (length_ > 0) {
+        if (position_ >= length_) position_ = 0;
+      } else if (position_ >= Tape::capacity) {
+        // The first pass filled the tape
+        close_loop();
+      }
+    }
+
+    shared_progress_ = length_ > 0 ? float(position_) / float(length_) : 0.f;
+    shared_mode_ = mode_._to_integral();
+
+    return data;
+  }
+
+} // namespace otto::engines::looper
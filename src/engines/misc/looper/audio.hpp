@@ -0,0 +1,86 @@
+#pragma once
+
+#include "looper.hpp"
+
+namespace otto::engines::looper {
+
+  using namespace core;
+
+  struct Audio {
+    Audio(Tape& tape, itc::Shared<float> progress, itc::Shared<int> mode) noexcept;
+
+    /// Record the input, and add the loop playback to it
+    audio::ProcessData<2> process(audio::ProcessData<2>) noexcept;
+
+    void action(itc::prop_change<&Props::mode>, Mode m) noexcept;
+    void action(itc::prop_change<&Props::track>, int t) noexcept;
+    void action(itc::prop_change<&Props::bars>, int b) noexcept;
+    void action(itc::prop_change<&Props::feedback>, float f) noexcept;
+    void action(itc::prop_change<&Props::volume>, float v) noexcept;
+
+    using clear_action = itc::Action<struct clear_tag>;
+    void action(clear_action) noexcept;
+
+  private:
+    /// Restore the loop stored on the tape. Called on the first buffer, when the samplerate is settled.
+    void restore() noexcept;
+    /// Switch to the requested mode, at the current frame
+    void apply_requested_mode() noexcept;
+    /// The loop has been recorded for the first time, and gets its length
+    void close_loop() noexcept;
+    /// Write a frame to the current position of a track
+    void write(int track, Tape::Frame frame) noexcept;
+    /// The bitmask of tracks which hold the whole loop
+    std::uint32_t full_tracks() const noexcept;
+
+    /// The part of a track which holds the current loop
+    ///
+    /// The loop is held from `start`, for `written` frames forward around the loop. The rest of the
+    /// track is left from an older loop, and is not played. When writing to a track which does not
+    /// hold the whole loop yet skips ahead, writing starts over from there.
+    struct Track {
+      int start = 0;
+      int written = 0;
+
+      bool full(int length) const noexcept
+      {
+        return written >= length;
+      }
+
+      /// Only called when the loop has a length
+      bool holds(int position, int length) const noexcept
+      {
+        return full(length) || (position - start + length) % length < written;
+      }
+    };
+
+    Tape& tape_;
+    itc::Shared<float> shared_progress_;
+    itc::Shared<int> shared_mode_;
+
+    /// Whether @ref restore has run
+    bool restored_ = false;
+    /// The samplerate the loop is recorded at
+    int samplerate_ = 0;
+
+    Mode requested_ = Mode::stopped;
+    Mode mode_ = Mode::stopped;
+
+    /// The track which is recorded and overdubbed
+    int track_ = 0;
+    std::array<Track, Tape::track_count> tracks_ = {};
+
+    /// Position on the tape, in frames
+    int position_ = 0;
+    /// Length of the loop in frames. 0 while the first pass is being recorded.
+    int length_ = 0;
+    /// The time the loop was started, when it was recorded in sync with the clock
+    clock::Time loop_start_ = 0;
+    /// Whether the loop is synced to the clock
+    bool synced_ = false;
+
+    int bars_ = 2;
+    float feedback_ = 0.8;
+    float volume_ = 1;
+  };
+} // namespace otto::engines::looper
@@ -0,0 +1,51 @@
+#include "looper.hpp"
+
+#include "util/math.hpp"
+
+namespace otto::engines::looper {
+
+  using namespace core::input;
+
+  Looper::Looper()
+    : audio(std::make_unique<Audio>(tape_, shared_progress_, shared_mode_)),
+      screen_(std::make_unique<Screen>(shared_progress_, shared_mode_)),
+      flush_thread_([this](auto&&) {
+        while (flush_thread_.running()) {
+          flush_thread_.sleep_for(chrono::seconds(2));
+          tape_.flush();
+        }
+      })
+  {}
+
+  bool Looper::keypress(Key key)
+  {
+    switch (key) {
+      case Key::blue_click: clear(); break;
+      case Key::green_click: props.track.step(1); break;
+      default: return false;
+    }
+    return true;
+  }
+
+  void Looper::encoder(EncoderEvent ev)
+  {
+    switch (ev.encoder) {
+      case Encoder::blue: props.mode.step(util::math::sgn(ev.steps)); break;
+      case Encoder::green: props.bars.step(ev.steps); break;
+      case Encoder::yellow: props.feedback.step(ev.steps); break;
+      case Encoder::red: props.volume.step(ev.steps); break;
+    }
+  }
+
+  void Looper::clear() noexcept
+  {
+    props.mode.set(Mode::stopped);
+    props.sender.push(Audio::clear_action::data());
+  }
+
+  ui::ScreenAndInput Looper::screen()
+  {
+    return {*screen_, *this};
+  }
+
+} // namespace otto::engines::looper
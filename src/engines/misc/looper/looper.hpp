@@ -0,0 +1,78 @@
+#pragma once
+
+#include "core/engine/engine.hpp"
+#include "itc/itc.hpp"
+#include "util/thread.hpp"
+
+#include "tape.hpp"
+
+namespace otto::engines::looper {
+
+  using namespace core;
+  using namespace core::engine;
+  using namespace props;
+
+  /// The looper modes.
+  ///
+  /// - `stopped`: The tape is neither played nor recorded
+  /// - `playing`: The loop is played back
+  /// - `recording`: The input replaces the loop. If the tape is empty, this records a new loop,
+  ///                which is `bars` long when the clock is running, and otherwise lasts until
+  ///                the mode is changed.
+  /// - `overdubbing`: The input is added to the loop, which is scaled by `feedback`
+  BETTER_ENUM(Mode, std::int8_t, stopped, playing, recording, overdubbing);
+
+  struct Screen;
+  struct Audio;
+  using Sender = EngineSender<Audio, Screen>;
+
+  struct Props {
+    Sender sender;
+
+    Sender::Prop<struct mode_tag, Mode, wrap> mode = {sender, Mode::stopped};
+    /// The track which is recorded and overdubbed. All tracks are played.
+    Sender::Prop<struct track_tag, int, wrap> track = {sender, 0, limits(0, Tape::track_count - 1)};
+    Sender::Prop<struct bars_tag, int> bars = {sender, 2, limits(1, 16), step_size(1)};
+    Sender::Prop<struct feedback_tag, float> feedback = {sender, 0.8, limits(0, 1), step_size(0.01)};
+    Sender::Prop<struct volume_tag, float> volume = {sender, 1, limits(0, 1), step_size(0.01)};
+
+    DECL_REFLECTION(Props, track, bars, feedback, volume);
+  };
+
+  struct Looper : MiscEngine<Looper> {
+    static constexpr util::string_ref name = "Looper";
+
+    Looper();
+
+    bool keypress(input::Key key) override;
+    void encoder(input::EncoderEvent e) override;
+
+    ui::ScreenAndInput screen() override;
+
+    /// Erase the loop. Takes effect on the audio thread.
+    void clear() noexcept;
+
+  private:
+    Tape tape_;
+    itc::Shared<float>::Storage shared_progress_;
+    itc::Shared<int>::Storage shared_mode_;
+
+  public:
+    const std::unique_ptr<Audio> audio;
+
+    DECL_REFLECTION(Looper, props);
+
+  private:
+    const std::unique_ptr<Screen> screen_;
+
+    Sender sender_ = {*audio, *screen_};
+    Props props{sender_};
+
+    /// Writes the recorded parts of the tape to disk in the background
+    util::sleeper_thread flush_thread_;
+  };
+
+} // namespace otto::engines::looper
+
+#include "audio.hpp"
+#include "screen.hpp"
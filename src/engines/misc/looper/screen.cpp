@@ -7,25 +7,76 @@ namespace otto::engines::looper {
   using namespace core::ui;
   using namespace core::ui::vg;
 
+  Screen::Screen(itc::Shared<float> progress, itc::Shared<int> mode) noexcept : progress_(progress), mode_(mode) {}
+
+  void Screen::action(itc::prop_change<&Props::track>, int t) noexcept
+  {
+    track_ = t;
+  }
+
+  void Screen::action(itc::prop_change<&Props::bars>, int b) noexcept
+  {
+    bars_ = b;
+  }
+
+  void Screen::action(itc::prop_change<&Props::feedback>, float f) noexcept
+  {
+    feedback_ = f;
+  }
+
+  void Screen::action(itc::prop_change<&Props::volume>, float v) noexcept
+  {
+    volume_ = v;
+  }
+
+  static std::string to_string(Mode m) noexcept
+  {
+    switch (m) {
+      case Mode::stopped: return "Stopped";
+      case Mode::playing: return "Playing";
+      case Mode::recording: return "Recording";
+      case Mode::overdubbing: return "Overdub";
+    }
+    OTTO_UNREACHABLE;
+  }
+
   void Screen::draw(ui::vg::Canvas& ctx)
   {
     using namespace ui::vg;
 
-    ctx.font(Fonts::Norm, 35);
-
     constexpr float x_pad = 20;
     constexpr float y_pad = 20;
 
+    auto mode = Mode::_from_integral(mode_.get());
 
     // Text
     ctx.font(Fonts::Norm, 35);
-    ctx.fillStyle(Colours::White);
+    ctx.fillStyle(Colours::Blue);
+    ctx.textAlign(HorizontalAlign::Left, VerticalAlign::Top);
+    ctx.fillText(to_string(mode), x_pad, y_pad);
+    ctx.textAlign(HorizontalAlign::Right, VerticalAlign::Top);
+    ctx.fillText(fmt::format("track {}", track_ + 1), width - x_pad, y_pad);
     ctx.textAlign(HorizontalAlign::Left, VerticalAlign::Top);
-    ctx.fillText("Audio Looper", x_pad, y_pad);
 
-    ctx.font(Fonts::Norm, 20);
-    ctx.fillText("Coming Soon:", x_pad, 3 * y_pad);
-    ctx.fillText("Audio looper, single- or multitrack", x_pad, 4 * y_pad);
+    ctx.font(Fonts::Norm, 26);
+    ctx.fillStyle(Colours::Green);
+    ctx.fillText(fmt::format("{} bars", bars_), x_pad, 4 * y_pad);
+    ctx.fillStyle(Colours::Yellow);
+    ctx.fillText(fmt::format("feedback {}", std::round(feedback_ * 100)), x_pad, 6 * y_pad);
+    ctx.fillStyle(Colours::Red);
+    ctx.fillText(fmt::format("volume {}", std::round(volume_ * 100)), x_pad, 8 * y_pad);
+
+    // Progress
+    constexpr float bar_width = width - 2 * x_pad;
+    ctx.beginPath();
+    ctx.rect({x_pad, height - 2 * y_pad}, {bar_width, 6});
+    ctx.fillStyle(Colours::Gray70);
+    ctx.fill();
+
+    ctx.beginPath();
+    ctx.rect({x_pad, height - 2 * y_pad}, {bar_width * progress_.get(), 6});
+    ctx.fillStyle(mode == +Mode::recording || mode == +Mode::overdubbing ? Colours::Red : Colours::White);
+    ctx.fill();
   }
 
 } // namespace otto::engines::looper
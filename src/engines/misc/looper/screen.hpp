@@ -1,17 +1,36 @@
 #pragma once
 
-#include "core/input.hpp"
-#include "core/ui/nvg/Canvas.hpp"
-#include "core/ui/screen.hpp"
+#include "looper.hpp"
 
 namespace otto::engines::looper {
 
   using namespace core;
 
   struct Screen : ui::Screen {
-    void draw(nvg::Canvas&);
-    struct Input : input::InputHandler {
-    } input;
+    Screen(itc::Shared<float> progress, itc::Shared<int> mode) noexcept;
+
+    void draw(nvg::Canvas&) override;
+    /// Follows the loop progress of the audio thread
+    int live_fps() const noexcept override
+    {
+      return 30;
+    }
+
+    void action(itc::prop_change<&Props::track>, int t) noexcept;
+    void action(itc::prop_change<&Props::bars>, int b) noexcept;
+    void action(itc::prop_change<&Props::feedback>, float f) noexcept;
+    void action(itc::prop_change<&Props::volume>, float v) noexcept;
+
+  private:
+    /// Position in the loop, from 0 to 1
+    itc::Shared<float> progress_;
+    /// The mode as run by the audio thread. May differ from the prop while it waits for the next bar
+    itc::Shared<int> mode_;
+
+    int track_ = 0;
+    int bars_ = 2;
+    float feedback_ = 0.8;
+    float volume_ = 1;
   };
 
 } // namespace otto::engines::looper
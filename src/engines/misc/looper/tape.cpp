@@ -0,0 +1,121 @@
+#include "tape.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "services/application.hpp"
+#include "services/log_manager.hpp"
+
+namespace otto::engines::looper {
+
+  /// Read `size` bytes at `offset`, continuing after partial reads. Returns false on errors and end of file.
+  static bool pread_all(int fd, void* data, std::size_t size, std::size_t offset) noexcept
+  {
+    auto* ptr = static_cast<char*>(data);
+    while (size > 0) {
+      auto n = ::pread(fd, ptr, size, offset);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      ptr += n;
+      size -= n;
+      offset += n;
+    }
+    return true;
+  }
+
+  /// Write `size` bytes at `offset`, continuing after partial writes. Returns false on errors.
+  static bool pwrite_all(int fd, const void* data, std::size_t size, std::size_t offset) noexcept
+  {
+    const auto* ptr = static_cast<const char*>(data);
+    while (size > 0) {
+      auto n = ::pwrite(fd, ptr, size, offset);
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0) return false;
+      ptr += n;
+      size -= n;
+      offset += n;
+    }
+    return true;
+  }
+
+  Tape::Tape()
+    : buffer_(frames_size),
+      frames_(reinterpret_cast<Frame*>(buffer_.data())),
+      dirty_(std::make_unique<std::atomic_bool[]>(chunk_count))
+  {
+    for (std::size_t i = 0; i < chunk_count; i++) dirty_[i] = false;
+    load();
+    length_ = stored_length_;
+    samplerate_ = stored_samplerate_;
+    tracks_ = stored_tracks_;
+  }
+
+  Tape::~Tape() noexcept
+  {
+    if (fd_ < 0) return;
+    flush();
+    ::close(fd_);
+  }
+
+  void Tape::load() noexcept
+  {
+    auto path = services::Application::current().data_dir / "looper.tape";
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+      LOGW("Couldn't open file '{}'. ERR {}: {}", path, errno, strerror(errno));
+      LOGW("The loop will not be saved");
+      return;
+    }
+    Header h;
+    if (!pread_all(fd_, &h, sizeof(h), 0)) return;
+    if (h.magic != magic || h.version != version || h.track_count != std::uint32_t(track_count) ||
+        h.capacity != std::uint32_t(capacity) || h.length > std::uint32_t(capacity)) {
+      return;
+    }
+    // Only the tracks which held the whole loop are read back, from the start of the track
+    for (int t = 0; t < track_count; t++) {
+      if (!(h.tracks & (1u << t))) continue;
+      auto offset = header_size + std::size_t(t) * capacity * sizeof(Frame);
+      if (!pread_all(fd_, frames(t), h.length * sizeof(Frame), offset)) {
+        LOGW("Couldn't read track {} of the looper tape", t);
+        h.tracks &= ~(1u << t);
+      }
+    }
+    header_ = h;
+    stored_length_ = h.length;
+    stored_tracks_ = h.tracks;
+    stored_samplerate_ = h.samplerate;
+    DLOGI("Loaded loop of {} frames from tape", stored_length_);
+  }
+
+  void Tape::flush() noexcept
+  {
+    if (fd_ < 0) return;
+    constexpr std::size_t chunk_size = chunk_frames * sizeof(Frame);
+    for (std::size_t i = 0; i < chunk_count; i++) {
+      if (!dirty_[i].exchange(false, std::memory_order_relaxed)) continue;
+      auto size = std::min(chunk_size, frames_size - i * chunk_size);
+      if (!pwrite_all(fd_, buffer_.data() + i * chunk_size, size, header_size + i * chunk_size)) {
+        LOGW("Couldn't write the looper tape. ERR {}: {}", errno, strerror(errno));
+        dirty_[i] = true;
+        return;
+      }
+    }
+    auto length = std::uint32_t(length_.load(std::memory_order_relaxed));
+    auto samplerate = std::uint32_t(samplerate_.load(std::memory_order_relaxed));
+    auto tracks = tracks_.load(std::memory_order_relaxed);
+    if (header_.length != length || header_.samplerate != samplerate || header_.tracks != tracks) {
+      header_.length = length;
+      header_.samplerate = samplerate;
+      header_.tracks = tracks;
+      if (!pwrite_all(fd_, &header_, sizeof(header_), 0)) {
+        LOGW("Couldn't write the looper tape header. ERR {}: {}", errno, strerror(errno));
+      }
+    }
+  }
+
+} // namespace otto::engines::looper
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "util/mapped_buffer.hpp"
+
+#ifndef OTTO_LOOPER_TRACKS
+#define OTTO_LOOPER_TRACKS 4
+#endif
+#ifndef OTTO_LOOPER_SECONDS
+#define OTTO_LOOPER_SECONDS 300
+#endif
+#ifndef OTTO_LOOPER_MAX_SAMPLERATE
+#define OTTO_LOOPER_MAX_SAMPLERATE 48000
+#endif
+
+namespace otto::engines::looper {
+
+  /// The looper tape.
+  ///
+  /// `track_count` tracks of stereo frames, stored interleaved in preallocated, locked anonymous
+  /// memory, so recording and playback never allocate or fault. Recorded chunks are marked dirty
+  /// by the audio thread, and written to a file in the data directory by @ref flush, which runs on
+  /// a background thread. The loop is read back from the file on startup.
+  ///
+  /// The size is set per board with `OTTO_LOOPER_TRACKS`, `OTTO_LOOPER_SECONDS` and
+  /// `OTTO_LOOPER_MAX_SAMPLERATE`. The default of four tracks of five minutes at 48 kHz takes about
+  /// 440 MiB. At higher samplerates, loops can be shorter.
+  struct Tape {
+    using Frame = std::array<float, 2>;
+
+    /// The number of tracks, which are all played back together
+    static constexpr int track_count = OTTO_LOOPER_TRACKS;
+    /// Maximum length of a loop, at `max_samplerate`
+    static constexpr int max_seconds = OTTO_LOOPER_SECONDS;
+    /// The highest samplerate the tape is sized for
+    static constexpr int max_samplerate = OTTO_LOOPER_MAX_SAMPLERATE;
+    /// The number of frames each track can hold
+    static constexpr int capacity = max_samplerate * max_seconds;
+    /// Granularity of dirty tracking, in frames
+    static constexpr int chunk_frames = 1 << 14;
+
+    Tape();
+    ~Tape() noexcept;
+
+    Tape(const Tape&) = delete;
+    Tape& operator=(const Tape&) = delete;
+
+    /// The frames of a track
+    Frame* frames(int track) noexcept
+    {
+      return frames_ + std::size_t(track) * capacity;
+    }
+
+    /// The length of the recorded loop in frames, as stored in the tape file
+    int stored_length() const noexcept
+    {
+      return stored_length_;
+    }
+
+    /// Bitmask of the tracks which held the whole loop, as stored in the tape file
+    std::uint32_t stored_tracks() const noexcept
+    {
+      return stored_tracks_;
+    }
+
+    /// The samplerate the stored loop was recorded at
+    int stored_samplerate() const noexcept
+    {
+      return stored_samplerate_;
+    }
+
+    /// Mark a frame of a track as recorded. Called from the audio thread.
+    void mark_dirty(int track, int frame) noexcept
+    {
+      dirty_[(std::size_t(track) * capacity + frame) / chunk_frames].store(true, std::memory_order_relaxed);
+    }
+
+    /// Publish the loop length, and the samplerate it is played at. Called from the audio thread.
+    void set_length(int length, int samplerate) noexcept
+    {
+      length_.store(length, std::memory_order_relaxed);
+      samplerate_.store(samplerate, std::memory_order_relaxed);
+    }
+
+    /// Publish the bitmask of tracks which hold the whole loop. Called from the audio thread.
+    void set_tracks(std::uint32_t tracks) noexcept
+    {
+      tracks_.store(tracks, std::memory_order_relaxed);
+    }
+
+    /// Write the dirty chunks and the header to the tape file.
+    ///
+    /// The writes go to the page cache, and are not waited for. Not for use on the audio thread.
+    void flush() noexcept;
+
+  private:
+    /// Stored at the start of the tape file
+    struct Header {
+      std::array<char, 8> magic;
+      std::uint32_t version;
+      std::uint32_t samplerate;
+      std::uint32_t length;
+      std::uint32_t tracks;
+      std::uint32_t track_count;
+      std::uint32_t capacity;
+    };
+
+    static constexpr std::array<char, 8> magic = {'O', 'T', 'T', 'O', 'L', 'O', 'O', 'P'};
+    static constexpr std::uint32_t version = 3;
+    /// The frames start at this offset in the file, to keep them page aligned
+    static constexpr std::size_t header_size = 4096;
+    /// The size of all tracks, in bytes
+    static constexpr std::size_t frames_size = std::size_t(track_count) * capacity * sizeof(Frame);
+    /// The number of chunks of dirty tracking
+    static constexpr std::size_t chunk_count = std::size_t(track_count) * capacity / chunk_frames + 1;
+
+    /// Open the tape file, and read the stored loop from it
+    void load() noexcept;
+
+    util::MappedBuffer buffer_;
+    Frame* frames_;
+    /// The tape file, or -1 if the loop is not saved
+    int fd_ = -1;
+    Header header_ = {magic, version, 0, 0, 0, track_count, capacity};
+    int stored_length_ = 0;
+    std::uint32_t stored_tracks_ = 0;
+    int stored_samplerate_ = 0;
+    std::atomic_int length_ = 0;
+    std::atomic_int samplerate_ = 0;
+    std::atomic<std::uint32_t> tracks_ = 0;
+    std::unique_ptr<std::atomic_bool[]> dirty_;
+  };
+
+} // namespace otto::engines::looper
@@ -1,13 +1,25 @@
 #include "audio.hpp"
 
+#include <cmath>
+
 #include "services/audio_manager.hpp"
 #include "services/clock_manager.hpp"
 
 namespace otto::engines::master {
 
-  Audio::Audio() noexcept
+  Audio::Audio(Meters meters) noexcept : meters_(meters)
+  {
+    limiter_.ceiling(ceiling);
+    set_samplerate(services::AudioManager::current().samplerate());
+  }
+
+  void Audio::set_samplerate(int sr) noexcept
   {
-    
+    samplerate_ = sr;
+    // 20 ms volume smoothing
+    volume_smoothing_ = 1.f - std::exp(-1.f / (0.02f * sr));
+    limiter_.release(0.1f, sr);
+    loudness_.set_samplerate(sr);
   }
 
   void Audio::action(itc::prop_change<&Props::volume>, float v) noexcept
@@ -21,16 +33,71 @@ namespace otto::engines::master {
     services::ClockManager::current().set_bpm(t);
   }
 
-  audio::ProcessData<2> Audio::process(audio::ProcessData<2> data) noexcept
+  void Audio::action(itc::prop_change<&Props::true_peak>, bool tp) noexcept
   {
-    for (auto&& l : data.audio[0]) {
-      l = util::math::fastatan( l * volume_square_ );
+    limiter_.true_peak(tp);
+  }
+
+  /// Set NaN, infinite and denormal samples to zero.
+  ///
+  /// \returns true if the sample was NaN or infinite
+  static bool sanitize(float& f) noexcept
+  {
+    if (!std::isfinite(f)) {
+      f = 0;
+      return true;
     }
-    for (auto&& r : data.audio[1]) {
-      r = util::math::fastatan( r * volume_square_ );
+    if (std::abs(f) < 1e-30f) f = 0;
+    return false;
+  }
+
+  audio::ProcessData<2> Audio::process(audio::ProcessData<2> data) noexcept
+  {
+    std::array<float*, 2> out = {data.audio[0].data(), data.audio[1].data()};
+    return process(std::move(data), out);
+  }
+
+  audio::ProcessData<2> Audio::process(audio::ProcessData<2> data, std::array<float*, 2> out) noexcept
+  {
+    int sr = services::AudioManager::current().samplerate();
+    if (sr != samplerate_) set_samplerate(sr);
+
+    int invalid = 0;
+    float peak_l = 0.f;
+    float peak_r = 0.f;
+    double square_sum_l = 0.;
+    double square_sum_r = 0.;
+
+    for (int i = 0; i < data.nframes; i++) {
+      float l = data.audio[0][i];
+      float r = data.audio[1][i];
+      invalid += sanitize(l);
+      invalid += sanitize(r);
+
+      volume_ += (volume_square_ - volume_) * volume_smoothing_;
+      auto limited = limiter_(l * volume_, r * volume_);
+      l = out[0][i] = limited[0];
+      r = out[1][i] = limited[1];
+
+      loudness_(l, r);
+      peak_l = std::max(peak_l, std::abs(l));
+      peak_r = std::max(peak_r, std::abs(r));
+      square_sum_l += l * l;
+      square_sum_r += r * r;
     }
 
-    return data;
+    RT_LOGE_IF(invalid > 0, "Master: {} NaN or infinite samples were set to zero", invalid);
+
+    meters_.peak_l = peak_l;
+    meters_.peak_r = peak_r;
+    meters_.rms_l = std::sqrt(square_sum_l / data.nframes);
+    meters_.rms_r = std::sqrt(square_sum_r / data.nframes);
+    meters_.lufs = loudness_.lufs();
+    meters_.reduction = 20.f * std::log10(limiter_.gain());
+
+    if (out[0] == data.audio[0].data() && out[1] == data.audio[1].data()) return data;
+    return data.with(std::array{audio::AudioBufferHandle(out[0], data.nframes, out_refs_),
+                                audio::AudioBufferHandle(out[1], data.nframes, out_refs_)});
   }
 
-} // namespace otto::engines::wormhole
+} // namespace otto::engines::master
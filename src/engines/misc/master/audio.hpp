@@ -2,20 +2,46 @@
 
 #include "master.hpp"
 
+#include "util/dsp/limiter.hpp"
+#include "util/dsp/loudness.hpp"
+
 namespace otto::engines::master {
 
   using namespace core;
 
+  /// The master stage.
+  ///
+  /// Applies the (smoothed) master volume and a look-ahead brickwall limiter, updates the meters,
+  /// and replaces any NaN, infinite or denormal samples with zero, all in one pass over the buffer.
   struct Audio {
-    Audio() noexcept;
+    Audio(Meters meters) noexcept;
     audio::ProcessData<2> process(audio::ProcessData<2>) noexcept;
+    /// Process `data`, writing the output to `out` instead of in place.
+    ///
+    /// `out` may be the planar buffers of the audio driver. The returned data refers to `out`.
+    audio::ProcessData<2> process(audio::ProcessData<2> data, std::array<float*, 2> out) noexcept;
 
     void action(itc::prop_change<&Props::volume>, float v) noexcept;
     void action(itc::prop_change<&Props::tempo>, float t) noexcept;
+    void action(itc::prop_change<&Props::true_peak>, bool tp) noexcept;
+
+    /// The output ceiling of the limiter, as a linear amplitude (-0.3 dBFS)
+    static constexpr float ceiling = 0.966f;
 
   private:
+    void set_samplerate(int sr) noexcept;
+
+    Meters meters_;
+
     float volume_square_ = 0;
+    float volume_ = 0;
+    float volume_smoothing_ = 0.001f;
     float tempo_ = 120;
-    
+    int samplerate_ = 0;
+    /// Reference count of the output buffers
+    int out_refs_ = 0;
+
+    util::dsp::LookaheadLimiter<64> limiter_;
+    util::dsp::ShortTermLoudness loudness_;
   };
-} // namespace otto::engines::master
\ No newline at end of file
+} // namespace otto::engines::master
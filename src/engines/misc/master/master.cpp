@@ -10,8 +10,8 @@ namespace otto::engines::master {
   using namespace core::input;
 
   Master::Master()
-    : audio(std::make_unique<Audio>()),
-      screen_(std::make_unique<Screen>())
+    : audio(std::make_unique<Audio>(meters_)),
+      screen_(std::make_unique<Screen>(meters_))
   {}
 
   void Master::encoder(EncoderEvent e)
@@ -19,7 +19,7 @@ namespace otto::engines::master {
     switch (e.encoder){
     case Encoder::blue: props.volume.step(e.steps); break;
     case Encoder::green: props.volume.step(e.steps); break;
-    case Encoder::yellow: props.volume.step(e.steps); break;
+    case Encoder::yellow: props.true_peak.step(e.steps); break;
     case Encoder::red: props.tempo.step(e.steps); break;
     }
   }
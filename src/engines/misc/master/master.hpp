@@ -18,8 +18,36 @@ namespace otto::engines::master {
 
       Sender::Prop<struct volume_tag, float> volume = {sender, 0.5, limits(0, 1), step_size(0.01)};
       Sender::Prop<struct tempo_tag, float> tempo = {sender, 120, limits(40, 220), step_size(0.5)};
+      Sender::Prop<struct true_peak_tag, bool> true_peak = {sender, false};
 
-      DECL_REFLECTION(Props, volume);
+      DECL_REFLECTION(Props, volume, true_peak);
+  };
+
+  /// Meter readings of the master output. Written by the audio thread once per buffer.
+  struct Meters {
+    itc::Shared<float> peak_l;
+    itc::Shared<float> peak_r;
+    itc::Shared<float> rms_l;
+    itc::Shared<float> rms_r;
+    /// Short-term loudness, in LUFS
+    itc::Shared<float> lufs;
+    /// Gain applied by the limiter, in dB
+    itc::Shared<float> reduction;
+
+    struct Storage {
+      operator Meters() noexcept
+      {
+        return {peak_l, peak_r, rms_l, rms_r, lufs, reduction};
+      }
+
+    private:
+      itc::Shared<float>::Storage peak_l;
+      itc::Shared<float>::Storage peak_r;
+      itc::Shared<float>::Storage rms_l;
+      itc::Shared<float>::Storage rms_r;
+      itc::Shared<float>::Storage lufs;
+      itc::Shared<float>::Storage reduction;
+    };
   };
 
   struct Master : core::engine::MiscEngine<Master> {
@@ -31,6 +59,10 @@ namespace otto::engines::master {
 
     core::ui::ScreenAndInput screen() override;
 
+  private:
+    Meters::Storage meters_;
+
+  public:
     const std::unique_ptr<Audio> audio;
 
     DECL_REFLECTION(Master, props);
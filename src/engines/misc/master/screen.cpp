@@ -1,5 +1,8 @@
 #include "screen.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include "core/ui/vector_graphics.hpp"
 
 namespace otto::engines::master {
@@ -7,6 +10,8 @@ namespace otto::engines::master {
   using namespace core::ui;
   using namespace core::ui::vg;
 
+  Screen::Screen(Meters meters) noexcept : meters(meters) {}
+
   void Screen::action(itc::prop_change<&Props::volume>, float v) noexcept
   {
     volume_ = v;
@@ -16,6 +21,17 @@ namespace otto::engines::master {
   {
     tempo_ = t;
   }
+  void Screen::action(itc::prop_change<&Props::true_peak>, bool tp) noexcept
+  {
+    true_peak_ = tp;
+  }
+
+  /// Height of a meter bar, for a level in dBFS. The meter shows -60 to 0 dBFS.
+  static float meter_height(float amplitude, float max_height)
+  {
+    float db = 20.f * std::log10(std::max(amplitude, 1e-6f));
+    return std::clamp((db + 60.f) / 60.f, 0.f, 1.f) * max_height;
+  }
 
 
   void Screen::draw(ui::vg::Canvas& ctx)
@@ -69,6 +85,38 @@ namespace otto::engines::master {
     ctx.fillText("tempo", 186.6, 89.9);
     ctx.fillText(fmt::format("{:.1f}", tempo_), {186.6, 120});
 
+    // Meters
+    constexpr float meter_bottom = 200;
+    constexpr float meter_height_max = 160;
+    float rms_l = meter_height(meters.rms_l, meter_height_max);
+    float rms_r = meter_height(meters.rms_r, meter_height_max);
+    float peak_l = meter_height(meters.peak_l, meter_height_max);
+    float peak_r = meter_height(meters.peak_r, meter_height_max);
+
+    ctx.beginPath();
+    ctx.fillStyle(Colours::Green);
+    ctx.rect({290, meter_bottom - rms_l}, {6, rms_l});
+    ctx.rect({300, meter_bottom - rms_r}, {6, rms_r});
+    ctx.fill();
+
+    ctx.beginPath();
+    ctx.fillStyle(Colours::White);
+    ctx.rect({290, meter_bottom - peak_l}, {6, 2});
+    ctx.rect({300, meter_bottom - peak_r}, {6, 2});
+    ctx.fill();
+
+    ctx.font(Fonts::Norm, 16);
+    ctx.fillStyle(Colours::Yellow);
+    float lufs = meters.lufs;
+    ctx.fillText(std::isfinite(lufs) ? fmt::format("{:.1f} LUFS", lufs) : "-inf LUFS", {20, 30});
+    float reduction = meters.reduction;
+    if (reduction < -0.1f) {
+      ctx.fillText(fmt::format("{:.1f} dB", reduction), {20, 50});
+    }
+    if (true_peak_) {
+      ctx.fillText("TP", {280, 225});
+    }
+
   }
 
 
@@ -7,9 +7,20 @@ namespace otto::engines::master {
   using namespace core;
 
   struct Screen : ui::Screen {
+    Screen(Meters meters) noexcept;
+
     void draw(nvg::Canvas& ctx) override;
+    /// Follows the meters of the audio thread
+    int live_fps() const noexcept override
+    {
+      return 30;
+    }
     void action(itc::prop_change<&Props::volume>, float v) noexcept;
     void action(itc::prop_change<&Props::tempo>, float t) noexcept;
+    void action(itc::prop_change<&Props::true_peak>, bool tp) noexcept;
+
+    Meters meters;
+    bool true_peak_ = false;
 
     float volume_ = 0.f;
     float rotation = 0.f;
@@ -6,18 +6,67 @@ namespace otto::engines::sends {
 
   using namespace core;
 
+  /// The gains from one source to each of the busses
+  struct Gains {
+    float dry_l = 0;
+    float dry_r = 0;
+    float fx1 = 0;
+    float fx2 = 0;
+  };
+
+  /// Linear ramp between two sets of gains, over the length of one buffer
+  struct GainRamp {
+    /// Get the gains for the current sample, and advance to the next
+    Gains next() noexcept
+    {
+      auto res = value;
+      value.dry_l += step.dry_l;
+      value.dry_r += step.dry_r;
+      value.fx1 += step.fx1;
+      value.fx2 += step.fx2;
+      return res;
+    }
+
+    Gains value;
+    Gains step;
+  };
+
+  /// One row of the mixing matrix in the engine manager.
+  ///
+  /// Holds the gains from a source to the dry stereo bus and the two effect busses.
   struct Audio {
-    Audio() noexcept {};
+    Audio() noexcept
+    {
+      recalculate();
+      current_ = target_;
+    };
+
+    void recalculate() noexcept
+    {
+      target_.dry_l = volume_ * (1 - pan_) * (1 - mix_);
+      target_.dry_r = volume_ * pan_ * (1 - mix_);
+      target_.fx1 = volume_ * (1 - sendAB_) * mix_;
+      target_.fx2 = volume_ * sendAB_ * mix_;
+    }
 
-    void recalculate() 
+    /// Start a ramp from the current gains to the target gains, over `nframes` samples.
+    ///
+    /// Call once per buffer, from the audio thread.
+    GainRamp ramp(int nframes) noexcept
     {
-      dryL = volume_ * (1 - pan_) * (1 - mix_);
-      dryR = volume_ * pan_ * (1 - mix_);
-      to_fx1 = volume_ * (1 - sendAB_) * mix_;
-      to_fx2 = volume_ * (1 - sendAB_) * mix_;
+      float inv = 1.f / nframes;
+      GainRamp res = {current_,
+                      {
+                        (target_.dry_l - current_.dry_l) * inv,
+                        (target_.dry_r - current_.dry_r) * inv,
+                        (target_.fx1 - current_.fx1) * inv,
+                        (target_.fx2 - current_.fx2) * inv,
+                      }};
+      current_ = target_;
+      return res;
     }
 
-    void action(itc::prop_change<&Props::mix>, float m) noexcept 
+    void action(itc::prop_change<&Props::mix>, float m) noexcept
     {
       mix_ = m;
       recalculate();
@@ -44,10 +93,9 @@ namespace otto::engines::sends {
     float sendAB_ = 0.5;
     float pan_ = 0.5;
 
-    /// Actual values used in the enginemanager
-    float dryL = 0.5;
-    float dryR = 0.5;
-    float to_fx1 = 0;
-    float to_fx2 = 0;
+    /// The gains the ramps are heading towards
+    Gains target_;
+    /// The gains at the end of the last ramp
+    Gains current_;
   };
-} // namespace otto::engines::wormhole
\ No newline at end of file
+} // namespace otto::engines::sends
@@ -24,7 +24,7 @@ namespace otto::engines::sends {
     pan_ = p;
   }
 
-  void Screen::draw(nvg::Canvas &ctx)
+  void Screen::draw_background(nvg::Canvas& ctx)
   {
     using namespace core::ui::vg;
     ctx.font(Fonts::Norm, 35);
@@ -142,11 +142,7 @@ namespace otto::engines::sends {
     ctx.closePath();
     ctx.fill();
 
-    // sends/FX1value
     ctx.restore();
-    ctx.font(Fonts::Norm, 42);
-    ctx.fillStyle(Colours::White);
-    ctx.fillText(fmt::format("{}", std::round(sendAB_ * 100)), 89.2, 89.8);
 
     // sends/FX2
 
@@ -218,11 +214,7 @@ namespace otto::engines::sends {
     ctx.closePath();
     ctx.fill();
 
-    // sends/FX2value
     ctx.restore();
-    ctx.font(Fonts::Norm, 42);
-    ctx.fillStyle(Colours::White);
-    ctx.fillText(fmt::format("{}", std::round(sendAB_ * 100)), 87.7, 211.3);
 
     // sends/dryArrow
 
@@ -247,11 +239,7 @@ namespace otto::engines::sends {
     ctx.strokeStyle(Colours::White);
     ctx.stroke();
 
-    // sends/dryValue
     ctx.restore();
-    ctx.font(Fonts::Norm, 42);
-    ctx.fillStyle(Colours::White);
-    ctx.fillText(fmt::format("{}", std::round(mix_ * 100)), 219.3, 211.9);
 
     // sends/dry
     ctx.font(Fonts::Norm, 30);
@@ -311,11 +299,34 @@ namespace otto::engines::sends {
     ctx.lineTo(187.0, 74.8);
     ctx.stroke();
 
-    // sends/7LinesPointer
     ctx.restore();
+  }
+
+  void Screen::draw(nvg::Canvas& ctx)
+  {
+    using namespace core::ui::vg;
+
+    // The icons, arrows and labels never change
+    background_.draw(ctx, [&] { draw_background(ctx); });
+
+    // sends/FX1value
+    ctx.font(Fonts::Norm, 42);
+    ctx.fillStyle(Colours::White);
+    ctx.fillText(fmt::format("{}", std::round((1 - sendAB_) * 100)), 89.2, 89.8);
+
+    // sends/FX2value
+    ctx.font(Fonts::Norm, 42);
+    ctx.fillStyle(Colours::White);
+    ctx.fillText(fmt::format("{}", std::round(sendAB_ * 100)), 87.7, 211.3);
+
+    // sends/dryValue
+    ctx.font(Fonts::Norm, 42);
+    ctx.fillStyle(Colours::White);
+    ctx.fillText(fmt::format("{}", std::round(mix_ * 100)), 219.3, 211.9);
+
+    // sends/7LinesPointer
     ctx.beginPath();
-    int x_position =
-      (295.3 * (pan_ + 1) * 0.5 + 187.0 * (1 - (pan_ + 1) * 0.5));
+    int x_position = (295.3 * pan_ + 187.0 * (1 - pan_));
     ctx.moveTo(x_position, 59.5);
     ctx.lineTo(x_position, 63.1);
     ctx.lineWidth(6.0);
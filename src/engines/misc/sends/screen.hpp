@@ -11,6 +11,7 @@ namespace otto::engines::sends {
   struct Screen : ui::Screen {
   
     void draw(nvg::Canvas& ctx) override;
+    void draw_background(nvg::Canvas& ctx);
     
     void action(itc::prop_change<&Props::mix>, float m) noexcept;
     void action(itc::prop_change<&Props::volume>, float v) noexcept;
@@ -20,8 +21,10 @@ namespace otto::engines::sends {
   private:
     float mix_ = 0;
     float volume_ = 1;
-    float sendAB_ = 0.5;
+    float sendAB_ = 0;
     float pan_ = 0.5;
+
+    nvg::CachedDrawing background_;
   };
 
 
@@ -10,14 +10,14 @@ namespace otto::engines::sends {
   struct Screen;
   struct Audio;
 
-  using Sender = services::UISender<Audio, Screen>;
+  using Sender = core::engine::EngineSender<Audio, Screen>;
 
   struct Props {
     Sender sender;
 
     Sender::Prop<struct mix_tag, float> mix = {sender, 0, limits(0, 1), step_size(0.01)};
     Sender::Prop<struct sendAB_tag, float> sendAB = {sender, 0, limits(0, 1), step_size(0.01)};
-    Sender::Prop<struct pan_tag, float> pan = {sender, 0, limits(0, 1), step_size(0.01)};
+    Sender::Prop<struct pan_tag, float> pan = {sender, 0.5, limits(0, 1), step_size(0.01)};
     Sender::Prop<struct volume_tag, float> volume = {sender, 0.4, limits(0, 1), step_size(0.01)};
 
     DECL_REFLECTION(Props, mix, sendAB, pan, volume);
@@ -0,0 +1,70 @@
+#include "audio.hpp"
+
+#include "services/clock_manager.hpp"
+
+namespace otto::engines::sequencer {
+
+  using namespace core::clock;
+
+  Audio::Audio(util::publisher<Timeline>& timeline, itc::Shared<int> step) noexcept
+    : timeline_(timeline), shared_step_(step)
+  {
+    shared_step_ = -1;
+  }
+
+  void Audio::action(toggle_play_action) noexcept
+  {
+    auto& clock = services::ClockManager::current();
+    if (clock.running()) {
+      clock.stop(true);
+    } else {
+      clock.start();
+    }
+  }
+
+  void Audio::release(audio::ProcessData<0>& data, std::bitset<128> notes) noexcept
+  {
+    notes &= playing_notes_;
+    if (notes.none()) return;
+    for (int key = 0; key < 128; key++) {
+      if (notes[key]) data.midi.push_back(midi::NoteOffEvent(key));
+    }
+    playing_notes_ &= ~notes;
+  }
+
+  audio::ProcessData<0> Audio::process(audio::ProcessData<0> data) noexcept
+  {
+    const ClockRange clock = data.clock;
+    // Short buffers may get empty clock ranges, so check the clock itself
+    const bool clock_running = services::ClockManager::current().running();
+
+    if (auto* tl = timeline_.acquire(); tl != current_) {
+      // Notes which are not in the new timeline would never get their note-off
+      release(data, tl ? ~tl->keys : ~std::bitset<128>());
+      current_ = tl;
+      cursor_.reset();
+    }
+
+    if (!clock_running || current_ == nullptr) {
+      release(data, ~std::bitset<128>());
+      shared_step_ = -1;
+      return data;
+    }
+
+    cursor_.advance(*current_, clock, [&](const Timeline::Event& ev, Time t) {
+      int offset = clock.sample_offset(t, data.nframes);
+      if (ev.note_on) {
+        if (playing_notes_[ev.key]) data.midi.push_back(midi::NoteOffEvent(ev.key, 0, 0, offset));
+        data.midi.push_back(midi::NoteOnEvent(ev.key, ev.velocity, 0, offset));
+        playing_notes_[ev.key] = true;
+      } else if (playing_notes_[ev.key]) {
+        data.midi.push_back(midi::NoteOffEvent(ev.key, 0, 0, offset));
+        playing_notes_[ev.key] = false;
+      }
+    });
+
+    shared_step_ = clock.begin % current_->length / current_->step_length;
+    return data;
+  }
+
+} // namespace otto::engines::sequencer
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <bitset>
+
+#include "sequencer.hpp"
+
+namespace otto::engines::sequencer {
+
+  using namespace core;
+
+  struct Audio {
+    Audio(util::publisher<Timeline>& timeline, itc::Shared<int> step) noexcept;
+
+    /// Add the notes of the pattern to the midi stream.
+    ///
+    /// The `time` of the midi events is their offset in samples from the start of the buffer.
+    audio::ProcessData<0> process(audio::ProcessData<0>) noexcept;
+
+    using toggle_play_action = itc::Action<struct toggle_play_tag>;
+    void action(toggle_play_action) noexcept;
+
+  private:
+    /// Send note-off events for the playing notes among `notes`
+    void release(audio::ProcessData<0>& data, std::bitset<128> notes) noexcept;
+
+    util::publisher<Timeline>& timeline_;
+    itc::Shared<int> shared_step_;
+
+    const Timeline* current_ = nullptr;
+    TimelineCursor cursor_;
+    std::bitset<128> playing_notes_;
+  };
+
+} // namespace otto::engines::sequencer
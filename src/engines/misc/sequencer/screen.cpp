@@ -7,26 +7,65 @@ namespace otto::engines::sequencer {
   using namespace core::ui;
   using namespace core::ui::vg;
 
+  Screen::Screen(itc::Shared<int> step) noexcept : step_(step) {}
+
+  void Screen::action(itc::prop_change<&Props::track>, int t) noexcept
+  {
+    track_ = t;
+  }
+
+  void Screen::action(track_action, std::uint16_t steps, int note, float gate, int length) noexcept
+  {
+    steps_ = steps;
+    note_ = note;
+    gate_ = gate;
+    length_ = length;
+  }
+
   void Screen::draw(ui::vg::Canvas& ctx)
   {
     using namespace ui::vg;
 
-    ctx.font(Fonts::Norm, 35);
-
     constexpr float x_pad = 20;
     constexpr float y_pad = 20;
 
-
     // Text
     ctx.font(Fonts::Norm, 35);
-    ctx.fillStyle(Colours::White);
+    ctx.fillStyle(Colours::Blue);
     ctx.textAlign(HorizontalAlign::Left, VerticalAlign::Top);
-    ctx.fillText("Sequencer", x_pad, y_pad);
+    ctx.fillText(fmt::format("Track {}", track_ + 1), x_pad, y_pad);
+
+    ctx.font(Fonts::Norm, 26);
+    ctx.fillStyle(Colours::Green);
+    ctx.fillText(fmt::format("note {}", note_), x_pad, 4 * y_pad);
+    ctx.fillStyle(Colours::Yellow);
+    ctx.fillText(fmt::format("gate {:.1f}", gate_), x_pad, 6 * y_pad);
+    ctx.fillStyle(Colours::Red);
+    ctx.fillText(fmt::format("{} steps", length_), x_pad, 8 * y_pad);
 
-    ctx.font(Fonts::Norm, 20);
-    ctx.fillText("Coming Soon:", x_pad, 3 * y_pad);
-    ctx.fillText("Sequence midi output", x_pad, 4 * y_pad);
-    ctx.fillText("or internal audio samples!", x_pad, 5 * y_pad);
+    // Steps
+    constexpr int n_steps = Track::number_of_steps;
+    constexpr float spacing = 4;
+    constexpr float step_width = (width - 2 * x_pad - (n_steps - 1) * spacing) / n_steps;
+    const int playing = step_.get();
+    for (int i = 0; i < n_steps; i++) {
+      ctx.beginPath();
+      ctx.rect({x_pad + i * (step_width + spacing), height - 2 * y_pad}, {step_width, step_width});
+      if (i >= length_) {
+        ctx.strokeStyle(Colours::Gray50);
+        ctx.lineWidth(2);
+        ctx.stroke();
+        continue;
+      }
+      if (i == playing) {
+        ctx.fillStyle(Colours::Red);
+      } else if (steps_ & (1 << i)) {
+        ctx.fillStyle(Colours::White);
+      } else {
+        ctx.fillStyle(Colours::Gray50);
+      }
+      ctx.fill();
+    }
   }
 
 } // namespace otto::engines::sequencer
@@ -1,17 +1,37 @@
 #pragma once
 
-#include "core/input.hpp"
-#include "core/ui/nvg/Canvas.hpp"
-#include "core/ui/screen.hpp"
+#include "sequencer.hpp"
 
 namespace otto::engines::sequencer {
 
   using namespace core;
 
   struct Screen : ui::Screen {
-    void draw(nvg::Canvas&);
-    struct Input : input::InputHandler {
-    } input;
+    Screen(itc::Shared<int> step) noexcept;
+
+    void draw(nvg::Canvas&) override;
+    /// Follows the current step of the audio thread
+    int live_fps() const noexcept override
+    {
+      return 30;
+    }
+
+    void action(itc::prop_change<&Props::track>, int t) noexcept;
+
+    /// The selected track: a bitmask of its active steps, its note, its gate,
+    /// and the length of the pattern
+    using track_action = itc::Action<struct track_data_tag, std::uint16_t, int, float, int>;
+    void action(track_action, std::uint16_t steps, int note, float gate, int length) noexcept;
+
+  private:
+    /// The step being played, or -1 when stopped
+    itc::Shared<int> step_;
+
+    int track_ = 0;
+    std::uint16_t steps_ = 0;
+    int note_ = 60;
+    float gate_ = 0.5;
+    int length_ = Track::number_of_steps;
   };
 
 } // namespace otto::engines::sequencer
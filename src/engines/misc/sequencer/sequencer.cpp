@@ -0,0 +1,100 @@
+#include "sequencer.hpp"
+
+#include <algorithm>
+
+namespace otto::engines::sequencer {
+
+  using namespace core::input;
+
+  Sequencer::Sequencer()
+    : timeline_(std::make_unique<Timeline>(Timeline::compile(pattern_))),
+      audio(std::make_unique<Audio>(timeline_, shared_step_)),
+      screen_(std::make_unique<Screen>(shared_step_))
+  {
+    props.track.on_change().connect([this] { update_screen(); });
+    update_screen();
+  }
+
+  bool Sequencer::keypress(Key key)
+  {
+    switch (key) {
+      case Key::S0: toggle_step(0); break;
+      case Key::S1: toggle_step(1); break;
+      case Key::S2: toggle_step(2); break;
+      case Key::S3: toggle_step(3); break;
+      case Key::S4: toggle_step(4); break;
+      case Key::S5: toggle_step(5); break;
+      case Key::S6: toggle_step(6); break;
+      case Key::S7: toggle_step(7); break;
+      case Key::S8: toggle_step(8); break;
+      case Key::S9: toggle_step(9); break;
+      case Key::S10: toggle_step(10); break;
+      case Key::S11: toggle_step(11); break;
+      case Key::S12: toggle_step(12); break;
+      case Key::S13: toggle_step(13); break;
+      case Key::S14: toggle_step(14); break;
+      case Key::S15: toggle_step(15); break;
+      default: return false;
+    }
+    return true;
+  }
+
+  void Sequencer::encoder(EncoderEvent ev)
+  {
+    auto& track = pattern_.tracks[props.track];
+    switch (ev.encoder) {
+      case Encoder::blue: props.track.step(ev.steps); return;
+      case Encoder::green: track.note = std::clamp(track.note + ev.steps, 0, 127); break;
+      case Encoder::yellow:
+        for (auto& step : track.steps) step.gate = std::clamp(step.gate + 0.1f * ev.steps, 0.1f, 4.f);
+        break;
+      case Encoder::red: pattern_.length = std::clamp(pattern_.length + ev.steps, 1, Track::number_of_steps); break;
+    }
+    publish();
+  }
+
+  void Sequencer::toggle_play() noexcept
+  {
+    props.sender.push(Audio::toggle_play_action::data());
+  }
+
+  void Sequencer::toggle_step(int step)
+  {
+    auto& s = pattern_.tracks[props.track].steps[step];
+    s.active = !s.active;
+    publish();
+  }
+
+  Pattern Sequencer::pattern() const
+  {
+    return pattern_;
+  }
+
+  void Sequencer::set_pattern(const Pattern& p)
+  {
+    pattern_ = p;
+    publish();
+  }
+
+  void Sequencer::publish()
+  {
+    timeline_.publish(std::make_unique<Timeline>(Timeline::compile(pattern_)));
+    update_screen();
+  }
+
+  void Sequencer::update_screen()
+  {
+    auto& track = pattern_.tracks[props.track];
+    std::uint16_t steps = 0;
+    for (int i = 0; i < Track::number_of_steps; i++) {
+      if (track.steps[i].active) steps |= 1 << i;
+    }
+    props.sender.push(Screen::track_action::data(steps, track.note, track.steps[0].gate, pattern_.length));
+  }
+
+  ui::ScreenAndInput Sequencer::screen()
+  {
+    return {*screen_, *this};
+  }
+
+} // namespace otto::engines::sequencer
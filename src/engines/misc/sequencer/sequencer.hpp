@@ -0,0 +1,76 @@
+#pragma once
+
+#include "core/engine/engine.hpp"
+#include "itc/itc.hpp"
+#include "util/publisher.hpp"
+
+#include "timeline.hpp"
+
+namespace otto::engines::sequencer {
+
+  using namespace core;
+  using namespace core::engine;
+  using namespace props;
+
+  struct Screen;
+  struct Audio;
+  using Sender = EngineSender<Audio, Screen>;
+
+  struct Props {
+    Sender sender;
+
+    /// The track being edited
+    Sender::Prop<struct track_tag, int> track = {sender, 0, limits(0, Pattern::number_of_tracks - 1), step_size(1)};
+
+    DECL_REFLECTION(Props, track);
+  };
+
+  /// A 16 track step sequencer, sending notes to the synth.
+  ///
+  /// Every track plays one note. The steps of the selected track are toggled
+  /// with the sequencer keys, and the play key starts and stops the clock.
+  struct Sequencer : MiscEngine<Sequencer> {
+    static constexpr util::string_ref name = "Sequencer";
+
+    Sequencer();
+
+    bool keypress(input::Key key) override;
+    void encoder(input::EncoderEvent e) override;
+
+    ui::ScreenAndInput screen() override;
+
+    /// Start or stop the clock. Takes effect on the audio thread.
+    void toggle_play() noexcept;
+
+    /// Toggle a step of the selected track
+    void toggle_step(int step);
+
+    Pattern pattern() const;
+    void set_pattern(const Pattern& p);
+
+  private:
+    /// Compile the pattern, and hand the timeline to the audio thread
+    void publish();
+    /// Send the selected track to the screen
+    void update_screen();
+
+    Pattern pattern_;
+    util::publisher<Timeline> timeline_;
+    itc::Shared<int>::Storage shared_step_;
+
+  public:
+    const std::unique_ptr<Audio> audio;
+
+    DECL_REFLECTION(Sequencer, props, ("pattern", &Sequencer::pattern, &Sequencer::set_pattern));
+
+  private:
+    const std::unique_ptr<Screen> screen_;
+
+    Sender sender_ = {*audio, *screen_};
+    Props props{sender_};
+  };
+
+} // namespace otto::engines::sequencer
+
+#include "audio.hpp"
+#include "screen.hpp"
@@ -0,0 +1,55 @@
+#include "timeline.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace otto::engines::sequencer {
+
+  Pattern::Pattern() noexcept
+  {
+    // One octave of notes, from C3 upwards
+    for (int i = 0; i < number_of_tracks; i++) {
+      tracks[i].note = 48 + i;
+    }
+  }
+
+  Timeline Timeline::compile(const Pattern& pattern)
+  {
+    Timeline res;
+    auto steps = std::clamp(pattern.length, 1, Track::number_of_steps);
+    res.step_length = pattern.step_length;
+    res.length = steps * pattern.step_length;
+
+    std::size_t count = 0;
+    for (auto& track : pattern.tracks) {
+      count += std::count_if(track.steps.begin(), track.steps.begin() + steps, [](auto& s) { return s.active; });
+    }
+    res.events.reserve(2 * count);
+
+    for (auto& track : pattern.tracks) {
+      for (int i = 0; i < steps; i++) {
+        auto& step = track.steps[i];
+        if (!step.active) continue;
+        clock::Time on = i * pattern.step_length;
+        // At least one microstep long, and at most the whole loop, minus one microstep
+        clock::Time gate = std::clamp(clock::Time(std::round(step.gate * pattern.step_length)), 1, res.length - 1);
+        res.events.push_back({on, track.note, true, step.velocity});
+        res.events.push_back({(on + gate) % res.length, track.note, false, 0});
+        res.keys[track.note] = true;
+      }
+    }
+
+    std::sort(res.events.begin(), res.events.end(), [](const Event& a, const Event& b) {
+      if (a.time != b.time) return a.time < b.time;
+      return !a.note_on && b.note_on;
+    });
+    return res;
+  }
+
+  std::size_t Timeline::lower_bound(clock::Time t) const noexcept
+  {
+    auto found = std::lower_bound(events.begin(), events.end(), t, [](const Event& e, clock::Time t) { return e.time < t; });
+    return found - events.begin();
+  }
+
+} // namespace otto::engines::sequencer
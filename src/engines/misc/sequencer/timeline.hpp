@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#include "core/audio/clock.hpp"
+#include "util/reflection.hpp"
+
+namespace otto::engines::sequencer {
+
+  using namespace core;
+
+  struct Step {
+    bool active = false;
+    float velocity = 1;
+    /// The length of the note, in steps
+    float gate = 0.5;
+
+    DECL_REFLECTION(Step, active, velocity, gate);
+  };
+
+  struct Track {
+    static constexpr int number_of_steps = 16;
+
+    std::uint8_t note = 60;
+    std::array<Step, number_of_steps> steps;
+
+    DECL_REFLECTION(Track, note, steps);
+  };
+
+  /// The pattern, as edited by the user
+  struct Pattern {
+    static constexpr int number_of_tracks = 16;
+
+    std::array<Track, number_of_tracks> tracks;
+    /// Number of steps before the pattern repeats
+    int length = Track::number_of_steps;
+    /// The length of a step
+    clock::Time step_length = clock::notes::sixteenth;
+
+    Pattern() noexcept;
+
+    DECL_REFLECTION(Pattern, tracks, length, step_length);
+  };
+
+  /// A pattern, compiled to a flat list of note events, sorted by time.
+  ///
+  /// Compiled on the logic thread whenever the pattern is changed, so the
+  /// audio thread only has to walk the events that fall inside each buffer.
+  struct Timeline {
+    struct Event {
+      /// Time since the beginning of the pattern. `0 <= time < length`
+      clock::Time time;
+      std::uint8_t key;
+      bool note_on;
+      float velocity;
+    };
+
+    /// Compile a pattern.
+    ///
+    /// At equal times, note-off events are placed before note-on events,
+    /// so repeated notes are retriggered.
+    static Timeline compile(const Pattern& pattern);
+
+    /// Index of the first event at or after `t`. `0 <= t < length`
+    std::size_t lower_bound(clock::Time t) const noexcept;
+
+    std::vector<Event> events;
+    /// The keys played by any event
+    std::bitset<128> keys;
+    /// The length of the loop. Always positive.
+    clock::Time length = clock::notes::whole;
+    clock::Time step_length = clock::notes::sixteenth;
+  };
+
+  /// Reads a looping timeline, one clock range at a time.
+  ///
+  /// As long as the clock ranges are contiguous, the cursor simply advances,
+  /// so a buffer costs O(number of events in it). After a jump in time, or when the
+  /// timeline is replaced, it finds its place with a binary search.
+  struct TimelineCursor {
+    /// Call `f(event, time)` for every event in `range`, where `time` is the
+    /// absolute time of the event.
+    template<typename F>
+    void advance(const Timeline& timeline, clock::ClockRange range, F&& f)
+    {
+      if (range.end <= range.begin) return;
+      const auto& events = timeline.events;
+      const auto length = timeline.length;
+      if (range.begin != next_time_ || &timeline != timeline_) {
+        timeline_ = &timeline;
+        index_ = timeline.lower_bound(range.begin % length);
+      }
+      for (auto t = range.begin; t < range.end;) {
+        auto loop_start = t - t % length;
+        auto segment_end = std::min(range.end, loop_start + length);
+        for (; index_ < events.size() && loop_start + events[index_].time < segment_end; index_++) {
+          f(events[index_], loop_start + events[index_].time);
+        }
+        if (segment_end == loop_start + length) index_ = 0;
+        t = segment_end;
+      }
+      next_time_ = range.end;
+    }
+
+    /// Forget the position, so the next call to `advance` searches for it
+    void reset() noexcept
+    {
+      timeline_ = nullptr;
+    }
+
+  private:
+    const Timeline* timeline_ = nullptr;
+    std::size_t index_ = 0;
+    clock::Time next_time_ = 0;
+  };
+
+} // namespace otto::engines::sequencer
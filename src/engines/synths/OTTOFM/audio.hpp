@@ -212,7 +212,7 @@ namespace otto::engines::ottofm {
     /// Passes unhandled actions to voices
     template<typename Tag, typename... Args>
     auto action(itc::Action<Tag, Args...> a, Args... args) noexcept
-      -> std::enable_if_t<itc::ActionReceiver::is<voices::VoiceManager<Voice, 6>, itc::Action<Tag, Args...>>>
+      -> std::enable_if_t<itc::ActionReceiver::is<voices::VoiceManager<Voice, voices::max_voices>, itc::Action<Tag, Args...>>>
     {
       voice_mgr_.action(a, args...);
     }
@@ -227,7 +227,7 @@ namespace otto::engines::ottofm {
 
     std::array<itc::Shared<float>, 4> shared_activity;
 
-    voices::VoiceManager<Voice, 6> voice_mgr_ = {*this};
+    voices::VoiceManager<Voice, voices::max_voices> voice_mgr_ = {*this};
   };
 
 } // namespace otto::engines::ottofm
@@ -22,7 +22,10 @@ namespace otto::engines::ottofm {
     else
       draw_no_shift(ctx);
 
-    draw_envelope(ctx);
+    // The envelope only changes with the props, so it is not rebuilt for every frame of operator activity
+    auto& op = ops.at(cur_op);
+    envelope_.draw(ctx, [&] { draw_envelope(ctx); }, shift, algorithm_idx, cur_op, op.attack, op.decay_release,
+                   op.suspos, op.feedback);
     draw_operators(ctx);
   }
 
@@ -67,6 +67,11 @@ namespace otto::engines::ottofm {
     }
 
     void draw(nvg::Canvas& ctx) override;
+    /// Follows the operator activity of the audio thread
+    int live_fps() const noexcept override
+    {
+      return 30;
+    }
     void draw_with_shift(nvg::Canvas& ctx);
     void draw_no_shift(nvg::Canvas& ctx);
     void draw_operators(nvg::Canvas& ctx);
@@ -115,6 +120,8 @@ namespace otto::engines::ottofm {
 
     std::array<float, 30> sinewave;
     std::array<float, 30> harmonics;
+
+    nvg::CachedDrawing envelope_;
   };
 
   static_assert(itc::ActionReceiver::is<OttofmScreen::OperatorHelper<1>, itc::prop_change<&Props::OperatorProps<1>::feedback>>);
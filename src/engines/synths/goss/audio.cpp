@@ -25,8 +25,7 @@ namespace otto::engines::goss {
     voice_player.freq(fundamental);
     percussion_player.freq(frequency());
     float s = voice_player() + (percussion_player() + noise() * 0.4) * perc_env();
-    float s_drive = util::math::fasttanh3(audio.gain * s) * audio.output_scaling;
-    return s_drive * env_();
+    return s * env_();
   }
 
   void Voice::on_note_on(float freq_target) noexcept
@@ -84,8 +83,23 @@ namespace otto::engines::goss {
 
   void Audio::action(itc::prop_change<&Props::drive>, float d) noexcept
   {
-    gain = d + 0.1;
-    output_scaling = 6.f / (1 + 4 * util::math::fasttanh3(d));
+    drive = d;
+    update_drive();
+  }
+
+  void Audio::action(voices::polyphony_tag::action a, int p) noexcept
+  {
+    voice_mgr_.action(a, p);
+    update_drive();
+  }
+
+  void Audio::update_drive() noexcept
+  {
+    // The drive runs on the summed voices, where each voice is scaled by the voice manager's
+    // voice volume. Compensate for that, so a single voice is driven as hard at any polyphony.
+    float vv = voice_mgr_.voice_volume();
+    gain = (drive + 0.1) / vv;
+    output_scaling = 6.f / (1 + 4 * util::math::fasttanh3(drive)) * vv;
   }
 
   void Audio::action(itc::prop_change<&Props::leslie>, float l) noexcept
@@ -110,6 +124,8 @@ namespace otto::engines::goss {
 
     // Gets summed sample from all voices
     float voices = voice_mgr_();
+    // Drive
+    voices = drive_(voices, [this](float x) { return util::math::fasttanh3(gain * x); }) * output_scaling;
     // Leslie
     float s_lo = voices * (1 + leslie_amount_lo * leslie_filter_lo.cos());
     float s_hi = hpf(voices) * (1 + leslie_amount_hi * leslie_filter_hi.cos());
@@ -118,6 +134,7 @@ namespace otto::engines::goss {
 
   audio::ProcessData<1> Audio::process(audio::ProcessData<1> data) noexcept
   {
+    voice_mgr_.next_buffer();
     for (auto& m : data.midi) voice_mgr_.handle_midi(m);
     for (float& f : data.audio) {
       f = (*this)();
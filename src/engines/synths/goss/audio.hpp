@@ -5,6 +5,7 @@
 #include <Gamma/Oscillator.h>
 #include <Gamma/Noise.h>
 #include "util/dsp/overdrive.hpp"
+#include "util/dsp/oversampler.hpp"
 
 #include "core/voices/voice_manager.hpp"
 #include "goss.hpp"
@@ -64,9 +65,12 @@ namespace otto::engines::goss {
 
     void action(itc::prop_change<&Props::leslie>, float l) noexcept;
 
+    /// Forwarded to the voice manager. The drive compensation depends on the voice volume.
+    void action(voices::polyphony_tag::action, int p) noexcept;
+
     template<typename Tag, typename... Args>
     auto action(itc::Action<Tag, Args...> a, Args... args) noexcept
-      -> std::enable_if_t<itc::ActionReceiver::is<voices::VoiceManager<Voice, 6>, itc::Action<Tag, Args...>>>
+      -> std::enable_if_t<itc::ActionReceiver::is<voices::VoiceManager<Voice, voices::max_voices>, itc::Action<Tag, Args...>>>
     {
       voice_mgr_.action(a, args...);
     }
@@ -81,13 +85,18 @@ namespace otto::engines::goss {
     itc::Shared<float> shared_rotation_;
 
     void generate_model(gam::Osc<>&, model_type);
+    /// Set the gain and output scaling from `drive` and the voice volume
+    void update_drive() noexcept;
 
     std::array<gam::Osc<>, number_of_models> models;
 
     gam::Osc<> percussion = {1, 0, 2048};
 
+    float drive = 0.f;
     float gain = 0.f;
     float output_scaling = 0.f;
+    /// The drive is applied once, on the summed voices, at twice the samplerate
+    util::dsp::Oversampler<2> drive_;
 
     float leslie = 0.f;
 
@@ -105,6 +114,6 @@ namespace otto::engines::goss {
     gam::Biquad<> lpf;
     gam::Biquad<> hpf;
 
-    voices::VoiceManager<Voice, 6> voice_mgr_ = {*this};
+    voices::VoiceManager<Voice, voices::max_voices> voice_mgr_ = {*this};
   };
 } // namespace otto::engines::goss
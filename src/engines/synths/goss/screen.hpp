@@ -12,6 +12,11 @@ namespace otto::engines::goss {
   struct GossScreen : ui::Screen {
     GossScreen(itc::Shared<float>) noexcept;
     void draw(nvg::Canvas& ctx) override;
+    /// Follows the leslie rotation of the audio thread
+    int live_fps() const noexcept override
+    {
+      return 30;
+    }
     void draw_model(nvg::Canvas& ctx);
 
     void action(itc::prop_change<&Props::model>, int m) noexcept;
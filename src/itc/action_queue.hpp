@@ -1,9 +1,12 @@
 #pragma once
 
 
+#include <algorithm>
 #include <deque>
+#include <functional>
 #include <queue>
 #include <tuple>
+#include <vector>
 
 #include "action.hpp"
 #include "util/spin_lock.hpp"
@@ -12,6 +15,54 @@
 
 namespace otto::itc {
 
+  struct PushOnlyActionQueue;
+
+  /// Groups the functions pushed by one thread into a single entry per queue.
+  ///
+  /// While a transaction is alive, functions pushed to any queue from the thread that created it
+  /// are held back. When it is destroyed, the held back functions for each queue are pushed as one
+  /// function, which calls them in order. The receiving thread then either sees none or all of
+  /// the changes, like every prop of a preset.
+  ///
+  /// Transactions can be nested. Only the outermost one pushes the functions.
+  struct ActionTransaction {
+    using value_type = std::function<void()>;
+
+    ActionTransaction() noexcept : outermost_(current_ == nullptr)
+    {
+      if (outermost_) current_ = this;
+    }
+
+    ActionTransaction(const ActionTransaction&) = delete;
+    ActionTransaction& operator=(const ActionTransaction&) = delete;
+
+    ~ActionTransaction() noexcept;
+
+  private:
+    friend PushOnlyActionQueue;
+
+    /// Hold back `v` if a transaction is open on this thread
+    ///
+    /// \returns `false` if there is no open transaction
+    static bool hold(PushOnlyActionQueue& queue, value_type& v)
+    {
+      if (current_ == nullptr) return false;
+      auto& batches = current_->batches_;
+      auto found = std::find_if(batches.begin(), batches.end(), [&](auto& b) { return b.first == &queue; });
+      if (found == batches.end()) {
+        batches.emplace_back(&queue, std::vector<value_type>());
+        found = batches.end() - 1;
+      }
+      found->second.push_back(std::move(v));
+      return true;
+    }
+
+    bool outermost_;
+    std::vector<std::pair<PushOnlyActionQueue*, std::vector<value_type>>> batches_;
+
+    static inline thread_local ActionTransaction* current_ = nullptr;
+  };
+
   /// The push-only interface of an {@ref ActionQueue}.
   ///
   /// Queue-owners can expose a reference to this to make sure the internal pop functions aren't
@@ -53,16 +104,25 @@ namespace otto::itc {
     /// This is completely separate from actions, and just allows you to run any old function on the other thread
     ///
     /// @TODO Consider, should this be removed from the interface?
-    void push(const value_type& v) noexcept
+    void push(value_type v) noexcept
     {
-      lock_.lock();
-      queue_.push(v);
-      lock_.unlock();
+      if (ActionTransaction::hold(*this, v)) return;
+      push_now(std::move(v));
     }
 
   protected:
     PushOnlyActionQueue() = default;
 
+    friend ActionTransaction;
+
+    /// Push `v` to the queue, ignoring transactions
+    void push_now(value_type v) noexcept
+    {
+      lock_.lock();
+      queue_.push(std::move(v));
+      lock_.unlock();
+    }
+
     util::spin_lock lock_;
     std::queue<value_type, std::deque<value_type>> queue_;
   };
@@ -98,4 +158,19 @@ namespace otto::itc {
       lock_.unlock();
     }
   };
+
+  inline ActionTransaction::~ActionTransaction() noexcept
+  {
+    if (!outermost_) return;
+    current_ = nullptr;
+    for (auto& [queue, fns] : batches_) {
+      if (fns.size() == 1) {
+        queue->push_now(std::move(fns.front()));
+        continue;
+      }
+      queue->push_now([fns = std::move(fns)] {
+        for (auto& f : fns) f();
+      });
+    }
+  }
 } // namespace otto::itc
@@ -104,6 +104,26 @@ namespace otto::itc {
     prop.set(std::move(v));
   }
 
+  /// Serialize a property to binary
+  template<typename Sndr, typename Tag, typename ValueType, typename... Mixins>
+  inline void serialize_binary(util::CborWriter& w, const ActionProp<Sndr, Tag, ValueType, Mixins...>& prop)
+  {
+    using ::otto::util::serialize_binary;
+    serialize_binary(w, prop.get());
+  }
+
+  /// Deserialize a property from binary
+  template<typename Sndr, typename Tag, typename ValueType, typename... Mixins>
+  inline void deserialize_binary(util::CborReader& r, ActionProp<Sndr, Tag, ValueType, Mixins...>& prop)
+  {
+    using ::otto::util::deserialize_binary;
+    static_assert(std::is_default_constructible_v<ValueType>,
+                  "A property type must be default constructible to be deserializable");
+    ValueType v{};
+    deserialize_binary(r, v);
+    prop.set(std::move(v));
+  }
+
   /// Get the property type from a member pointer to it
   struct PropTypeFor {
     static constexpr auto _get(...) -> void;
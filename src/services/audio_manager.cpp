@@ -2,6 +2,8 @@
 
 #include <Gamma/Domain.h>
 
+#include "util/utility.hpp"
+
 namespace otto::services {
 
   AudioManager::AudioManager()
@@ -40,6 +42,9 @@ namespace otto::services {
 
   void AudioManager::send_midi_event(core::midi::AnyMidiEvent evt) noexcept
   {
+    util::match(evt, [](auto& e) {
+      if (e.input_time == util::latency_clock::time_point{}) e.input_time = util::latency_clock::now();
+    });
     midi_bufs.outer().emplace_back(std::move(evt));
   }
 
@@ -50,9 +55,16 @@ namespace otto::services {
     return res;
   }
 
+  void AudioManager::record_dsp_load(float load) noexcept
+  {
+    _cpu_time.add(load);
+    dsp_load_ = load;
+  }
+
   void AudioManager::pre_process_tasks() noexcept
   {
     _buffer_number++;
+    buffer_time_ = util::latency_clock::now();
     auto running = this->running() && Application::current().running();
     if (running) {
       action_queue_.pop_call_all();
@@ -7,6 +7,7 @@
 #include "itc/itc.hpp"
 #include "services/application.hpp"
 #include "services/debug_ui.hpp"
+#include "util/latency.hpp"
 #include "util/locked.hpp"
 #include "util/signals.hpp"
 
@@ -36,6 +37,7 @@ namespace otto::services {
     /// Send a midi event into the system.
     ///
     /// The `core::midi` namespace has some nice utils for constructing events.
+    /// Events without an `input_time` are stamped with the current time.
     void send_midi_event(core::midi::AnyMidiEvent) noexcept;
 
     /// Get the samplerate
@@ -76,6 +78,30 @@ namespace otto::services {
     /// The amount of cpu time spent on average since the last call to this function
     float cpu_time() noexcept;
 
+    /// The time the last buffer took to process, as a fraction of the time it plays for
+    ///
+    /// Above 1, the deadline was missed. Not updated while there is no deadline, like when jack is
+    /// freewheeling.
+    float dsp_load() const noexcept
+    {
+      return dsp_load_;
+    }
+
+    /// The time the processing of the current buffer started
+    ///
+    /// Only meaningful on the audio thread.
+    util::latency_clock::time_point buffer_time() const noexcept
+    {
+      return buffer_time_;
+    }
+
+    /// Time from a note on event entering the system, to the first non-zero output of the voice it
+    /// triggered
+    ///
+    /// The output is timed from the start of its buffer, so the latency of the sound card comes on
+    /// top of this. Recorded by @ref core::voices::VoiceManager.
+    util::LatencyHistogram key_to_sound_latency;
+
     /// Get the current instance of this service
     ///
     /// Alias to `Application::current().audio_manager`
@@ -87,6 +113,10 @@ namespace otto::services {
     struct Events {
       /// Triggered first in constructor
       util::Signal<> pre_init;
+      /// Triggered when the buffer size changes, while no audio is being processed.
+      ///
+      /// Listeners can reallocate their buffers here, so they don't have to on the audio thread.
+      util::Signal<int> buffer_size_change;
     } events;
 
   protected:
@@ -95,11 +125,18 @@ namespace otto::services {
     /// Executes the items in the action queue, and increments the buffer number
     void pre_process_tasks() noexcept;
 
+    /// Called by implementations after processing a buffer, with the time it took as a fraction of
+    /// the time it plays for
+    void record_dsp_load(float load) noexcept;
+
     util::double_buffered<core::midi::shared_vector<core::midi::AnyMidiEvent>> midi_bufs = {{}, {}};
     std::atomic_int _samplerate = 48000;
     std::atomic_uint _buffer_size = 256;
     std::atomic_uint _buffer_number = 0;
+    /// Set in @ref pre_process_tasks
+    util::latency_clock::time_point buffer_time_ = {};
     util::audio::Graph _cpu_time;
+    std::atomic<float> dsp_load_ = 0;
     itc::ActionQueue action_queue_;
 
   private:
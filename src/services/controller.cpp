@@ -1,6 +1,7 @@
 #include "controller.hpp"
 
 #include "services/audio_manager.hpp"
+#include "services/thread_policy.hpp"
 #include "services/ui_manager.hpp"
 #include "util/iterator.hpp"
 #include "util/utility.hpp"
@@ -8,20 +9,22 @@
 namespace otto::services {
 
   using Event = Controller::Event;
-  using EventBag = Controller::EventBag;
   using namespace core::input;
 
-  static bool send_midi_for(Key key, bool press)
+  static bool send_midi_for(Key key, bool press, util::latency_clock::time_point input_time)
   {
     if (UIManager::current().state.key_mode != KeyMode::midi) return false;
-    auto send_midi = [press](int note) {
+    auto send_midi = [press, input_time](int note) {
       note += 12 * UIManager::current().state.octave;
       if (press) {
         auto evt = core::midi::NoteOnEvent{note};
+        evt.input_time = input_time;
         AudioManager::current().send_midi_event(evt);
         DLOGI("Press key {}", evt.key);
       } else {
-        AudioManager::current().send_midi_event(core::midi::NoteOffEvent{note});
+        auto evt = core::midi::NoteOffEvent{note};
+        evt.input_time = input_time;
+        AudioManager::current().send_midi_event(evt);
         DLOGI("Release key {}", note);
       }
     };
@@ -58,24 +61,31 @@ namespace otto::services {
 
   bool Controller::keypress(Key key)
   {
-    if (!send_midi_for(key, true)) events_.outer().push_back(KeyPressEvent{key});
-    key_handler_thread.trigger();
+    if (!send_midi_for(key, true, input_time_)) push_event(KeyPressEvent{key});
     return true;
   }
 
   void Controller::encoder(EncoderEvent ev)
   {
-    events_.outer().push_back(ev);
-    key_handler_thread.trigger();
+    auto& steps = encoder_steps_[ev.encoder._to_index()];
+    // If there already were steps, they have an event queued, which will also dispatch these
+    if (steps.fetch_add(ev.steps, std::memory_order_relaxed) != 0) return;
+    push_event(EncoderEvent{ev.encoder, 0});
   }
 
   bool Controller::keyrelease(Key key)
   {
-    if (!send_midi_for(key, false)) events_.outer().push_back(KeyReleaseEvent{key});
-    key_handler_thread.trigger();
+    if (!send_midi_for(key, false, input_time_)) push_event(KeyReleaseEvent{key});
     return true;
   }
 
+  void Controller::push_event(Event event)
+  {
+    auto time = input_time_ != util::latency_clock::time_point{} ? input_time_ : util::latency_clock::now();
+    events_.push({std::move(event), time});
+    wake_.notify();
+  }
+
   bool Controller::is_pressed(Key k) noexcept
   {
     return keys[k._to_index()];
@@ -99,29 +109,109 @@ namespace otto::services {
     return true;
   }
 
+  void Controller::dispatch(Event& event)
+  {
+    signals.on_input.emit(event);
+    util::match(
+      event,
+      [this](KeyPressEvent& ev) {
+        keys[ev.key._to_index()] = true;
+        if (handle_global(ev.key)) return;
+        UIManager::current().current_input_handler().keypress(ev.key);
+      },
+      [this](KeyReleaseEvent& ev) {
+        keys[ev.key._to_index()] = false;
+        if (handle_global(ev.key, false)) return;
+        UIManager::current().current_input_handler().keyrelease(ev.key);
+      },
+      [](EncoderEvent& ev) { UIManager::current().current_input_handler().encoder(ev); });
+  }
+
+  void Controller::dispatch_events()
+  {
+    while (auto ev = events_.pop()) {
+      if (auto* enc = std::get_if<EncoderEvent>(&ev->event)) {
+        enc->steps = encoder_steps_[enc->encoder._to_index()].exchange(0, std::memory_order_relaxed);
+        // The steps were already dispatched with an earlier event, or summed to zero
+        if (enc->steps == 0) continue;
+      }
+      input_latency.record(util::latency_clock::now() - ev->time);
+      dispatch(ev->event);
+    }
+    // Steps whose event was dropped because the queue was full
+    for (auto encoder : Encoder::_values()) {
+      int steps = encoder_steps_[encoder._to_index()].exchange(0, std::memory_order_relaxed);
+      if (steps == 0) continue;
+      Event event = EncoderEvent{encoder, steps};
+      dispatch(event);
+    }
+    if (auto dropped = events_.take_dropped(); dropped > 0) {
+      LOGW("Dropped {} input events, the logic thread is not keeping up", dropped);
+    }
+    while (auto task = tasks_.pop()) {
+      try {
+        (*task)();
+      } catch (std::exception& e) {
+        LOGE("Exception in task posted to the logic thread: {}", e.what());
+      }
+    }
+  }
+
+  bool Controller::post(std::function<void()> task)
+  {
+    if (stopping_ || !tasks_.push(std::move(task))) return false;
+    wake_.notify();
+    return true;
+  }
+
   Controller::Controller()
-    : key_handler_thread([this](auto&& should_run) {
-        while (!events_.inner().empty() || should_run()) {
-          events_.swap();
-          for (auto& event : events_.inner()) {
-            signals.on_input.emit(event);
-            util::match(
-              event,
-              [this](KeyPressEvent& ev) {
-                keys[ev.key._to_index()] = true;
-                if (handle_global(ev.key)) return;
-                UIManager::current().current_input_handler().keypress(ev.key);
-              },
-              [this](KeyReleaseEvent& ev) {
-                keys[ev.key._to_index()] = false;
-                if (handle_global(ev.key, false)) return;
-                UIManager::current().current_input_handler().keyrelease(ev.key);
-              },
-              [](EncoderEvent& ev) { UIManager::current().current_input_handler().encoder(ev); });
-          }
-        }
-      })
-  {}
+  {
+    key_handler_thread.emplace([this](auto&&) {
+      // Not io: the logic thread runs the UI's handlers, it does not talk to hardware
+      ThreadPolicy::set_role(ThreadPolicy::Role::ui);
+      while (!stopping_) {
+        wake_.wait();
+        dispatch_events();
+      }
+      // Events pushed while stopping
+      dispatch_events();
+    });
+  }
+
+  Controller::~Controller() noexcept
+  {
+    stopping_ = true;
+    wake_.notify();
+    key_handler_thread.reset();
+  }
+
+  // LEDFramebuffer //
+
+  LEDFramebuffer::LEDFramebuffer(chrono::duration min_interval) noexcept : min_interval_(min_interval) {}
+
+  void LEDFramebuffer::set(LED led, LEDColor color) noexcept
+  {
+    auto lock = std::unique_lock(mutex_);
+    colors_[led.key] = color;
+  }
+
+  void LEDFramebuffer::fill(LEDColor color) noexcept
+  {
+    auto lock = std::unique_lock(mutex_);
+    for (auto& c : colors_) c = color;
+  }
+
+  LEDColor LEDFramebuffer::get(LED led) const noexcept
+  {
+    auto lock = std::unique_lock(mutex_);
+    return colors_[led.key];
+  }
+
+  void LEDFramebuffer::invalidate() noexcept
+  {
+    auto lock = std::unique_lock(mutex_);
+    send_all_ = true;
+  }
 
   // DummyController //
   struct DummyController final : Controller {
@@ -4,6 +4,9 @@
 #include <better_enum.hpp>
 #include <cstdint>
 #include <foonathan/array/flat_map.hpp>
+#include <functional>
+#include <mutex>
+#include <optional>
 #include <variant>
 #include <vector>
 
@@ -11,8 +14,12 @@
 #include "core/service.hpp"
 
 #include "services/application.hpp"
+#include "util/enum.hpp"
+#include "util/latency.hpp"
 #include "util/locked.hpp"
+#include "util/mpsc_queue.hpp"
 #include "util/thread.hpp"
+#include "util/wake_flag.hpp"
 
 namespace otto::board::ui {
   enum struct Action;
@@ -64,6 +71,15 @@ namespace otto::services {
               static_cast<std::uint8_t>(b + o.b)};
     }
 
+    bool operator==(LEDColor o) const noexcept
+    {
+      return r == o.r && g == o.g && b == o.b;
+    }
+    bool operator!=(LEDColor o) const noexcept
+    {
+      return !(*this == o);
+    }
+
     static const LEDColor Black;
     static const LEDColor White;
     static const LEDColor Blue;
@@ -80,6 +96,52 @@ namespace otto::services {
   inline const LEDColor LEDColor::Yellow = 0x888800;
   inline const LEDColor LEDColor::Red = 0xFF0000;
 
+  /// The colors of the LEDs, and the colors last sent to the hardware
+  ///
+  /// For controllers which send the LED colors over a slow link. @ref set only changes the
+  /// framebuffer. When the LEDs are flushed, @ref take_changes gives the LEDs which differ from
+  /// what was last sent, so the controller can send them all in one batch. Setting an LED to the
+  /// color it already has sends nothing.
+  ///
+  /// Batches are sent at most once per `min_interval`. Changes made in between are sent with the
+  /// next batch, and only the last color set for an LED is sent.
+  ///
+  /// Thread safe.
+  struct LEDFramebuffer {
+    LEDFramebuffer(chrono::duration min_interval = chrono::milliseconds(20)) noexcept;
+
+    void set(LED led, LEDColor color) noexcept;
+
+    /// Set all LEDs to `color`
+    void fill(LEDColor color) noexcept;
+
+    /// The color of an LED in the framebuffer
+    LEDColor get(LED led) const noexcept;
+
+    /// Send all LEDs with the next batch, also the unchanged ones
+    ///
+    /// For when the hardware may have lost its state, like after a reset.
+    void invalidate() noexcept;
+
+    /// Call `f(LED, LEDColor)` for each LED which changed since the last batch, and mark them as
+    /// sent
+    ///
+    /// Does nothing if the last batch was less than `min_interval` ago.
+    ///
+    /// \returns the number of LEDs passed to `f`
+    template<typename Func>
+    int take_changes(Func&& f);
+
+  private:
+    mutable std::mutex mutex_;
+    util::enum_map<core::input::Key, LEDColor> colors_ = {};
+    util::enum_map<core::input::Key, LEDColor> sent_ = {};
+    /// Nothing is known about the state of the hardware until the first batch
+    bool send_all_ = true;
+    chrono::duration min_interval_;
+    chrono::time_point last_batch_ = {};
+  };
+
   struct Controller : core::Service, core::input::InputHandler {
     using Key = core::input::Key;
     using EncoderEvent = core::input::EncoderEvent;
@@ -89,9 +151,15 @@ namespace otto::services {
     using KeyHandler = std::function<void(Key k)>;
 
     using Event = std::variant<EncoderEvent, KeyPressEvent, KeyReleaseEvent>;
-    using EventBag = std::vector<Event>;
+
+    /// The number of input events which can be queued for the logic thread. More are dropped.
+    static constexpr std::size_t event_queue_capacity = 256;
+    /// The number of tasks which can be queued for the logic thread with @ref post.
+    static constexpr std::size_t task_queue_capacity = 16;
 
     Controller();
+    /// Dispatches the queued events, and stops the logic thread
+    ~Controller() noexcept;
 
     static std::unique_ptr<Controller> make_dummy();
     static Controller& current() noexcept
@@ -114,6 +182,16 @@ namespace otto::services {
       util::Signal<Event> on_input;
     } signals;
 
+    /// Time from an input event being read, until it is dispatched on the logic thread
+    util::LatencyHistogram input_latency;
+
+    /// Run `task` on the logic thread, after the input events queued before it
+    ///
+    /// Thread safe. Use this to read state owned by the logic thread, like the props of the engines.
+    ///
+    /// \returns false if the task was not queued, because the queue is full or the controller is stopping
+    bool post(std::function<void()> task);
+
   protected:
     /// Dispatches to the event handler for the current screen, and handles
     /// global keys.
@@ -129,22 +207,66 @@ namespace otto::services {
 
     /// Send encoder event
     ///
-    /// Can be executed from a separate thread
+    /// Can be executed from a separate thread. Steps of the same encoder are summed until the logic
+    /// thread gets to them, so turning an encoder quickly only dispatches one event.
     void encoder(EncoderEvent ev) override;
 
+    /// When the input event being dispatched was read from the hardware
+    ///
+    /// Board controllers set this before calling @ref keypress and @ref keyrelease, so the
+    /// key-to-sound latency includes the time spent before the dispatch. If it is not set, midi
+    /// events are stamped when they are sent.
+    util::latency_clock::time_point input_time_ = {};
+
     /// Temporary solution
     ///
     /// @TODO replace with something cleaner
     friend void ::otto::board::ui::handle_keyevent(board::ui::Action, board::ui::Modifiers, board::ui::Key);
 
   private:
+    /// An input event, and when it was read
+    struct TimedEvent {
+      Event event;
+      util::latency_clock::time_point time;
+    };
+
     bool handle_global(Key key, bool is_press = true);
+    void push_event(Event event);
+    /// Dispatch all queued events, and run the posted tasks. Only called on the logic thread.
+    void dispatch_events();
+    void dispatch(Event& event);
 
     foonathan::array::flat_map<Key, std::pair<KeyHandler, KeyHandler>> key_handlers;
     std::array<bool, Key::_size()> keys;
-    util::double_buffered<EventBag> events_;
+    util::mpsc_queue<TimedEvent, event_queue_capacity> events_;
+    util::mpsc_queue<std::function<void()>, task_queue_capacity> tasks_;
+    /// Encoder steps which are not yet dispatched.
+    ///
+    /// Only the step which makes a sum nonzero queues an event. The logic thread takes the sum
+    /// when it gets to that event.
+    std::array<std::atomic_int, core::input::Encoder::_size()> encoder_steps_ = {};
+    std::atomic_bool stopping_ = false;
+    util::wake_flag wake_;
 
     /// Essentially the logic thread, since most logic will happen in key handlers and property change events
-    util::triggered_thread key_handler_thread;
+    std::optional<util::thread> key_handler_thread;
   };
+
+  template<typename Func>
+  int LEDFramebuffer::take_changes(Func&& f)
+  {
+    auto lock = std::unique_lock(mutex_);
+    auto now = chrono::clock::now();
+    if (now - last_batch_ < min_interval_) return 0;
+    int res = 0;
+    for (auto key : core::input::Key::_values()) {
+      if (!send_all_ && colors_[key] == sent_[key]) continue;
+      sent_[key] = colors_[key];
+      f(LED{key}, colors_[key]);
+      res++;
+    }
+    send_all_ = false;
+    if (res > 0) last_batch_ = now;
+    return res;
+  }
 } // namespace otto::services
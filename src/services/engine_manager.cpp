@@ -9,17 +9,18 @@
 #include "engines/arps/ARP/arp.hpp"
 #include "engines/fx/chorus/chorus.hpp"
 #include "engines/fx/wormhole/wormhole.hpp"
-#include "engines/misc/looper/screen.hpp"
+#include "engines/misc/looper/looper.hpp"
 #include "engines/misc/mixer/screen.hpp"
 #include "engines/misc/sampler/screen.hpp"
-#include "engines/misc/sequencer/screen.hpp"
 #include "engines/misc/saveslots/screen.hpp"
+#include "engines/misc/sequencer/sequencer.hpp"
 #include "engines/synths/OTTOFM/ottofm.hpp"
 #include "engines/synths/goss/goss.hpp"
 #include "engines/twists/twist1/screen.hpp"
 #include "engines/twists/twist2/screen.hpp"
 #include "services/application.hpp"
 #include "services/clock_manager.hpp"
+#include "services/log_manager.hpp"
 
 namespace otto::services {
 
@@ -31,8 +32,12 @@ namespace otto::services {
 
     void start() override;
     audio::ProcessData<2> process(audio::ProcessData<1> external_in) override;
+    audio::ProcessData<2> process(audio::ProcessData<1> external_in, std::array<float*, 2> out) override;
 
   private:
+    /// Process everything up to the master stage
+    audio::ProcessData<2> process_engines(audio::ProcessData<1> external_in);
+
     using EffectsDispatcher = EngineDispatcher< //
       EngineType::effect,
       engine::OffEngine<EngineType::effect>,
@@ -57,17 +62,26 @@ namespace otto::services {
     // Placeholder screens for future features
     engines::twist1::Screen twist1screen;
     engines::twist2::Screen twist2screen;
-    engines::looper::Screen looperscreen;
     engines::sampler::Screen samplerscreen;
-    engines::sequencer::Screen sequencerscreen;
     engines::mixer::Screen mixerscreen;
     engines::saveslots::Screen savescreen;
 
     engines::sends::Sends synth_send;
+    engines::sends::Sends line_in_send;
 
-    // engines::Sends line_in_send;
+    engines::sequencer::Sequencer sequencer;
+    engines::looper::Looper looper;
     engines::master::Master master;
-    // engines::Sequencer sequencer;
+
+    /// Preallocated storage for the synth output and the busses of the mixing matrix:
+    /// synth, dry left, dry right, fx1 and fx2, each `bus_size_` samples long.
+    std::vector<float> bus_data_;
+    std::size_t bus_size_ = 0;
+    int bus_refs_ = 0;
+
+    void reserve_busses(std::size_t nframes);
+    /// Write silence to `out`, for a buffer larger than the busses. They are never grown on the audio thread.
+    audio::ProcessData<2> silence(audio::ProcessData<1> external_in, std::array<float*, 2> out) noexcept;
   };
 
   std::unique_ptr<EngineManager> EngineManager::create_default()
@@ -77,6 +91,13 @@ namespace otto::services {
 
   DefaultEngineManager::DefaultEngineManager()
   {
+    reserve_busses(AudioManager::current().buffer_size());
+    AudioManager::current().events.buffer_size_change.connect([this](int bs) {
+      if (std::size_t(bs) > bus_size_) reserve_busses(bs);
+    });
+    // The line input is not monitored until its send is turned up
+    line_in_send.props.volume.set(0);
+
     auto& ui_manager = *Application::current().ui_manager;
     auto& state_manager = *Application::current().state_manager;
     auto& controller = *Application::current().controller;
@@ -85,15 +106,18 @@ namespace otto::services {
 
     reg_ss(ScreenEnum::routing, [&]() { return (ui::ScreenAndInput){mixerscreen, mixerscreen.input}; });
     reg_ss(ScreenEnum::saveslots, [&]() { return (ui::ScreenAndInput){savescreen, savescreen.input}; });
-    reg_ss(ScreenEnum::sends, [&]() { return synth_send.screen(); });
+    reg_ss(ScreenEnum::sends, [&]() {
+      if (ui_manager.state.active_channel == ChannelEnum::external) return line_in_send.screen();
+      return synth_send.screen();
+    });
     reg_ss(ScreenEnum::fx1, [&]() { return effect1.engine_screen(); });
     reg_ss(ScreenEnum::fx1_selector, [&]() { return effect1.selector_screen(); });
     reg_ss(ScreenEnum::fx2, [&]() { return effect2.engine_screen(); });
     reg_ss(ScreenEnum::fx2_selector, [&]() { return effect2.selector_screen(); });
-    reg_ss(ScreenEnum::looper, [&]() { return (ui::ScreenAndInput){looperscreen, looperscreen.input}; });
+    reg_ss(ScreenEnum::looper, [&]() { return looper.screen(); });
     reg_ss(ScreenEnum::arp, [&]() { return arpeggiator.engine_screen(); });
     reg_ss(ScreenEnum::arp_selector, [&]() { return arpeggiator.selector_screen(); });
-    reg_ss(ScreenEnum::sequencer, [&]() { return (ui::ScreenAndInput){sequencerscreen, sequencerscreen.input}; });
+    reg_ss(ScreenEnum::sequencer, [&]() { return sequencer.screen(); });
     reg_ss(ScreenEnum::sampler, [&]() { return (ui::ScreenAndInput){samplerscreen, samplerscreen.input}; });
     reg_ss(ScreenEnum::master, [&]() { return master.screen(); });
     // reg_ss(ScreenEnum::sampler_envelope, [&]() -> auto& { return sequencer.envelope_screen(); });
@@ -121,6 +145,8 @@ namespace otto::services {
     controller.register_key_handler(input::Key::sequencer,
                                     [&](input::Key k) { ui_manager.display(ScreenEnum::sequencer); });
 
+    controller.register_key_handler(input::Key::play, [&](input::Key k) { sequencer.toggle_play(); });
+
     controller.register_key_handler(input::Key::sampler,
                                     [&](input::Key k) { ui_manager.display(ScreenEnum::sampler); });
 
@@ -207,9 +233,10 @@ namespace otto::services {
       util::deserialize(synth, data["Synth"]);
       util::deserialize(effect1, data["Effect1"]);
       util::deserialize(effect2, data["Effect2"]);
+      util::deserialize(looper, data["Looper"]);
+      util::deserialize(sequencer, data["Sequencer"]);
       // master.from_json(data["Master"]);
       // arpeggiator.from_json(data["Arpeggiator"]);
-      // sequencer.from_json(data["Sequencer"]);
     };
 
     auto save = [&] {
@@ -217,81 +244,110 @@ namespace otto::services {
         {"Synth", util::serialize(synth)}, //
         {"Effect1", util::serialize(effect1)},
         {"Effect2", util::serialize(effect2)},
+        {"Looper", util::serialize(looper)},
+        {"Sequencer", util::serialize(sequencer)},
         // {"Master", master.to_json()},
         // {"Arpeggiator", arpeggiator.to_json()},
-        // {"Sequencer", sequencer.to_json()},
       });
     };
 
     state_manager.attach("Engines", load, save);
+    // Engine state only changes in response to input
+    controller.signals.on_input.connect([&state_manager](auto&&) { state_manager.mark_dirty("Engines"); });
   }
 
   void DefaultEngineManager::start() {}
 
+  void DefaultEngineManager::reserve_busses(std::size_t nframes)
+  {
+    bus_size_ = nframes;
+    bus_data_.assign(5 * nframes, 0.f);
+  }
+
+  audio::ProcessData<2> EngineManager::process(audio::ProcessData<1> external_in, std::array<float*, 2> out)
+  {
+    auto res = process(std::move(external_in));
+    std::copy(res.audio[0].begin(), res.audio[0].end(), out[0]);
+    std::copy(res.audio[1].begin(), res.audio[1].end(), out[1]);
+    return res;
+  }
+
   audio::ProcessData<2> DefaultEngineManager::process(audio::ProcessData<1> external_in)
   {
-    // Main processor function
-    auto midi_in = external_in.midi_only();
-    midi_in.clock = ClockManager::current().step_frames(external_in.nframes);
-    auto arp_out = arpeggiator.process(midi_in);
-    auto synth_out = synth.process(arp_out.with(external_in.audio));
-    auto right_chan = Application::current().audio_manager->buffer_pool().allocate();
+    if (std::size_t(external_in.nframes) > bus_size_) {
+      // The input buffer is the only one long enough
+      float* in = external_in.audio.data();
+      return silence(std::move(external_in), {in, in});
+    }
+    return master.audio->process(process_engines(std::move(external_in)));
+  }
 
-    nano::copy(synth_out.audio, right_chan.begin());
+  audio::ProcessData<2> DefaultEngineManager::process(audio::ProcessData<1> external_in, std::array<float*, 2> out)
+  {
+    if (std::size_t(external_in.nframes) > bus_size_) return silence(std::move(external_in), out);
+    return master.audio->process(process_engines(std::move(external_in)), out);
+  }
 
-    auto fx1_bus = Application::current().audio_manager->buffer_pool().allocate();
-    auto fx2_bus = Application::current().audio_manager->buffer_pool().allocate();
+  audio::ProcessData<2> DefaultEngineManager::silence(audio::ProcessData<1> external_in,
+                                                      std::array<float*, 2> out) noexcept
+  {
+    // Audio managers announce buffer size changes through `buffer_size_change`,
+    // so this only happens if one grew the buffers without doing so.
+    const int nframes = external_in.nframes;
+    RT_LOGE("Got a buffer of {} frames, but the busses only hold {}. Outputting silence", nframes, int(bus_size_));
+    std::fill_n(out[0], nframes, 0.f);
+    std::fill_n(out[1], nframes, 0.f);
+    return audio::ProcessData<2>(
+      {audio::AudioBufferHandle(out[0], nframes, bus_refs_), audio::AudioBufferHandle(out[1], nframes, bus_refs_)},
+      std::move(external_in.midi), external_in.clock);
+  }
 
-    for (auto&& [snth, fx1, fx2] : util::zip(synth_out.audio, fx1_bus, fx2_bus)) {
-      fx1 = snth * 0.25; // * synth_send.props.to_FX1;
-      fx2 = snth * 0.25; // * synth_send.props.to_FX2;
+  audio::ProcessData<2> DefaultEngineManager::process_engines(audio::ProcessData<1> external_in)
+  {
+    // Main processor function
+    auto midi_in = external_in.midi_only();
+    midi_in.clock = ClockManager::current().step_frames(external_in.nframes);
+    auto seq_out = sequencer.audio->process(midi_in);
+    auto arp_out = arpeggiator.process(seq_out);
+
+    // Larger buffers are caught by `process`
+    const auto nframes = external_in.nframes;
+
+    auto bus = [&](int i) { return audio::AudioBufferHandle(bus_data_.data() + i * bus_size_, nframes, bus_refs_); };
+    auto dry_l = bus(1);
+    auto dry_r = bus(2);
+    auto fx1_bus = bus(3);
+    auto fx2_bus = bus(4);
+
+    // The synth gets its own buffer, so the line input is kept intact
+    auto synth_out = synth.process(arp_out.with(bus(0)));
+
+    // Mixing matrix. Sources are mixed into the dry and fx busses in one pass.
+    // TODO: Add the sampler as a source, once it produces audio
+    auto synth_gains = synth_send.audio->ramp(nframes);
+    auto line_in_gains = line_in_send.audio->ramp(nframes);
+    for (auto&& [snth, line_in, l, r, fx1, fx2] :
+         util::zip(synth_out.audio, external_in.audio, dry_l, dry_r, fx1_bus, fx2_bus)) {
+      auto sg = synth_gains.next();
+      auto lg = line_in_gains.next();
+      l = snth * sg.dry_l + line_in * lg.dry_l;
+      r = snth * sg.dry_r + line_in * lg.dry_r;
+      fx1 = snth * sg.fx1 + line_in * lg.fx1;
+      fx2 = snth * sg.fx2 + line_in * lg.fx2;
     }
+
     auto fx1_out = effect1.process(audio::ProcessData<1>(fx1_bus));
     auto fx2_out = effect2.process(audio::ProcessData<1>(fx2_bus));
 
-    // Temporary. Get only synth output for testing
-    for (auto&& [snth, l, r] : util::zip(synth_out.audio, fx1_out.audio[0], fx1_out.audio[1])) {
-      l = r = snth;
-    }
-    return master.audio->process(fx1_out);
-    // // Sequencer. Outputs L/R dry output and adds to fx busses.
-    // // auto seq_dry = sequencer.process(midi_in, fx1_bus, fx2_bus);
-    // auto fx1_out = effect1->process(audio::ProcessData<1>(fx1_bus));
-    // auto fx2_out = effect2->process(audio::ProcessData<1>(fx2_bus));
-
     // Stereo output gathered in fx1_out
-    // for (auto&& [snth, fx1L, fx1R, fx2L, fx2R] :
-    //      util::zip(synth_out.audio, fx1_out.audio[0], fx1_out.audio[1], fx2_out.audio[0], fx2_out.audio[1])) {
-    //   fx1L += fx2L + snth * 0.5; // * synth_send.props.dry * (1 - synth_send.props.dry_pan);
-    //   fx1R += fx2R + snth * 0.5; // * synth_send.props.dry * (1 + synth_send.props.dry_pan);
-    // }
-
-
-
-    // return master.audio->process(std.move(fx1_out));
-    // synth_out.audio.release();
-    // fx2_out.audio[0].release();
-    // fx2_out.audio[1].release();
-    // fx1_bus.release();
-    // fx2_bus.release();
-
-
-    // auto smplr_out = sequencer.process(midi_in);
-    // for (auto&& [resL, resR, smplr] : util::zip(fx1_out.audio[0], fx1_out.audio[1], smplr_out.audio)) {
-    //   resL += smplr;
-    //   resR += smplr;
-    // }
-
+    for (auto&& [fx1L, fx1R, fx2L, fx2R, l, r] :
+         util::zip(fx1_out.audio[0], fx1_out.audio[1], fx2_out.audio[0], fx2_out.audio[1], dry_l, dry_r)) {
+      fx1L += fx2L + l;
+      fx1R += fx2R + r;
+    }
 
-    // return master.process(std::move(fx1_out));
-    /*
-    auto temp = Application::current().audio_manager->buffer_pool().allocate_multi_clear<2>();
-    for (auto&& [in, tmp] : util::zip(seq_out, temp)) {
-    std::get<0>(tmp) += std::get<0>(in);
-        std::get<1>(tmp) += std::get<0>(in);
-        }
-    return master.process({std::move(temp),external_in.midi,external_in.nframes});
-    */
+    fx1_out.clock = midi_in.clock;
+    return looper.audio->process(std::move(fx1_out));
   }
 
 } // namespace otto::services
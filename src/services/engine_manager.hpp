@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <unordered_map>
 
 #include "core/service.hpp"
@@ -47,6 +48,13 @@ namespace otto::services {
     /// Process the engine audio chain
     virtual core::audio::ProcessData<2> process(core::audio::ProcessData<1> external_in) = 0;
 
+    /// Process the engine audio chain, writing the stereo output to `out`
+    ///
+    /// Lets audio drivers with planar buffers have the output written straight into their own
+    /// buffers. `out` must hold `external_in.nframes` samples per channel.
+    /// The default implementation copies the output of the above overload.
+    virtual core::audio::ProcessData<2> process(core::audio::ProcessData<1> external_in, std::array<float*, 2> out);
+
     /// For now, this is the way to get the default EngineManager implementation
     /// 
     /// This is very likely to be changed in the future
@@ -1,5 +1,6 @@
 #include "log_manager.hpp"
 #include "services/application.hpp"
+#include "util/rt_sanitizer.hpp"
 
 #define LOGURU_IMPLEMENTATION 1
 #include <loguru.hpp>
@@ -7,6 +8,13 @@
 namespace otto::services {
 
   LogManager::LogManager(int argc, char* argv[], bool enable_console, const char* logFilePath)
+    : rt_log_thread_([this](auto&&) {
+        // Flushes once more when woken up by the destructor
+        while (rt_log_thread_.running()) {
+          rt_log_thread_.sleep_for(chrono::milliseconds(20));
+          rt_log::flush();
+        }
+      })
   {
     static bool initialized = false;
     if (initialized) return;
@@ -35,6 +43,11 @@ namespace otto::services {
                                    std::string(message.prefix) + message.message);
     });
 
+#if OTTO_RT_SANITIZER
+    loguru::add_callback("rt_sanitizer", [](void*, const loguru::Message&) { util::rt_sanitizer::check("logging"); },
+                         nullptr, loguru::Verbosity_MAX);
+#endif
+
     LOGI("LOGGING NOW");
     initialized = true;
   }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "util/filesystem.hpp"
+#include "util/thread.hpp"
 
 #include "core/service.hpp"
 
@@ -22,6 +23,10 @@ namespace otto::services {
 
     /// Set how the current thread appears in the log
     void set_thread_name(const std::string& name);
+
+  private:
+    /// Passes the messages from the `RT_LOG` macros on to loguru
+    util::sleeper_thread rt_log_thread_;
   };
 
 } // namespace otto::services
@@ -121,3 +126,5 @@ namespace otto {
 #define OTTO_UNREACHABLE \
  (DEBUG_UNREACHABLE(::otto::assert_module{}), DEBUG_ASSERT_MARK_UNREACHABLE)
 #define OTTO_UNREACHABLE_M(...) (DEBUG_UNREACHABLE(::otto::assert_module{}, __VA_ARGS__), DEBUG_ASSERT_MARK_UNREACHABLE)
+
+#include "services/rt_log.hpp"
@@ -0,0 +1,216 @@
+#include "preset_bank.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+
+#include "util/jsonfile.hpp"
+
+#include "services/log_manager.hpp"
+
+namespace otto::services {
+
+  namespace {
+    constexpr char magic[4] = {'O', 'T', 'P', 'B'};
+
+    template<typename T>
+    void write_int(std::ostream& os, T val)
+    {
+      for (std::size_t i = 0; i < sizeof(T); i++) {
+        os.put(static_cast<char>((val >> (8 * i)) & 0xFF));
+      }
+    }
+
+    template<typename T>
+    T read_int(std::istream& is)
+    {
+      unsigned char bytes[sizeof(T)];
+      is.read(reinterpret_cast<char*>(bytes), sizeof(T));
+      T res = 0;
+      for (std::size_t i = 0; i < sizeof(T); i++) {
+        res |= T(bytes[i]) << (8 * i);
+      }
+      return res;
+    }
+
+    void write_str(std::ostream& os, const std::string& str)
+    {
+      write_int<std::uint32_t>(os, str.size());
+      os.write(str.data(), str.size());
+    }
+
+    std::string read_str(std::istream& is)
+    {
+      auto size = read_int<std::uint32_t>(is);
+      // Guards against allocating huge strings from a corrupt file
+      if (!is || size > 4096) return {};
+      std::string res(size, '\0');
+      is.read(res.data(), size);
+      return res;
+    }
+
+    std::uint64_t mtime_of(const fs::path& p)
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(fs::last_write_time(p).time_since_epoch()).count();
+    }
+  } // namespace
+
+  PresetBank::PresetBank(fs::path bank_file) : bank_file_(std::move(bank_file))
+  {
+    read_index();
+  }
+
+  void PresetBank::read_index()
+  {
+    entries_.clear();
+    blobs_start_ = 0;
+    std::ifstream is(bank_file_.c_str(), std::ios::binary);
+    if (!is) return;
+    char m[4];
+    is.read(m, 4);
+    auto file_version = read_int<std::uint32_t>(is);
+    auto count = read_int<std::uint32_t>(is);
+    if (!is || !std::equal(m, m + 4, magic) || file_version != version) {
+      LOGI("Ignoring invalid or outdated preset bank {}", bank_file_);
+      return;
+    }
+    std::vector<Entry> entries;
+    entries.reserve(std::min<std::uint32_t>(count, 4096));
+    for (std::uint32_t i = 0; i < count; i++) {
+      Entry e;
+      e.engine = read_str(is);
+      e.name = read_str(is);
+      e.source = read_str(is);
+      e.mtime = read_int<std::uint64_t>(is);
+      e.size = read_int<std::uint64_t>(is);
+      e.offset = read_int<std::uint64_t>(is);
+      e.length = read_int<std::uint32_t>(is);
+      if (!is) {
+        LOGI("Ignoring truncated preset bank {}", bank_file_);
+        return;
+      }
+      entries.push_back(std::move(e));
+    }
+    blobs_start_ = is.tellg();
+    entries_ = std::move(entries);
+  }
+
+  std::vector<std::uint8_t> PresetBank::read_blob(const Entry& entry) const
+  {
+    std::ifstream is(bank_file_.c_str(), std::ios::binary);
+    is.seekg(blobs_start_ + entry.offset);
+    std::vector<std::uint8_t> res(entry.length);
+    is.read(reinterpret_cast<char*>(res.data()), res.size());
+    if (!is) {
+      throw exception(ErrorCode::invalid_bank, "Could not read preset '{}' for engine '{}' from {}", entry.name,
+                      entry.engine, bank_file_);
+    }
+    return res;
+  }
+
+  nlohmann::json PresetBank::load(const Entry& entry) const
+  {
+    return nlohmann::json::from_cbor(read_blob(entry));
+  }
+
+  int PresetBank::update(const fs::path& presets_dir)
+  {
+    std::unordered_map<std::string, const Entry*> old_entries;
+    for (auto& e : entries_) old_entries[e.source] = &e;
+
+    struct NewEntry {
+      Entry entry;
+      /// Empty for unchanged presets, which are copied from the old bank
+      std::vector<std::uint8_t> blob;
+    };
+    std::vector<NewEntry> new_entries;
+    int parsed = 0;
+    bool changed = false;
+
+    const auto prefix_len = presets_dir.string().size() + 1;
+    for (auto&& de : fs::recursive_directory_iterator(presets_dir)) {
+      if (de.is_directory()) continue;
+      auto filename = de.path().filename().string();
+      if (filename.size() == 0 || filename.c_str()[0] == '.') continue;
+      if (!de.is_regular_file() && !de.is_symlink()) continue;
+
+      Entry e;
+      e.source = de.path().string().substr(prefix_len);
+      e.size = fs::file_size(de.path());
+      e.mtime = mtime_of(de.path());
+
+      if (auto found = old_entries.find(e.source); found != old_entries.end()) {
+        auto& old = *found->second;
+        if (old.size == e.size && old.mtime == e.mtime) {
+          new_entries.push_back({old, {}});
+          continue;
+        }
+      }
+
+      try {
+        util::JsonFile jf{de.path()};
+        jf.read();
+        e.engine = jf.data()["engine"].get<std::string>();
+        e.name = jf.data()["name"].get<std::string>();
+        auto blob = nlohmann::json::to_cbor(jf.data()["props"]);
+        new_entries.push_back({std::move(e), {blob.begin(), blob.end()}});
+        parsed++;
+        changed = true;
+        DLOGI("Compiled preset '{}' for engine '{}'", new_entries.back().entry.name, new_entries.back().entry.engine);
+      } catch (std::exception& ex) {
+        LOGE("Error reading preset file {}: {}", de.path(), ex.what());
+      }
+    }
+
+    // Nothing was added, changed or removed
+    if (!changed && new_entries.size() == entries_.size()) return parsed;
+
+    for (auto& ne : new_entries) {
+      if (ne.blob.empty()) ne.blob = read_blob(ne.entry);
+    }
+
+    // Directory order is unspecified. Sort by path, so the preset order is stable
+    std::sort(new_entries.begin(), new_entries.end(),
+              [](const NewEntry& a, const NewEntry& b) { return a.entry.source < b.entry.source; });
+
+    std::uint64_t offset = 0;
+    for (auto& ne : new_entries) {
+      ne.entry.offset = offset;
+      ne.entry.length = ne.blob.size();
+      offset += ne.blob.size();
+    }
+
+    // Write to a temporary file, so a crash never leaves a broken bank behind
+    fs::path tmp = bank_file_.string() + ".tmp";
+    {
+      std::ofstream os(tmp.c_str(), std::ios::binary | std::ios::trunc);
+      os.write(magic, 4);
+      write_int<std::uint32_t>(os, version);
+      write_int<std::uint32_t>(os, new_entries.size());
+      for (auto& ne : new_entries) {
+        auto& e = ne.entry;
+        write_str(os, e.engine);
+        write_str(os, e.name);
+        write_str(os, e.source);
+        write_int<std::uint64_t>(os, e.mtime);
+        write_int<std::uint64_t>(os, e.size);
+        write_int<std::uint64_t>(os, e.offset);
+        write_int<std::uint32_t>(os, e.length);
+      }
+      for (auto& ne : new_entries) {
+        os.write(reinterpret_cast<const char*>(ne.blob.data()), ne.blob.size());
+      }
+      if (!os) {
+        throw exception(ErrorCode::invalid_bank, "Could not write the preset bank {}", tmp);
+      }
+    }
+    fs::rename(tmp, bank_file_);
+    LOGI("Updated preset bank with {} presets ({} compiled)", new_entries.size(), parsed);
+
+    read_index();
+    return parsed;
+  }
+
+} // namespace otto::services
+
+// kak: other_file=preset_bank.hpp
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <json.hpp>
+
+#include "util/exception.hpp"
+#include "util/filesystem.hpp"
+
+namespace otto::services {
+
+  /// A compiled index of the preset files.
+  ///
+  /// The bank file holds the engine and preset name of every preset file, and its props encoded as CBOR.
+  /// Only the index is kept in memory. The props of a preset are read from the bank and decoded
+  /// when it is applied, so boot time and memory use do not grow with the number of presets.
+  ///
+  /// The bank is rebuilt by @ref update when the preset files change. Files are identified by
+  /// their path, size and modification time, so only new or changed files are parsed.
+  ///
+  /// File layout, all integers little endian:
+  /// ```
+  /// "OTPB" u32:version u32:count
+  /// count * { str:engine str:name str:source u64:mtime u64:size u64:offset u32:length }
+  /// props blobs (CBOR)
+  /// ```
+  /// where `str` is a u32 length followed by the bytes, and `offset` is counted from the
+  /// start of the blobs.
+  struct PresetBank {
+    enum struct ErrorCode {
+      invalid_bank,
+    };
+
+    using exception = util::as_exception<ErrorCode>;
+
+    struct Entry {
+      std::string engine;
+      std::string name;
+      /// Path of the preset file, relative to the preset directory
+      std::string source;
+      std::uint64_t mtime = 0;
+      std::uint64_t size = 0;
+      std::uint64_t offset = 0;
+      std::uint32_t length = 0;
+    };
+
+    explicit PresetBank(fs::path bank_file);
+
+    /// Bring the bank up to date with the preset files in `presets_dir`, and load the index.
+    ///
+    /// Unchanged presets are copied from the old bank without parsing them.
+    /// Preset files which can not be parsed are logged and skipped.
+    ///
+    /// \returns the number of preset files which were parsed
+    int update(const fs::path& presets_dir);
+
+    const std::vector<Entry>& entries() const noexcept
+    {
+      return entries_;
+    }
+
+    /// Read and decode the props of a preset
+    nlohmann::json load(const Entry& entry) const;
+
+    static constexpr std::uint32_t version = 1;
+
+  private:
+    /// Read the index of the bank file. Leaves the index empty if the file is missing or invalid.
+    void read_index();
+    /// Read the raw props of `entry` from the current bank file
+    std::vector<std::uint8_t> read_blob(const Entry& entry) const;
+
+    fs::path bank_file_;
+    std::vector<Entry> entries_;
+    /// Offset of the blobs in the bank file
+    std::uint64_t blobs_start_ = 0;
+  };
+
+} // namespace otto::services
+
+// kak: other_file=preset_bank.cpp
@@ -1,6 +1,7 @@
 #include "preset_manager.hpp"
 
 #include "services/debug_ui.hpp"
+#include "services/preset_bank.hpp"
 
 #include "util/flat_map.hpp"
 
@@ -67,14 +68,19 @@ namespace otto::services {
 
     /// (Re)load preset files
     ///
-    /// Invoked by @ref init. Call to reload all preset files.
+    /// Invoked by the constructor. Updates the preset bank with the changed files, and loads
+    /// the names from it. The props are only read from the bank when a preset is applied.
     ///
     /// \throws @ref filesystem::filesystem_error
     void load_preset_files();
 
+    /// Decode the props of a preset from the bank, and apply them
+    void apply_preset_data(core::engine::IEngine& engine, int bank_idx);
+
     struct PresetNamesDataPair {
       std::vector<std::string> names;
-      std::vector<nlohmann::json> data;
+      /// Index of each preset in the bank
+      std::vector<int> bank_idx;
     };
 
     // Key is engine name.
@@ -83,6 +89,7 @@ namespace otto::services {
     util::flat_map<std::string, PresetNamesDataPair> _preset_data;
 
     const fs::path presets_dir = Application::current().data_dir / "presets";
+    PresetBank _bank{Application::current().data_dir / "presets.bank"};
   };
 
   std::unique_ptr<PresetManager> PresetManager::create_default() {
@@ -139,7 +146,7 @@ namespace otto::services {
     }
     DLOGI("Applying preset {} to engine {}", name, engine.name());
     int idx = niter - pd_iter->second.names.begin();
-    engine.from_json(pd_iter->second.data[idx]);
+    apply_preset_data(engine, pd_iter->second.bank_idx[idx]);
     engine.current_preset(idx);
   }
 
@@ -150,19 +157,24 @@ namespace otto::services {
       throw exception(ErrorCode::no_such_engine, "No engine named '{}'", engine.name());
     }
     auto& pd = pd_iter->second;
-    if (idx < 0 || static_cast<std::size_t>(idx) >= pd.data.size()) {
+    if (idx < 0 || static_cast<std::size_t>(idx) >= pd.bank_idx.size()) {
       throw exception(ErrorCode::no_such_preset, "Preset index {} is out range for engine '{}'",
                       idx, engine.name());
     }
     DLOGI("Applying preset {} to engine {}", pd.names[idx], engine.name());
     try {
-      engine.from_json(pd.data[idx]);
+      apply_preset_data(engine, pd.bank_idx[idx]);
     } catch(std::exception& e) {
       throw util::exception("Error applying preset: {}", e.what());
     }
     engine.current_preset(idx);
   }
 
+  void DefaultPresetManager::apply_preset_data(core::engine::IEngine& engine, int bank_idx)
+  {
+    engine.from_json(_bank.load(_bank.entries()[bank_idx]));
+  }
+
   void DefaultPresetManager::load_preset_files()
   {
     LOG_SCOPE_FUNCTION(INFO);
@@ -171,28 +183,26 @@ namespace otto::services {
       fs::create_directories(presets_dir);
     }
     DLOGI("Loading presets");
-    for (auto&& de : fs::recursive_directory_iterator(presets_dir)) {
-      if (de.is_directory()) continue;
-      auto filename = de.path().filename().string();
-      if (filename.size() == 0 || filename.c_str()[0] == '.') continue;
-      LOGI_SCOPE("Loading preset file {}", de.path());
-      if (de.is_regular_file() || de.is_symlink()) {
-        util::JsonFile jf{de.path()};
-        jf.read();
-        std::string engine = jf.data()["engine"];
-        std::string name = jf.data()["name"];
-        auto pd_iter = _preset_data.insert(engine, {}).first;
-        auto& pd = pd_iter->second;
-        if (auto found = nano::find(pd.names, name); found != pd.names.end()) {
-          pd.data[found - pd.names.begin()] = std::move(jf.data()["props"]);
-          DLOGI("Reloaded preset '{}' for engine '{}", name, engine);
-        } else {
-          pd.names.push_back(name);
-          pd.data.emplace_back(std::move(jf.data()["props"]));
-          DLOGI("Loaded preset '{}' for engine '{}", name, engine);
-        }
+    _bank.update(presets_dir);
+    // The names vectors are exposed by reference, so they are cleared instead of replaced
+    for (auto&& pd_pair : _preset_data) {
+      pd_pair.second.names.clear();
+      pd_pair.second.bank_idx.clear();
+    }
+    auto& entries = _bank.entries();
+    for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+      auto& entry = entries[i];
+      auto pd_iter = _preset_data.insert(entry.engine, {}).first;
+      auto& pd = pd_iter->second;
+      if (auto found = nano::find(pd.names, entry.name); found != pd.names.end()) {
+        // Two files with the same preset name. The last one wins, like when they were loaded one by one
+        pd.bank_idx[found - pd.names.begin()] = i;
+      } else {
+        pd.names.push_back(entry.name);
+        pd.bank_idx.push_back(i);
       }
     }
+    DLOGI("Loaded {} presets", entries.size());
   }
 
   void DefaultPresetManager::create_preset(util::string_ref engine_name,
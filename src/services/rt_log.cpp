@@ -0,0 +1,55 @@
+#include "rt_log.hpp"
+
+#include <atomic>
+#include <mutex>
+
+#include "util/mpsc_queue.hpp"
+
+namespace otto::services::rt_log {
+
+  namespace {
+    util::mpsc_queue<Entry, capacity> queue;
+    /// The queue only supports one consumer at a time
+    std::mutex consumer_mutex;
+    /// Drops taken from the queue by @ref dropped
+    std::atomic<std::size_t> total_dropped = 0;
+  } // namespace
+
+  bool detail::push(void (*fill)(Entry&, const void*), const void* ctx) noexcept
+  {
+    Entry entry;
+    fill(entry, ctx);
+    return queue.push(entry);
+  }
+
+  std::size_t flush(const std::function<void(const Entry&, const std::string&)>& sink)
+  {
+    std::unique_lock lock(consumer_mutex);
+    std::size_t n = 0;
+    while (auto entry = queue.pop()) {
+      sink(*entry, entry->to_string());
+      n++;
+    }
+    return n;
+  }
+
+  std::size_t flush()
+  {
+    static std::atomic<std::size_t> reported_drops = 0;
+    auto n = flush([](const Entry& e, const std::string& msg) { loguru::log(e.verbosity, e.file, e.line, "{}", msg); });
+    auto drops = dropped();
+    if (auto prev = reported_drops.exchange(drops); drops != prev) {
+      LOG_F(WARNING, "Dropped {} real-time log messages", drops - prev);
+    }
+    return n;
+  }
+
+  std::size_t dropped() noexcept
+  {
+    auto taken = queue.take_dropped();
+    return total_dropped.fetch_add(taken, std::memory_order_relaxed) + taken;
+  }
+
+} // namespace otto::services::rt_log
+
+// kak: other_file=rt_log.hpp
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#define LOGURU_USE_FMTLIB 1
+#include <loguru.hpp>
+
+/// Logging from the audio thread.
+///
+/// `LOGI` and friends format the message, and write it to the sinks under a lock, which may block
+/// the audio thread. The `RT_LOG` macros instead store the format string and the arguments in
+/// a fixed size lock-free queue. The messages are formatted and passed on to loguru by a background
+/// thread in @ref services::LogManager.
+///
+/// The arguments must be trivially copyable, and fit in @ref rt_log::max_args_size bytes.
+/// Strings (`const char*`) are stored as pointers, so they must outlive the message, like
+/// string literals do. If the queue is full, the message is dropped, and the number of dropped
+/// messages is logged later.
+namespace otto::services::rt_log {
+
+  /// Maximum number of queued messages
+  constexpr std::size_t capacity = 256;
+  /// Maximum combined size of the arguments of one message
+  constexpr std::size_t max_args_size = 64;
+
+  struct Entry {
+    using FormatFn = std::string (*)(const char* format, const void* args);
+
+    loguru::Verbosity verbosity;
+    const char* file;
+    unsigned line;
+    const char* format;
+    FormatFn format_fn;
+    alignas(std::max_align_t) std::array<std::byte, max_args_size> args;
+
+    std::string to_string() const
+    {
+      return format_fn(format, args.data());
+    }
+  };
+
+  namespace detail {
+    template<typename Tuple>
+    std::string format_tuple(const char* format, const void* args)
+    {
+      return std::apply([format](auto&... a) { return fmt::format(format, a...); },
+                        *static_cast<const Tuple*>(args));
+    }
+
+    /// Reserve a slot in the queue, and call `fill` with the entry.
+    ///
+    /// \returns false if the queue is full
+    bool push(void (*fill)(Entry&, const void* ctx), const void* ctx) noexcept;
+  } // namespace detail
+
+  /// Queue a message. Never blocks or allocates.
+  template<typename... Args>
+  void log(loguru::Verbosity verbosity, const char* file, unsigned line, const char* format, Args... args) noexcept
+  {
+    using Tuple = std::tuple<Args...>;
+    static_assert((std::is_trivially_copyable_v<Args> && ...),
+                  "The arguments of real-time log messages must be trivially copyable");
+    static_assert(sizeof(Tuple) <= max_args_size, "Too many arguments for a real-time log message");
+    static_assert(alignof(Tuple) <= alignof(std::max_align_t));
+
+    struct Ctx {
+      loguru::Verbosity verbosity;
+      const char* file;
+      unsigned line;
+      const char* format;
+      Tuple args;
+    } ctx{verbosity, file, line, format, {args...}};
+
+    detail::push(
+      [](Entry& e, const void* vctx) {
+        auto& ctx = *static_cast<const Ctx*>(vctx);
+        e.verbosity = ctx.verbosity;
+        e.file = ctx.file;
+        e.line = ctx.line;
+        e.format = ctx.format;
+        e.format_fn = &detail::format_tuple<Tuple>;
+        new (e.args.data()) Tuple(ctx.args);
+      },
+      &ctx);
+  }
+
+  /// Format the queued messages, and pass them to `sink`.
+  ///
+  /// \returns the number of messages
+  std::size_t flush(const std::function<void(const Entry&, const std::string&)>& sink);
+
+  /// Format the queued messages, and pass them on to loguru
+  std::size_t flush();
+
+  /// Number of messages dropped since the start, because the queue was full
+  std::size_t dropped() noexcept;
+
+} // namespace otto::services::rt_log
+
+#define OTTO_RT_LOG(verbosity, ...)                                                                                    \
+  ::otto::services::rt_log::log(loguru::Verbosity_##verbosity, __FILE__, __LINE__, __VA_ARGS__)
+
+/// Real-time safe version of LOGI
+#define RT_LOGI(...) OTTO_RT_LOG(INFO, __VA_ARGS__)
+
+/// Real-time safe version of LOGW
+#define RT_LOGW(...) OTTO_RT_LOG(WARNING, __VA_ARGS__)
+
+/// Real-time safe version of LOGE
+#define RT_LOGE(...) OTTO_RT_LOG(ERROR, __VA_ARGS__)
+
+/// Real-time safe version of LOGW_IF
+#define RT_LOGW_IF(cond, ...) ((cond) ? RT_LOGW(__VA_ARGS__) : void())
+
+/// Real-time safe version of LOGE_IF
+#define RT_LOGE_IF(cond, ...) ((cond) ? RT_LOGE(__VA_ARGS__) : void())
+
+// kak: other_file=rt_log.cpp
@@ -1,10 +1,17 @@
 #include "state_manager.hpp"
 
+#include <algorithm>
+#include <future>
+#include <mutex>
+#include <optional>
+
 #include "services/application.hpp"
+#include "services/controller.hpp"
 #include "services/log_manager.hpp"
 
 #include "util/exception.hpp"
 #include "util/jsonfile.hpp"
+#include "util/thread.hpp"
 
 namespace otto::services {
 
@@ -19,6 +26,41 @@ namespace otto::services {
     void attach(std::string name, Loader load, Saver save) override;
 
     void detach(std::string name) override;
+
+    void mark_dirty(const std::string& name) override;
+
+    /// Serialize the dirty clients on the logic thread, and write `data/state.json` if there were any
+    void snapshot() override;
+
+    /// Time between background snapshots
+    static constexpr auto snapshot_interval = chrono::seconds(5);
+
+  private:
+    /// The saved state of some clients, by name
+    using Snapshot = std::vector<std::pair<std::string, nlohmann::json>>;
+
+    /// Invoke the savers of the clients in `names`. Errors are logged.
+    Snapshot serialize(const std::vector<std::string>& names);
+
+    /// Invoke the savers of the clients in `names` on the logic thread, and wait for them.
+    ///
+    /// \returns nullopt if the logic thread did not get to it within `timeout`
+    std::optional<Snapshot> serialize_on_logic_thread(const std::vector<std::string>& names,
+                                                      chrono::duration timeout);
+
+    /// Store `snapshot` in `data_file`, and write it atomically. Errors are logged.
+    void write(Snapshot snapshot) noexcept;
+
+    /// Guards `_clients` and `_loaded`
+    std::mutex clients_mutex_;
+    /// Guards `data_file`. Always locked after `clients_mutex_`, if both are locked.
+    ///
+    /// Separate from `clients_mutex_`, so the logic thread never waits on a file being written.
+    std::mutex file_mutex_;
+    /// Guards `dirty_`. Separate from `clients_mutex_`, so @ref mark_dirty never waits on a snapshot
+    std::mutex dirty_mutex_;
+    std::vector<std::string> dirty_;
+    util::sleeper_thread snapshot_thread_;
   };
 
   std::unique_ptr<StateManager> StateManager::create_default()
@@ -27,16 +69,28 @@ namespace otto::services {
   }
 
   DefaultStateManager::DefaultStateManager()
-    : data_file(Application::current().data_dir / "state.json")
+    : data_file(Application::current().data_dir / "state.json"), snapshot_thread_([this](auto&&) {
+        while (snapshot_thread_.running()) {
+          snapshot_thread_.sleep_for(snapshot_interval);
+          if (!snapshot_thread_.running()) break;
+          snapshot();
+        }
+      })
   {
     Application::current().events.post_init.connect([this] { load(); });
-    Application::current().events.pre_exit.connect([this] { save(); });
+    Application::current().events.pre_exit.connect([this] {
+      // A snapshot written after the final save would overwrite it with older state
+      snapshot_thread_.join();
+      save();
+    });
   }
 
   DefaultStateManager::~DefaultStateManager() {}
 
   void DefaultStateManager::load()
   {
+    std::unique_lock lock(clients_mutex_);
+    std::unique_lock file_lock(file_mutex_);
     data_file.read(util::JsonFile::OpenOptions::create);
 
     auto& data = data_file.data();
@@ -62,23 +116,105 @@ namespace otto::services {
 
   void DefaultStateManager::save()
   {
-    if (!_loaded) {
-      return;
+    {
+      std::unique_lock lock(dirty_mutex_);
+      dirty_.clear();
+    }
+    std::vector<std::string> names;
+    {
+      std::unique_lock lock(clients_mutex_);
+      if (!_loaded) {
+        return;
+      }
+      for (const auto& [name, client] : _clients) names.push_back(name);
     }
 
-    auto& data = data_file.data();
+    auto snapshot = serialize_on_logic_thread(names, chrono::seconds(1));
+    if (!snapshot) {
+      // Better than losing the state
+      LOGW("The logic thread did not respond, saving the state from this thread");
+      snapshot = serialize(names);
+    }
+
+    {
+      std::unique_lock lock(file_mutex_);
+      data_file.data().clear();
+    }
+    write(std::move(*snapshot));
+  }
+
+  void DefaultStateManager::snapshot()
+  {
+    std::vector<std::string> dirty;
+    {
+      std::unique_lock lock(dirty_mutex_);
+      dirty.swap(dirty_);
+    }
+    if (dirty.empty()) return;
 
-    data.clear();
+    {
+      std::unique_lock lock(clients_mutex_);
+      if (!_loaded) return;
+    }
+
+    auto snapshot = serialize_on_logic_thread(dirty, snapshot_interval);
+    if (!snapshot) {
+      LOGW("The logic thread did not serialize the state in time, retrying with the next snapshot");
+      for (auto& name : dirty) mark_dirty(name);
+      return;
+    }
+
+    write(std::move(*snapshot));
+    DLOGI("Saved state of {} clients", dirty.size());
+  }
 
+  auto DefaultStateManager::serialize(const std::vector<std::string>& names) -> Snapshot
+  {
+    Snapshot res;
+    std::unique_lock lock(clients_mutex_);
     for (const auto& [name, client] : _clients) {
-      data[name] = client.save();
+      if (std::find(names.begin(), names.end(), name) == names.end()) continue;
+      try {
+        res.emplace_back(name, client.save());
+      } catch (std::exception& e) {
+        LOGE("Exception while saving state for {}: {}", name, e.what());
+      }
     }
+    return res;
+  }
+
+  auto DefaultStateManager::serialize_on_logic_thread(const std::vector<std::string>& names,
+                                                      chrono::duration timeout) -> std::optional<Snapshot>
+  {
+    // Shared, since the task may still run after a timeout
+    auto result = std::make_shared<std::promise<Snapshot>>();
+    auto future = result->get_future();
+    bool posted = Controller::current().post([this, result, names] { result->set_value(serialize(names)); });
+    if (!posted || future.wait_for(timeout) != std::future_status::ready) return std::nullopt;
+    return future.get();
+  }
+
+  void DefaultStateManager::write(Snapshot snapshot) noexcept
+  {
+    std::unique_lock lock(file_mutex_);
+    auto& data = data_file.data();
+    for (auto& [name, json] : snapshot) data[name] = std::move(json);
+    try {
+      data_file.write(util::JsonFile::OpenOptions::atomic);
+    } catch (std::exception& e) {
+      LOGE("Error writing {}: {}", data_file.path(), e.what());
+    }
+  }
 
-    data_file.write();
+  void DefaultStateManager::mark_dirty(const std::string& name)
+  {
+    std::unique_lock lock(dirty_mutex_);
+    if (std::find(dirty_.begin(), dirty_.end(), name) == dirty_.end()) dirty_.push_back(name);
   }
 
   void DefaultStateManager::attach(std::string name, Loader load, Saver save)
   {
+    std::unique_lock lock(clients_mutex_);
     if (_clients.find(name) != _clients.end()) {
       throw util::exception("Tried to attach a state client with the same name as another: " +
                             name);
@@ -88,6 +224,7 @@ namespace otto::services {
     _clients.insert_or_replace(name, Client{name, load, std::move(save)});
 
     if (_loaded) {
+      std::unique_lock file_lock(file_mutex_);
       auto& data = data_file.data();
       load(data[name]);
     }
@@ -95,6 +232,7 @@ namespace otto::services {
 
   void DefaultStateManager::detach(std::string name)
   {
+    std::unique_lock lock(clients_mutex_);
     if (_clients.find(name) == _clients.end()) {
       throw util::exception("Tried to detach a state client that was never attached: " + name);
     }
@@ -19,9 +19,24 @@ namespace otto::services {
     /// Read `data/state.json` and invoke attached loaders
     virtual void load() = 0;
 
-    /// Invoke attached savers and write `data/state.json`
+    /// Invoke all attached savers and write `data/state.json`
     virtual void save() = 0;
 
+    /// Mark the state of a client as changed
+    ///
+    /// The state is saved periodically in the background, but only the savers of the
+    /// clients marked as changed since the last time are invoked. Cheap enough to call
+    /// on every input event.
+    ///
+    /// The savers are invoked on the logic thread (see Controller::post), so they may read
+    /// the props without locking. Only the file is written on a background thread.
+    virtual void mark_dirty(const std::string& name) = 0;
+
+    /// Invoke the savers of the clients marked as changed, and write `data/state.json` if there were any
+    ///
+    /// This is what the periodic background save does.
+    virtual void snapshot() = 0;
+
     /// Attach state handler with a name
     ///
     /// \throws [otto::util::exception]() If a handler has already been attached
@@ -0,0 +1,153 @@
+#include "thread_policy.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <thread>
+
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "util/rt_sanitizer.hpp"
+
+#include "services/log_manager.hpp"
+
+namespace otto::services {
+
+  namespace {
+    /// Touch the stack of the calling thread, so it is mapped before it is needed
+    [[gnu::noinline]] void prefault_stack() noexcept
+    {
+      constexpr std::size_t size = 256 * 1024;
+      constexpr std::size_t page_size = 4096;
+      volatile char stack[size];
+      for (std::size_t i = 0; i < size; i += page_size) {
+        stack[i] = 0;
+      }
+      (void) stack;
+    }
+
+    const char* role_name(ThreadPolicy::Role role) noexcept
+    {
+      switch (role) {
+        case ThreadPolicy::Role::none: return "none";
+        case ThreadPolicy::Role::audio: return "audio";
+        case ThreadPolicy::Role::worker: return "worker";
+        case ThreadPolicy::Role::ui: return "ui";
+        case ThreadPolicy::Role::io: return "io";
+      }
+      return "";
+    }
+  } // namespace
+
+  ThreadPolicy& ThreadPolicy::current() noexcept
+  {
+    static ThreadPolicy instance;
+    return instance;
+  }
+
+  ThreadPolicy::Registration::Registration(Role role) noexcept : role_(role)
+  {
+    const bool realtime = role_ == Role::audio || role_ == Role::worker;
+    if (realtime) prefault_stack();
+    ThreadPolicy::current().add(pthread_self(), role_);
+    // After registering, which allocates
+    util::rt_sanitizer::set_realtime(realtime);
+  }
+
+  ThreadPolicy::Registration::~Registration() noexcept
+  {
+    if (role_ == Role::none) return;
+    util::rt_sanitizer::set_realtime(false);
+    ThreadPolicy::current().remove(pthread_self());
+  }
+
+  void ThreadPolicy::set_role(Role role) noexcept
+  {
+    thread_local std::optional<Registration> registration;
+    if (registration && registration->role() == role) return;
+    registration.reset();
+    if (role != Role::none) registration.emplace(role);
+  }
+
+  void ThreadPolicy::add(pthread_t thread, Role role) noexcept
+  {
+    std::unique_lock lock(mutex_);
+    auto& entry = threads_.emplace_back(Entry{thread, role});
+    if (applied_) apply_to(entry);
+  }
+
+  void ThreadPolicy::remove(pthread_t thread) noexcept
+  {
+    std::unique_lock lock(mutex_);
+    threads_.erase(std::remove_if(threads_.begin(), threads_.end(),
+                                  [&](const Entry& e) { return pthread_equal(e.thread, thread); }),
+                   threads_.end());
+  }
+
+  void ThreadPolicy::apply() noexcept
+  {
+    std::unique_lock lock(mutex_);
+    if (config.lock_memory) {
+      // Locks the audio buffers and everything else which is allocated, and everything allocated from now on
+      if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        LOGW("Could not lock memory: {}. Audio may glitch on page faults", std::strerror(errno));
+      } else {
+        LOGI("Locked memory");
+      }
+    }
+    if (!config.enabled) {
+      LOGI("Real-time scheduling is disabled");
+    }
+    applied_ = true;
+    for (auto& entry : threads_) apply_to(entry);
+  }
+
+  void ThreadPolicy::apply_to(const Entry& entry) noexcept
+  {
+    if (!config.enabled || entry.role == Role::none) return;
+
+    const bool realtime = entry.role == Role::audio || entry.role == Role::worker;
+    sched_param param = {};
+    int policy = SCHED_OTHER;
+    if (realtime) {
+      policy = SCHED_FIFO;
+      param.sched_priority = entry.role == Role::audio ? config.audio_priority : config.audio_priority - 1;
+      param.sched_priority =
+        std::clamp(param.sched_priority, sched_get_priority_min(policy), sched_get_priority_max(policy));
+    }
+    if (int err = pthread_setschedparam(entry.thread, policy, &param); err != 0) {
+      LOGW_IF(!warned_sched_, "Could not set the scheduling of the {} thread: {}. Running without real-time priority",
+              role_name(entry.role), std::strerror(err));
+      warned_sched_ = true;
+    }
+
+#if defined(__linux__)
+    const int ncpus = std::thread::hardware_concurrency();
+    const int reserved = std::clamp(config.reserved_cpus, 0, ncpus - 1);
+    if (reserved <= 0) return;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    switch (entry.role) {
+      case Role::audio: CPU_SET(ncpus - 1, &cpus); break;
+      case Role::worker:
+        for (int i = ncpus - reserved; i < ncpus; i++) CPU_SET(i, &cpus);
+        break;
+      case Role::ui: [[fallthrough]];
+      case Role::io:
+        for (int i = 0; i < ncpus - reserved; i++) CPU_SET(i, &cpus);
+        break;
+      case Role::none: return;
+    }
+    if (int err = pthread_setaffinity_np(entry.thread, sizeof(cpus), &cpus); err != 0) {
+      LOGW_IF(!warned_affinity_, "Could not set the CPU affinity of the {} thread: {}", role_name(entry.role),
+              std::strerror(err));
+      warned_affinity_ = true;
+    }
+#endif
+  }
+
+} // namespace otto::services
+
+// kak: other_file=thread_policy.hpp
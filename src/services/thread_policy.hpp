@@ -0,0 +1,120 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include <pthread.h>
+
+#include "core/service.hpp"
+
+namespace otto::services {
+
+  /// Configures scheduling, CPU affinity and memory locking of the threads in the application.
+  ///
+  /// Every thread tells the policy which role it plays, using @ref set_role. The audio thread
+  /// (and worker threads of the audio processing) are scheduled with a real-time priority, and
+  /// run on a set of reserved cores. The UI and I/O threads run with normal priority on the
+  /// remaining cores, so drawing a frame can not steal cycles from the audio.
+  ///
+  /// Threads may register before the configuration is applied, in which case the policy is
+  /// applied to them by @ref apply. Missing privileges are logged as warnings, and
+  /// the application keeps running with the default scheduling.
+  struct ThreadPolicy : core::Service {
+    enum struct Role {
+      /// Default scheduling, and no affinity
+      none,
+      /// The audio callback
+      audio,
+      /// Threads doing audio work, for the audio thread
+      worker,
+      /// The UI loop, and the logic thread dispatching input to it
+      ui,
+      /// Threads reading input and talking to hardware
+      io,
+    };
+
+    struct Config {
+      /// Use real-time scheduling and affinity at all
+      bool enabled = true;
+      /// SCHED_FIFO priority of the audio thread. Workers get one less.
+      int audio_priority = 80;
+      /// Number of cores reserved for the audio and worker threads, counted from the last core.
+      /// The audio thread runs on the last core.
+      int reserved_cpus = 1;
+      /// Lock all current and future memory, so the audio thread never hits a page fault
+      bool lock_memory = true;
+    };
+
+    /// Registration of a thread. Unregisters the thread when destroyed.
+    struct Registration {
+      Registration() = default;
+      Registration(Role role) noexcept;
+      ~Registration() noexcept;
+
+      Registration(const Registration&) = delete;
+      Registration& operator=(const Registration&) = delete;
+
+      Role role() const noexcept
+      {
+        return role_;
+      }
+
+    private:
+      Role role_ = Role::none;
+    };
+
+    static ThreadPolicy& current() noexcept;
+
+    template<typename Parser>
+    void add_args(Parser& cli);
+
+    Config config;
+
+    /// Lock memory, and apply the policy to the registered threads.
+    ///
+    /// Call this after parsing the arguments, and after the audio buffers are allocated, so they
+    /// are locked in memory as well.
+    void apply() noexcept;
+
+    /// Set the role of the calling thread.
+    ///
+    /// The thread is registered until it exits. Calling this again with the same role is cheap,
+    /// so it can be called at the start of every audio callback, when the driver owns the thread.
+    static void set_role(Role role) noexcept;
+
+  private:
+    ThreadPolicy() = default;
+
+    struct Entry {
+      pthread_t thread;
+      Role role;
+    };
+
+    void add(pthread_t thread, Role role) noexcept;
+    void remove(pthread_t thread) noexcept;
+    /// Apply the policy to a thread. Must be called with the mutex locked.
+    void apply_to(const Entry& entry) noexcept;
+
+    std::mutex mutex_;
+    std::vector<Entry> threads_;
+    bool applied_ = false;
+    /// Only warn about missing privileges once
+    bool warned_sched_ = false;
+    bool warned_affinity_ = false;
+  };
+
+#ifdef LYRA_OPT_HPP
+  template<typename Parser>
+  void ThreadPolicy::add_args(Parser& cli)
+  {
+    cli |= lyra::opt([this](bool b) { config.enabled = !b; })["--no-rt"](
+      "Do not use real-time scheduling or CPU affinity");
+    cli |= lyra::opt(config.audio_priority, "priority")["--rt-priority"]("Real-time priority of the audio thread");
+    cli |= lyra::opt(config.reserved_cpus, "n")["--rt-cpus"]("Number of cores reserved for audio processing");
+    cli |= lyra::opt([this](bool b) { config.lock_memory = !b; })["--no-mlock"]("Do not lock memory");
+  }
+#endif
+
+} // namespace otto::services
+
+// kak: other_file=thread_policy.cpp
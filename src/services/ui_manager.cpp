@@ -4,6 +4,8 @@
 #include "services/audio_manager.hpp"
 #include "services/engine_manager.hpp"
 #include "services/state_manager.hpp"
+#include "services/thread_policy.hpp"
+#include "util/rt_sanitizer.hpp"
 
 namespace otto::services {
 
@@ -94,6 +96,10 @@ namespace otto::services {
     Application::current().events.post_init.connect([&] {
       Controller::current().register_key_handler(Key::plus, [&](auto&&) { state.octave.step(1); });
       Controller::current().register_key_handler(Key::minus, [&](auto&&) { state.octave.step(-1); });
+      Controller::current().signals.on_input.connect([this](auto&&) {
+        mark_dirty();
+        Application::current().state_manager->mark_dirty("UI");
+      });
     });
 
     auto load = [this](const nlohmann::json& j) { util::deserialize(state, j); };
@@ -107,6 +113,7 @@ namespace otto::services {
     cur_sai.screen().on_hide();
     cur_sai = sai;
     cur_sai.screen().on_show();
+    mark_dirty();
   }
 
   core::ui::Screen& UIManager::current_screen()
@@ -124,9 +131,96 @@ namespace otto::services {
     screen_selectors_[se] = ss;
   }
 
+  bool UIManager::has_screen(ScreenEnum screen) const noexcept
+  {
+    return static_cast<bool>(screen_selectors_[screen]);
+  }
+
+  void UIManager::process_actions() noexcept
+  {
+    action_queue_.pop_call_all();
+  }
+
+  bool UIManager::needs_redraw() noexcept
+  {
+    auto now = chrono::clock::now();
+    if (now - last_telemetry_ >= chrono::seconds(1)) {
+      last_telemetry_ = now;
+      int cpu_percent = int(100 * Application::current().audio_manager->cpu_time());
+      int rt_violations = util::rt_sanitizer::violations();
+      auto& latency = Application::current().audio_manager->key_to_sound_latency;
+      int latency_ms = -1;
+      if (latency.count() > 0) {
+        latency_ms = chrono::duration_cast<chrono::milliseconds>(latency.percentile(0.99)).count();
+      }
+      if (cpu_percent != cpu_percent_ || rt_violations != rt_violations_ || latency_ms != latency_ms_) {
+        cpu_percent_ = cpu_percent;
+        rt_violations_ = rt_violations;
+        latency_ms_ = latency_ms;
+        dirty_ = true;
+      }
+    }
+    if (dirty_ || action_queue_.size() > 0 || !vg::timeline().empty()) return true;
+    int fps = current_screen().live_fps();
+    return fps > 0 && now - last_frame >= chrono::milliseconds(1000 / fps);
+  }
+
   void UIManager::draw_frame(vg::Canvas& ctx)
   {
+    // Cleared before the actions run and the screen is drawn, so changes made meanwhile cause another frame
+    dirty_ = false;
+    action_queue_.pop_call_all();
+    draw_screen(ctx);
+    Controller::current().flush_leds();
+    step_frame();
+  }
+
+  void UIManager::update_frame()
+  {
+    dirty_ = false;
     action_queue_.pop_call_all();
+    if (!recorder_) recorder_ = std::make_unique<vg::RecordingCanvas>(vg::width, vg::height);
+    recorder_->record_frame(back_frame_, [&](vg::Canvas& ctx) { draw_screen(ctx); });
+    {
+      std::lock_guard lock(frame_mutex_);
+      std::swap(back_frame_, pending_frame_);
+      new_frame_ = true;
+    }
+    step_frame();
+  }
+
+  void UIManager::render_frame(vg::Canvas& ctx)
+  {
+    if (new_frame_) {
+      std::lock_guard lock(frame_mutex_);
+      std::swap(pending_frame_, front_frame_);
+      new_frame_ = false;
+    }
+    front_frame_.replay(ctx);
+  }
+
+  void UIManager::start_logic_thread(float fps)
+  {
+    auto period = chrono::duration_cast<chrono::duration>(std::chrono::duration<float>(1 / fps));
+    logic_thread_.emplace([this, period](auto&& should_run) {
+      ThreadPolicy::set_role(ThreadPolicy::Role::ui);
+      while (should_run() && Application::current().running()) {
+        auto t0 = chrono::clock::now();
+        if (needs_redraw()) update_frame();
+        // Also when no frame is drawn, for LEDs set by the engines or the controller
+        Controller::current().flush_leds();
+        std::this_thread::sleep_until(t0 + period);
+      }
+    });
+  }
+
+  void UIManager::stop_logic_thread() noexcept
+  {
+    logic_thread_.reset();
+  }
+
+  void UIManager::draw_screen(vg::Canvas& ctx)
+  {
     ctx.lineWidth(6);
     ctx.lineCap(vg::LineCap::ROUND);
     ctx.lineJoin(vg::LineJoin::ROUND);
@@ -138,18 +232,29 @@ namespace otto::services {
         ctx.beginPath();
         ctx.fillStyle(vg::Colours::White);
         ctx.font(vg::Fonts::Norm, 12);
-        std::string cpu_time = fmt::format("{}%", int(100 * Application::current().audio_manager->cpu_time()));
-        ctx.fillText(cpu_time, {290, 230});
+        ctx.fillText(fmt::format("{}%", cpu_percent_), {290, 230});
+        if (latency_ms_ >= 0) {
+          ctx.fillText(fmt::format("{}ms", latency_ms_), {190, 230});
+        }
+        if (rt_violations_ > 0) {
+          ctx.fillStyle(vg::Colours::Red);
+          ctx.fillText(fmt::format("RT {}", rt_violations_), {240, 230});
+        }
       });
 
       signals.on_draw.emit(ctx);
     });
+  }
 
-    Controller::current().flush_leds();
+  void UIManager::step_frame()
+  {
     _frame_count++;
 
     auto now = chrono::clock::now();
-    vg::timeline().step(chrono::duration_cast<chrono::milliseconds>(now - last_frame).count());
+    // The UI may have been idle since the last frame. Animations started meanwhile should start
+    // from the beginning, not jump ahead by the idle time.
+    auto step = std::min(chrono::duration_cast<chrono::milliseconds>(now - last_frame), chrono::milliseconds(100));
+    vg::timeline().step(step.count());
     last_frame = now;
   }
 
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <json.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <type_safe/bounded_type.hpp>
 #include <type_safe/strong_typedef.hpp>
 #include <unordered_map>
@@ -13,6 +17,7 @@
 #include "services/application.hpp"
 #include "util/enum.hpp"
 #include "util/locked.hpp"
+#include "util/thread.hpp"
 
 #include "services/application.hpp"
 #include "services/controller.hpp"
@@ -85,10 +90,12 @@ namespace otto::services {
 
     /// The main ui loop
     ///
-    /// This sets up all the device specific graphics, and calls @ref draw_frame 60 times pr second,
-    /// until @ref Application::running() is false, or the graphics are exitted by the user. It is
-    /// also responsible for listening to keyevents, and calling @ref keypress and @ref keyrelease
-    /// as apropriate.
+    /// This sets up all the device specific graphics, and starts the logic thread with
+    /// @ref start_logic_thread. It then renders the frames recorded by the logic thread with
+    /// @ref render_frame whenever @ref has_new_frame returns true, up to a device specific frame
+    /// rate, until @ref Application::running() is false, or the graphics are exitted by the user.
+    /// It is also responsible for listening to keyevents, and calling @ref keypress and
+    /// @ref keyrelease as apropriate.
     ///
     /// On some platforms (OSX), all OpenGL calls must be made from the main
     /// thread, therefore this function is called from `main()`.
@@ -97,6 +104,15 @@ namespace otto::services {
     /// Select an engine
     void display(ScreenEnum screen);
 
+    /// Request a redraw of the current screen
+    ///
+    /// UI actions, input events and animations already cause a redraw, so this is only needed for
+    /// other changes. Thread safe.
+    void mark_dirty() noexcept
+    {
+      dirty_ = true;
+    }
+
     core::ui::Screen& current_screen();
     core::input::InputHandler& current_input_handler();
 
@@ -107,6 +123,11 @@ namespace otto::services {
 
     void register_screen_selector(ScreenEnum, ScreenSelector);
 
+    /// Check if a screen selector is registered for `screen`
+    ///
+    /// Only these screens can be shown with @ref display
+    bool has_screen(ScreenEnum screen) const noexcept;
+
     State state;
 
     struct {
@@ -126,9 +147,54 @@ namespace otto::services {
     auto make_sndr(Receivers&...) noexcept;
 
   protected:
+    /// Check if a new frame should be drawn
+    ///
+    /// True if the UI is dirty, a UI action is waiting, an animation is running, the telemetry overlay
+    /// changed, or the @ref core::ui::Screen::live_fps of the current screen calls for a new frame.
+    /// When this is false, the previous frame can be left on the display as is.
+    bool needs_redraw() noexcept;
+
     /// Draws the current screen and overlays.
+    ///
+    /// Runs the UI logic and draws on the calling thread. Boards with a display use
+    /// @ref start_logic_thread and @ref render_frame instead.
     void draw_frame(core::ui::vg::Canvas& ctx);
 
+    /// Run the UI logic on a separate thread, at up to `fps` frames per second
+    ///
+    /// The logic thread consumes the action queue, steps the animations and flushes the LEDs.
+    /// Whenever @ref needs_redraw, it records the current screen and overlays into a frame, which
+    /// is handed to the render thread. A slow LED flush or action handler then delays the next
+    /// frame, but not the drawing of the previous one, and a slow draw does not delay the LEDs.
+    ///
+    /// The thread runs until @ref stop_logic_thread is called, or the application exits.
+    void start_logic_thread(float fps);
+
+    /// Stop and join the logic thread
+    void stop_logic_thread() noexcept;
+
+    /// Run the UI logic for one frame, and record the frame for @ref render_frame
+    ///
+    /// This is what the logic thread does for each frame.
+    void update_frame();
+
+    /// Check if a frame was recorded since the last call to @ref render_frame
+    bool has_new_frame() const noexcept
+    {
+      return new_frame_;
+    }
+
+    /// Draw the newest recorded frame.
+    ///
+    /// Only replays the drawing commands of the frame, so it is cheap, and can not be delayed by
+    /// the UI logic. If there is no new frame, the previous one is drawn again.
+    void render_frame(core::ui::vg::Canvas& ctx);
+
+    /// Consume the action queue, without drawing.
+    ///
+    /// For ui managers without a display, which still need to handle the actions sent to the screens.
+    void process_actions() noexcept;
+
     /// Display a screen.
     ///
     /// Calls @ref Screen::on_hide for the old screen, and then @ref Screen::on_show
@@ -136,6 +202,11 @@ namespace otto::services {
     void display(core::ui::ScreenAndInput screen);
 
   private:
+    /// Draw the current screen and the overlays
+    void draw_screen(core::ui::vg::Canvas& ctx);
+    /// Count the frame, and step the animations
+    void step_frame();
+
     struct EmptyScreen : core::ui::Screen {
       void draw(core::ui::vg::Canvas& ctx) {}
     } empty_screen;
@@ -150,6 +221,29 @@ namespace otto::services {
 
     chrono::time_point last_frame = chrono::clock::now();
     itc::ActionQueue action_queue_;
+
+    std::atomic_bool dirty_ = true;
+    /// Telemetry shown in the overlay. Sampled once per second in @ref needs_redraw
+    chrono::time_point last_telemetry_ = chrono::clock::now();
+    int cpu_percent_ = 0;
+    int rt_violations_ = 0;
+    /// The 99th percentile of the key-to-sound latency, or -1 before any is recorded
+    int latency_ms_ = -1;
+
+    /// Records frames on the logic thread. Created by @ref update_frame.
+    std::unique_ptr<core::ui::vg::RecordingCanvas> recorder_;
+    /// The frame being recorded by the logic thread
+    core::ui::vg::DisplayList back_frame_;
+    /// The newest recorded frame, which the render thread has not taken yet
+    core::ui::vg::DisplayList pending_frame_;
+    /// The frame drawn by the render thread
+    core::ui::vg::DisplayList front_frame_;
+    /// Guards @ref pending_frame_. Only held while swapping lists.
+    std::mutex frame_mutex_;
+    std::atomic_bool new_frame_ = false;
+
+    /// Declared last, so it is joined before the other members are destroyed
+    std::optional<util::thread> logic_thread_;
   };
 
   template<typename... Receivers>
@@ -0,0 +1,234 @@
+#include "binary_serialize.hpp"
+
+#include <cstring>
+
+namespace otto::util {
+
+  namespace {
+    namespace major_type {
+      constexpr std::uint8_t unsigned_int = 0;
+      constexpr std::uint8_t negative_int = 1;
+      constexpr std::uint8_t bytes = 2;
+      constexpr std::uint8_t text = 3;
+      constexpr std::uint8_t array = 4;
+      constexpr std::uint8_t map = 5;
+      constexpr std::uint8_t tag = 6;
+      constexpr std::uint8_t simple = 7;
+    } // namespace major_type
+
+    constexpr std::uint8_t false_byte = 0xf4;
+    constexpr std::uint8_t true_byte = 0xf5;
+    constexpr std::uint8_t null_byte = 0xf6;
+    constexpr std::uint8_t float_byte = 0xfa;
+    constexpr std::uint8_t double_byte = 0xfb;
+  } // namespace
+
+  // CborWriter //
+
+  void CborWriter::head(std::uint8_t type, std::uint64_t arg)
+  {
+    type <<= 5;
+    auto put_be = [this](std::uint64_t v, int bytes) {
+      for (int i = bytes - 1; i >= 0; i--) out_.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+    };
+    if (arg < 24) {
+      out_.push_back(type | arg);
+    } else if (arg <= 0xFF) {
+      out_.push_back(type | 24);
+      put_be(arg, 1);
+    } else if (arg <= 0xFFFF) {
+      out_.push_back(type | 25);
+      put_be(arg, 2);
+    } else if (arg <= 0xFFFFFFFF) {
+      out_.push_back(type | 26);
+      put_be(arg, 4);
+    } else {
+      out_.push_back(type | 27);
+      put_be(arg, 8);
+    }
+  }
+
+  void CborWriter::null()
+  {
+    out_.push_back(null_byte);
+  }
+
+  void CborWriter::boolean(bool b)
+  {
+    out_.push_back(b ? true_byte : false_byte);
+  }
+
+  void CborWriter::integer(std::int64_t i)
+  {
+    if (i >= 0) head(major_type::unsigned_int, i);
+    else head(major_type::negative_int, -1 - i);
+  }
+
+  void CborWriter::unsigned_integer(std::uint64_t i)
+  {
+    head(major_type::unsigned_int, i);
+  }
+
+  void CborWriter::floating(float f)
+  {
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    out_.push_back(float_byte);
+    for (int i = 3; i >= 0; i--) out_.push_back(static_cast<std::uint8_t>(bits >> (8 * i)));
+  }
+
+  void CborWriter::floating(double d)
+  {
+    std::uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    out_.push_back(double_byte);
+    for (int i = 7; i >= 0; i--) out_.push_back(static_cast<std::uint8_t>(bits >> (8 * i)));
+  }
+
+  void CborWriter::text(std::string_view str)
+  {
+    head(major_type::text, str.size());
+    out_.insert(out_.end(), str.begin(), str.end());
+  }
+
+  void CborWriter::array(std::size_t size)
+  {
+    head(major_type::array, size);
+  }
+
+  void CborWriter::map(std::size_t size)
+  {
+    head(major_type::map, size);
+  }
+
+  void CborWriter::raw(const std::vector<std::uint8_t>& item)
+  {
+    out_.insert(out_.end(), item.begin(), item.end());
+  }
+
+  // CborReader //
+
+  const std::uint8_t* CborReader::take(std::size_t n)
+  {
+    if (static_cast<std::size_t>(end_ - pos_) < n) throw util::exception("Error: truncated binary data");
+    auto res = pos_;
+    pos_ += n;
+    return res;
+  }
+
+  std::pair<std::uint8_t, std::uint64_t> CborReader::head()
+  {
+    auto initial = *take(1);
+    std::uint8_t type = initial >> 5;
+    std::uint8_t info = initial & 0x1F;
+    if (info < 24) return {type, info};
+    if (info > 27) throw util::exception("Error: unsupported CBOR item {:#x}", initial);
+    int bytes = 1 << (info - 24);
+    auto data = take(bytes);
+    std::uint64_t arg = 0;
+    for (int i = 0; i < bytes; i++) arg = (arg << 8) | data[i];
+    return {type, arg};
+  }
+
+  std::uint64_t CborReader::head(std::uint8_t expected_type, const char* what)
+  {
+    auto [type, arg] = head();
+    if (type != expected_type) throw util::exception("Error: expected {} in binary data", what);
+    return arg;
+  }
+
+  std::uint8_t CborReader::peek_type() const
+  {
+    if (pos_ == end_) throw util::exception("Error: truncated binary data");
+    return *pos_ >> 5;
+  }
+
+  bool CborReader::null()
+  {
+    if (pos_ != end_ && *pos_ == null_byte) {
+      pos_++;
+      return true;
+    }
+    return false;
+  }
+
+  bool CborReader::boolean()
+  {
+    auto b = *take(1);
+    if (b == true_byte) return true;
+    if (b == false_byte) return false;
+    throw util::exception("Error: expected a boolean in binary data");
+  }
+
+  std::int64_t CborReader::integer()
+  {
+    auto [type, arg] = head();
+    if (type == major_type::unsigned_int) return static_cast<std::int64_t>(arg);
+    if (type == major_type::negative_int) return -1 - static_cast<std::int64_t>(arg);
+    throw util::exception("Error: expected an integer in binary data");
+  }
+
+  double CborReader::floating()
+  {
+    if (peek_type() != major_type::simple) return static_cast<double>(integer());
+    auto initial = *pos_;
+    auto [type, bits] = head();
+    if (initial == float_byte) {
+      float f;
+      auto bits32 = static_cast<std::uint32_t>(bits);
+      std::memcpy(&f, &bits32, sizeof(f));
+      return f;
+    }
+    if (initial == double_byte) {
+      double d;
+      std::memcpy(&d, &bits, sizeof(d));
+      return d;
+    }
+    throw util::exception("Error: expected a number in binary data");
+  }
+
+  std::string_view CborReader::text()
+  {
+    auto size = head(major_type::text, "a string");
+    auto data = take(size);
+    return {reinterpret_cast<const char*>(data), size};
+  }
+
+  std::size_t CborReader::array()
+  {
+    return head(major_type::array, "an array");
+  }
+
+  std::size_t CborReader::map()
+  {
+    return head(major_type::map, "a map");
+  }
+
+  void CborReader::skip()
+  {
+    auto [type, arg] = head();
+    switch (type) {
+      case major_type::bytes: [[fallthrough]];
+      case major_type::text: take(arg); break;
+      case major_type::array:
+        for (std::uint64_t i = 0; i < arg; i++) skip();
+        break;
+      case major_type::map:
+        for (std::uint64_t i = 0; i < 2 * arg; i++) skip();
+        break;
+      case major_type::tag: skip(); break;
+      // Integers and simple values have no content after the head
+      default: break;
+    }
+  }
+
+  std::vector<std::uint8_t> CborReader::raw()
+  {
+    auto start = pos_;
+    skip();
+    return {start, pos_};
+  }
+
+} // namespace otto::util
+
+// kak: other_file=binary_serialize.hpp
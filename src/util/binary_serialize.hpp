@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <gsl/span>
+
+#include "util/serialize.hpp"
+
+/// Binary serialization
+///
+/// A second backend for @ref otto::util::serialize, driven by the same reflection data, which
+/// streams objects directly to a [CBOR](https://cbor.io) buffer, and parses them back from it,
+/// without building a `nlohmann::json` tree in between. This makes it cheap enough to take
+/// snapshots of an engine often.
+///
+/// The output is regular CBOR. Registered classes are written as maps from member name to value,
+/// so members can be added, removed or reordered between versions. When deserializing, unknown
+/// members are skipped, and missing members are left as they are.
+///
+/// The types supported by the json serializer are supported here too. Types without a binary
+/// encoding fall back to encoding their json representation as CBOR.
+namespace otto::util {
+
+  /// Streams CBOR to a byte vector
+  struct CborWriter {
+    CborWriter(std::vector<std::uint8_t>& out) noexcept : out_(out) {}
+
+    void null();
+    void boolean(bool b);
+    void integer(std::int64_t i);
+    void unsigned_integer(std::uint64_t i);
+    void floating(float f);
+    void floating(double d);
+    void text(std::string_view str);
+    /// Start an array of `size` items
+    void array(std::size_t size);
+    /// Start a map of `size` key/value pairs
+    void map(std::size_t size);
+    /// Append an encoded CBOR item
+    void raw(const std::vector<std::uint8_t>& item);
+
+  private:
+    void head(std::uint8_t type, std::uint64_t arg);
+
+    std::vector<std::uint8_t>& out_;
+  };
+
+  /// Parses CBOR from a byte buffer, without copying it
+  ///
+  /// All functions throw @ref util::exception if the data does not have the expected type or
+  /// is truncated
+  struct CborReader {
+    CborReader(gsl::span<const std::uint8_t> data) noexcept : pos_(data.data()), end_(data.data() + data.size()) {}
+
+    /// Major type of the next item
+    std::uint8_t peek_type() const;
+    /// Check if the next item is null. Consumes it if it is.
+    bool null();
+    bool boolean();
+    std::int64_t integer();
+    /// Accepts floats, doubles and integers
+    double floating();
+    /// \returns a view into the buffer
+    std::string_view text();
+    /// \returns the number of items in the array
+    std::size_t array();
+    /// \returns the number of key/value pairs in the map
+    std::size_t map();
+    /// Skip the next item, including nested items
+    void skip();
+    /// \returns the raw bytes of the next item, and skips it
+    std::vector<std::uint8_t> raw();
+
+    bool at_end() const noexcept
+    {
+      return pos_ == end_;
+    }
+
+    /// The number of bytes left. Every item takes at least one.
+    std::size_t remaining() const noexcept
+    {
+      return end_ - pos_;
+    }
+
+  private:
+    /// Read the head of an item
+    ///
+    /// \returns the major type and the argument
+    std::pair<std::uint8_t, std::uint64_t> head();
+    std::uint64_t head(std::uint8_t expected_type, const char* what);
+    const std::uint8_t* take(std::size_t n);
+
+    const std::uint8_t* pos_;
+    const std::uint8_t* end_;
+  };
+
+  inline namespace serialization {
+
+    /////////////////// SERIALIZATION
+
+    template<typename Class>
+    void serialize_binary(CborWriter& w, const Class& obj);
+
+    void serialize_binary(CborWriter& w, const std::string& obj);
+
+    template<typename T, std::size_t N>
+    void serialize_binary(CborWriter& w, const std::array<T, N>& obj);
+
+    template<typename T>
+    void serialize_binary(CborWriter& w, const std::vector<T>& obj);
+
+    template<typename K, typename V>
+    void serialize_binary(CborWriter& w, const std::unordered_map<K, V>& obj);
+
+    template<typename... Types>
+    void serialize_binary(CborWriter& w, const std::tuple<Types...>& obj);
+
+    template<typename T1, typename T2>
+    void serialize_binary(CborWriter& w, const std::pair<T1, T2>& obj);
+
+    /// Serialize `obj` to `out`, along with the schema version
+    ///
+    /// `out` is cleared first, but keeps its capacity, so it can be reused for repeated snapshots.
+    /// The result is the CBOR array `[version, value]`.
+    template<typename Class>
+    void to_binary(std::vector<std::uint8_t>& out, const Class& obj, std::uint32_t version = 0);
+
+    /// Serialize `obj`, along with the schema version
+    template<typename Class>
+    std::vector<std::uint8_t> to_binary(const Class& obj, std::uint32_t version = 0);
+
+    /////////////////// DESERIALIZATION
+
+    template<typename Class>
+    void deserialize_binary(CborReader& r, Class& obj);
+
+    void deserialize_binary(CborReader& r, std::string& obj);
+
+    template<typename T, std::size_t N>
+    void deserialize_binary(CborReader& r, std::array<T, N>& obj);
+
+    template<typename T>
+    void deserialize_binary(CborReader& r, std::vector<T>& obj);
+
+    template<typename K, typename V>
+    void deserialize_binary(CborReader& r, std::unordered_map<K, V>& obj);
+
+    template<typename... Types>
+    void deserialize_binary(CborReader& r, std::tuple<Types...>& obj);
+
+    template<typename T1, typename T2>
+    void deserialize_binary(CborReader& r, std::pair<T1, T2>& obj);
+
+    /// Deserialize `obj` from the output of @ref to_binary
+    ///
+    /// \returns the schema version the data was written with, so the caller can migrate old data
+    /// \throws @ref util::exception if the data is invalid
+    template<typename Class>
+    std::uint32_t from_binary(Class& obj, gsl::span<const std::uint8_t> data);
+
+  } // namespace serialization
+} // namespace otto::util
+
+#include "binary_serialize.inl"
+
+// kak: other_file=binary_serialize.inl
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+
+#include "binary_serialize.hpp"
+
+namespace otto::util {
+
+  inline namespace serialization {
+
+    /////////////////// SERIALIZATION
+
+    template<typename Class>
+    void serialize_binary(CborWriter& w, const Class& obj)
+    {
+      if constexpr (reflect::is_registered<Class>()) {
+        w.map(reflect::get_member_count<Class>());
+        reflect::for_all_members<Class>([&w, &obj](auto& member) {
+          w.text(std::string_view(member.get_name()));
+          serialize_binary(w, member.get(obj));
+        });
+      } else if constexpr (std::is_same_v<Class, bool>) {
+        w.boolean(obj);
+      } else if constexpr (BetterEnum::is<Class>) {
+        w.text(obj._to_string());
+      } else if constexpr (std::is_enum_v<Class>) {
+        w.integer(static_cast<std::int64_t>(obj));
+      } else if constexpr (std::is_integral_v<Class> && std::is_unsigned_v<Class>) {
+        w.unsigned_integer(obj);
+      } else if constexpr (std::is_integral_v<Class>) {
+        w.integer(obj);
+      } else if constexpr (std::is_floating_point_v<Class>) {
+        w.floating(obj);
+      } else {
+        // No binary encoding. Encode the json representation.
+        w.raw(nlohmann::json::to_cbor(serialize(obj)));
+      }
+    }
+
+    inline void serialize_binary(CborWriter& w, const std::string& obj)
+    {
+      w.text(obj);
+    }
+
+    template<typename T, std::size_t N>
+    void serialize_binary(CborWriter& w, const std::array<T, N>& obj)
+    {
+      w.array(N);
+      for (auto& elem : obj) serialize_binary(w, elem);
+    }
+
+    template<typename T>
+    void serialize_binary(CborWriter& w, const std::vector<T>& obj)
+    {
+      w.array(obj.size());
+      for (auto& elem : obj) serialize_binary(w, elem);
+    }
+
+    template<typename K, typename V>
+    void serialize_binary(CborWriter& w, const std::unordered_map<K, V>& obj)
+    {
+      w.map(obj.size());
+      for (auto& pair : obj) {
+        w.text(to_string(pair.first));
+        serialize_binary(w, pair.second);
+      }
+    }
+
+    template<typename... Types>
+    void serialize_binary(CborWriter& w, const std::tuple<Types...>& obj)
+    {
+      w.array(sizeof...(Types));
+      util::for_each(obj, [&](auto& v) { serialize_binary(w, v); });
+    }
+
+    template<typename T1, typename T2>
+    void serialize_binary(CborWriter& w, const std::pair<T1, T2>& obj)
+    {
+      w.array(2);
+      serialize_binary(w, obj.first);
+      serialize_binary(w, obj.second);
+    }
+
+    template<typename Class>
+    void to_binary(std::vector<std::uint8_t>& out, const Class& obj, std::uint32_t version)
+    {
+      out.clear();
+      CborWriter w{out};
+      w.array(2);
+      w.unsigned_integer(version);
+      serialize_binary(w, obj);
+    }
+
+    template<typename Class>
+    std::vector<std::uint8_t> to_binary(const Class& obj, std::uint32_t version)
+    {
+      std::vector<std::uint8_t> res;
+      to_binary(res, obj, version);
+      return res;
+    }
+
+    /////////////////// DESERIALIZATION
+
+    template<typename Class>
+    void deserialize_binary(CborReader& r, Class& obj)
+    {
+      if constexpr (reflect::is_registered<Class>()) {
+        auto size = r.map();
+        for (std::size_t i = 0; i < size; i++) {
+          auto name = r.text();
+          bool found = false;
+          reflect::for_all_members<Class>([&](auto& member) {
+            if (found || name != std::string_view(member.get_name())) return;
+            found = true;
+            if (r.null()) return;
+            using MemberT = reflect::get_member_type<decltype(member)>;
+            if constexpr (std::decay_t<decltype(member)>::can_get_ref()) {
+              deserialize_binary(r, member.get_ref(obj));
+            } else if (member.has_setter()) {
+              if constexpr (std::is_default_constructible_v<MemberT> && std::is_assignable_v<MemberT&, MemberT&&>) {
+                MemberT m{};
+                deserialize_binary(r, m);
+                member.set(obj, std::move(m));
+              } else {
+                throw util::exception("Error: can't deserialize member '{}' because a reference can "
+                                      "not be accessed and the type is not default constructible",
+                                      member.get_name());
+              }
+            } else {
+              throw util::exception("Error: can't deserialize member '{}' because it's read only", member.get_name());
+            }
+          });
+          // Members which have been removed from the class
+          if (!found) r.skip();
+        }
+      } else if constexpr (std::is_same_v<Class, bool>) {
+        obj = r.boolean();
+      } else if constexpr (BetterEnum::is<Class>) {
+        obj = Class::_from_string(std::string(r.text()).c_str());
+      } else if constexpr (std::is_enum_v<Class>) {
+        obj = static_cast<Class>(r.integer());
+      } else if constexpr (std::is_integral_v<Class>) {
+        obj = static_cast<Class>(r.integer());
+      } else if constexpr (std::is_floating_point_v<Class>) {
+        obj = static_cast<Class>(r.floating());
+      } else {
+        deserialize(obj, nlohmann::json::from_cbor(r.raw()));
+      }
+    }
+
+    inline void deserialize_binary(CborReader& r, std::string& obj)
+    {
+      obj = r.text();
+    }
+
+    template<typename T, std::size_t N>
+    void deserialize_binary(CborReader& r, std::array<T, N>& obj)
+    {
+      auto size = r.array();
+      for (std::size_t i = 0; i < size; i++) {
+        if (i < N) deserialize_binary(r, obj[i]);
+        else r.skip();
+      }
+    }
+
+    template<typename T>
+    void deserialize_binary(CborReader& r, std::vector<T>& obj)
+    {
+      auto size = r.array();
+      obj.clear();
+      // The size is read from the data, so it is only trusted as far as there are bytes for it
+      obj.reserve(std::min<std::size_t>(size, r.remaining()));
+      for (std::size_t i = 0; i < size; i++) {
+        deserialize_binary(r, obj.emplace_back());
+      }
+    }
+
+    template<typename K, typename V>
+    void deserialize_binary(CborReader& r, std::unordered_map<K, V>& obj)
+    {
+      auto size = r.map();
+      for (std::size_t i = 0; i < size; i++) {
+        auto key = from_string<K>(std::string(r.text()));
+        deserialize_binary(r, obj[key]);
+      }
+    }
+
+    template<typename... Types>
+    void deserialize_binary(CborReader& r, std::tuple<Types...>& obj)
+    {
+      if (r.array() != sizeof...(Types)) {
+        throw util::exception("Error: wrong number of elements for a tuple of size {}", sizeof...(Types));
+      }
+      util::for_each(obj, [&](auto& v) { deserialize_binary(r, v); });
+    }
+
+    template<typename T1, typename T2>
+    void deserialize_binary(CborReader& r, std::pair<T1, T2>& obj)
+    {
+      if (r.array() != 2) {
+        throw util::exception("Error: wrong number of elements for a pair");
+      }
+      deserialize_binary(r, obj.first);
+      deserialize_binary(r, obj.second);
+    }
+
+    template<typename Class>
+    std::uint32_t from_binary(Class& obj, gsl::span<const std::uint8_t> data)
+    {
+      CborReader r{data};
+      if (r.array() != 2) {
+        throw util::exception("Error: binary data is not a [version, value] pair");
+      }
+      auto version = static_cast<std::uint32_t>(r.integer());
+      deserialize_binary(r, obj);
+      return version;
+    }
+
+  } // namespace serialization
+} // namespace otto::util
+
+// kak: other_file=binary_serialize.hpp
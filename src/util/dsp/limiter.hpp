@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "util/dsp/oversampler.hpp"
+
+namespace otto::util::dsp {
+
+  /// Look-ahead brickwall limiter for a stereo signal.
+  ///
+  /// The channels are detected together (linked), so the stereo image is kept.
+  /// The required gain is held for the length of the look-ahead, and smoothed
+  /// with a moving average of the same length. Since the audio is delayed by
+  /// `latency` samples, the gain has reached its target when the peak reaches
+  /// the output, so the output never exceeds the ceiling.
+  ///
+  /// Optionally, the detector can run on a 4x upsampled signal, to catch
+  /// inter-sample (true) peaks.
+  template<int Lookahead = 64>
+  struct LookaheadLimiter {
+    /// Latency of the true peak detector, in samples, rounded up.
+    static constexpr int true_peak_latency = 6;
+    /// Length of the gain hold. Covers the detector latency, so turning the
+    /// true peak detection on and off does not change the latency.
+    static constexpr int hold_length = Lookahead + true_peak_latency;
+    /// Delay of the audio through the limiter, in samples
+    static constexpr int latency = hold_length - 1;
+
+    LookaheadLimiter() noexcept
+    {
+      box_.fill(1.f);
+      for (auto& s : delay_) s = {0.f, 0.f};
+    }
+
+    /// Set the ceiling, as a linear amplitude
+    void ceiling(float c) noexcept
+    {
+      ceiling_ = c;
+    }
+
+    /// Set the release time
+    void release(float seconds, float samplerate) noexcept
+    {
+      release_coeff_ = 1.f - std::exp(-1.f / (seconds * samplerate));
+    }
+
+    /// Enable or disable the 4x true peak detector
+    void true_peak(bool tp) noexcept
+    {
+      if (tp == true_peak_) return;
+      true_peak_ = tp;
+      for (auto& u : tp_up1_) u.clear();
+      for (auto& u : tp_up2_) u.clear();
+    }
+
+    /// The current gain, as a linear amplitude
+    float gain() const noexcept
+    {
+      return gain_;
+    }
+
+    std::array<float, 2> operator()(float l, float r) noexcept
+    {
+      float peak = std::max(detect(0, l), detect(1, r));
+      float required = peak > ceiling_ ? ceiling_ / peak : 1.f;
+
+      // Moving average of the held gain
+      float held = hold(required);
+      box_sum_ += held - box_[box_pos_];
+      box_[box_pos_] = held;
+      box_pos_ = (box_pos_ + 1) % Lookahead;
+      float target = std::min(float(box_sum_ / Lookahead), 1.f);
+
+      // Attack is instantaneous (it has already been smoothed), release is exponential
+      if (target < gain_) {
+        gain_ = target;
+      } else {
+        gain_ += (target - gain_) * release_coeff_;
+      }
+
+      auto out = delay_[delay_pos_];
+      delay_[delay_pos_] = {l, r};
+      delay_pos_ = (delay_pos_ + 1) % latency;
+      return {out[0] * gain_, out[1] * gain_};
+    }
+
+  private:
+    float detect(int channel, float x) noexcept
+    {
+      float peak = std::abs(x);
+      if (!true_peak_) return peak;
+      for (float a : tp_up1_[channel](x)) {
+        for (float b : tp_up2_[channel](a)) {
+          peak = std::max(peak, std::abs(b));
+        }
+      }
+      return peak;
+    }
+
+    /// Minimum of the last `hold_length` values, using a monotonic queue
+    float hold(float g) noexcept
+    {
+      if (hold_size_ > 0 && time_ - hold_[hold_front_].time >= hold_length) {
+        hold_front_ = (hold_front_ + 1) % hold_length;
+        hold_size_--;
+      }
+      while (hold_size_ > 0 && hold_[back_idx()].value >= g) hold_size_--;
+      hold_[(hold_front_ + hold_size_) % hold_length] = {time_, g};
+      hold_size_++;
+      time_++;
+      return hold_[hold_front_].value;
+    }
+
+    int back_idx() const noexcept
+    {
+      return (hold_front_ + hold_size_ - 1) % hold_length;
+    }
+
+    struct HoldEntry {
+      unsigned time = 0;
+      float value = 1.f;
+    };
+
+    float ceiling_ = 1.f;
+    float release_coeff_ = 0.001f;
+    float gain_ = 1.f;
+    bool true_peak_ = false;
+
+    std::array<HalfbandUpsampler<4>, 2> tp_up1_;
+    std::array<HalfbandUpsampler<2>, 2> tp_up2_;
+
+    std::array<HoldEntry, hold_length> hold_;
+    int hold_front_ = 0;
+    int hold_size_ = 0;
+    unsigned time_ = 0;
+
+    std::array<float, Lookahead> box_;
+    double box_sum_ = Lookahead;
+    int box_pos_ = 0;
+
+    std::array<std::array<float, 2>, latency> delay_;
+    int delay_pos_ = 0;
+  };
+
+} // namespace otto::util::dsp
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace otto::util::dsp {
+
+  /// The K-weighting pre-filter from ITU-R BS.1770, for any samplerate.
+  ///
+  /// A high shelf (the head), followed by a high pass (RLB weighting).
+  struct KWeighting {
+    KWeighting(float samplerate = 48000) noexcept
+    {
+      set_samplerate(samplerate);
+    }
+
+    void set_samplerate(float samplerate) noexcept
+    {
+      {
+        double f0 = 1681.974450955533;
+        double G = 3.999843853973347;
+        double Q = 0.7071752369554196;
+        double K = std::tan(M_PI * f0 / samplerate);
+        double Vh = std::pow(10.0, G / 20.0);
+        double Vb = std::pow(Vh, 0.4996667741545416);
+        double a0 = 1.0 + K / Q + K * K;
+        shelf_.b = {float((Vh + Vb * K / Q + K * K) / a0), float(2.0 * (K * K - Vh) / a0),
+                    float((Vh - Vb * K / Q + K * K) / a0)};
+        shelf_.a = {float(2.0 * (K * K - 1.0) / a0), float((1.0 - K / Q + K * K) / a0)};
+      }
+      {
+        double f0 = 38.13547087602444;
+        double Q = 0.5003270373238773;
+        double K = std::tan(M_PI * f0 / samplerate);
+        double a0 = 1.0 + K / Q + K * K;
+        highpass_.b = {1.f, -2.f, 1.f};
+        highpass_.a = {float(2.0 * (K * K - 1.0) / a0), float((1.0 - K / Q + K * K) / a0)};
+      }
+    }
+
+    float operator()(float in) noexcept
+    {
+      return highpass_(shelf_(in));
+    }
+
+  private:
+    /// Transposed direct form II biquad
+    struct Biquad {
+      float operator()(float in) noexcept
+      {
+        float out = b[0] * in + z1;
+        z1 = b[1] * in - a[0] * out + z2;
+        z2 = b[2] * in - a[1] * out;
+        // Flush denormals, which otherwise build up in silence
+        if (std::abs(z1) < 1e-20f) z1 = 0;
+        if (std::abs(z2) < 1e-20f) z2 = 0;
+        return out;
+      }
+
+      std::array<float, 3> b = {1, 0, 0};
+      std::array<float, 2> a = {0, 0};
+      float z1 = 0;
+      float z2 = 0;
+    };
+
+    Biquad shelf_;
+    Biquad highpass_;
+  };
+
+  /// Stereo short-term loudness (LUFS over a 3 second window), as specified in EBU R 128.
+  ///
+  /// The mean square of the K-weighted signal is accumulated in 100 ms blocks,
+  /// and the loudness is computed from the last 30 blocks.
+  struct ShortTermLoudness {
+    static constexpr int number_of_blocks = 30;
+
+    ShortTermLoudness(float samplerate = 48000) noexcept
+    {
+      set_samplerate(samplerate);
+    }
+
+    void set_samplerate(float samplerate) noexcept
+    {
+      for (auto& k : weighting_) k.set_samplerate(samplerate);
+      block_length_ = int(samplerate / 10);
+      blocks_.fill(0);
+      window_sum_ = 0;
+      block_sum_ = 0;
+      block_count_ = 0;
+    }
+
+    void operator()(float l, float r) noexcept
+    {
+      float kl = weighting_[0](l);
+      float kr = weighting_[1](r);
+      block_sum_ += kl * kl + kr * kr;
+      if (++block_count_ == block_length_) {
+        double block = block_sum_ / block_length_;
+        window_sum_ += block - blocks_[block_idx_];
+        blocks_[block_idx_] = block;
+        block_idx_ = (block_idx_ + 1) % number_of_blocks;
+        block_sum_ = 0;
+        block_count_ = 0;
+      }
+    }
+
+    /// The short-term loudness in LUFS. -inf in silence.
+    float lufs() const noexcept
+    {
+      double mean_square = std::max(window_sum_, 0.0) / number_of_blocks;
+      return float(-0.691 + 10.0 * std::log10(mean_square));
+    }
+
+  private:
+    std::array<KWeighting, 2> weighting_;
+    std::array<double, number_of_blocks> blocks_ = {0};
+    int block_idx_ = 0;
+    double window_sum_ = 0;
+    double block_sum_ = 0;
+    int block_count_ = 0;
+    int block_length_ = 4800;
+  };
+
+} // namespace otto::util::dsp
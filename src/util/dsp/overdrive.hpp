@@ -2,9 +2,10 @@
 
 #include <math.h>
 #include "util/math.hpp"
+#include "util/dsp/oversampler.hpp"
 
 /// Overdrive written for the Goss Hammond emulation. It consists of a pre-filter, a waveshaper, and a post-filter.
-/// TODO: The signal is upsampled before the waveshaper and downsampled after it
+/// The signal is upsampled before the waveshaper and downsampled after it
 
 namespace otto::util::dsp {
 
@@ -12,7 +13,8 @@ namespace otto::util::dsp {
 
     float operator()(float in) noexcept 
     {
-      return postfilter(waveshaper(prefilter(in)));
+      float pre = prefilter(in);
+      return postfilter(oversampler_(pre, [this](float x) { return waveshaper(x); }));
     };
 
 
@@ -61,6 +63,8 @@ namespace otto::util::dsp {
     float adwGfZ_ = 0.0f;
     float adwZ_ = 0.0f;
 
+    Oversampler<2> oversampler_;
+
     ///Params
     // filter coeff for sag
     float sagFb = 0.991f;
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+
+#include <gsl/span>
+
+/// Polyphase half-band oversampling, used to run nonlinear stages (waveshapers, saturators)
+/// at 2x or 4x the samplerate without the aliasing they would produce at the base rate.
+///
+/// The half-band FIR has every other tap equal to zero, except for the center tap, which is 0.5.
+/// Split into its two polyphase branches, one branch is a plain delay, and the other is a
+/// short, symmetric FIR. Only that branch is computed, over a contiguous history buffer,
+/// which keeps the inner loop a fixed-size dot product the compiler can vectorize.
+
+namespace otto::util::dsp {
+
+  /// The non-zero, even-indexed taps of a windowed-sinc half-band lowpass.
+  ///
+  /// The full filter has `4 * K - 1` taps. The returned array holds the `2 * K` taps that
+  /// are not trivially zero or the center tap, normalized so they sum to 0.5.
+  template<int K>
+  std::array<float, 2 * K> halfband_coefficients() noexcept
+  {
+    constexpr int length = 4 * K - 1;
+    constexpr int center = 2 * K - 1;
+    std::array<float, 2 * K> res;
+    double sum = 0;
+    for (int k = 0; k < 2 * K; k++) {
+      int i = 2 * k;
+      double x = (i - center) / 2.0;
+      double sinc = std::sin(M_PI * x) / (M_PI * x);
+      double window =
+        0.42 - 0.5 * std::cos(2 * M_PI * i / (length - 1)) + 0.08 * std::cos(4 * M_PI * i / (length - 1));
+      res[k] = 0.5 * sinc * window;
+      sum += res[k];
+    }
+    for (auto& c : res) c *= 0.5 / sum;
+    return res;
+  }
+
+  /// Contiguous history of the last N samples of a signal.
+  ///
+  /// Every sample is written twice, N samples apart, so the last N samples
+  /// are always available as one contiguous range, without wrapping.
+  template<int N>
+  struct HalfbandHistory {
+    void push(float f) noexcept
+    {
+      pos_ = (pos_ == 0 ? N : pos_) - 1;
+      data_[pos_] = f;
+      data_[pos_ + N] = f;
+    }
+
+    /// The sample pushed `n` samples ago. `0 <= n < N`
+    float operator[](int n) const noexcept
+    {
+      return data_[pos_ + n];
+    }
+
+    /// Dot product of the history (newest first) with `coeffs`
+    float dot(const std::array<float, N>& coeffs) const noexcept
+    {
+      const float* d = data_.data() + pos_;
+      float res = 0;
+      for (int i = 0; i < N; i++) res += d[i] * coeffs[i];
+      return res;
+    }
+
+    void clear() noexcept
+    {
+      data_.fill(0);
+    }
+
+  private:
+    std::array<float, 2 * N> data_ = {0};
+    int pos_ = 0;
+  };
+
+  /// Upsamples by 2, producing two output samples per input sample.
+  ///
+  /// `K` sets the filter length (`4 * K - 1` taps). The latency is `K - 1` input samples.
+  template<int K = 8>
+  struct HalfbandUpsampler {
+    HalfbandUpsampler() noexcept : coeffs_(halfband_coefficients<K>())
+    {
+      for (auto& c : coeffs_) c *= 2.f;
+    }
+
+    std::array<float, 2> operator()(float in) noexcept
+    {
+      history_.push(in);
+      return {history_.dot(coeffs_), history_[K - 1]};
+    }
+
+    void clear() noexcept
+    {
+      history_.clear();
+    }
+
+  private:
+    std::array<float, 2 * K> coeffs_;
+    HalfbandHistory<2 * K> history_;
+  };
+
+  /// Filters and decimates by 2, consuming two input samples per output sample.
+  ///
+  /// `K` sets the filter length (`4 * K - 1` taps). The latency is `K` output samples.
+  template<int K = 8>
+  struct HalfbandDownsampler {
+    HalfbandDownsampler() noexcept : coeffs_(halfband_coefficients<K>()) {}
+
+    float operator()(std::array<float, 2> in) noexcept
+    {
+      even_.push(in[0]);
+      float res = even_.dot(coeffs_) + 0.5f * odd_[K - 1];
+      odd_.push(in[1]);
+      return res;
+    }
+
+    void clear() noexcept
+    {
+      even_.clear();
+      odd_.clear();
+    }
+
+  private:
+    std::array<float, 2 * K> coeffs_;
+    HalfbandHistory<2 * K> even_;
+    HalfbandHistory<K> odd_;
+  };
+
+  /// Runs a function at `Factor` times the samplerate.
+  ///
+  /// `Factor` is 2 or 4. 4x is done as two cascaded 2x stages, where the outer stage,
+  /// running at 2x, gets the steeper filter, and the inner stage can do with a shorter one,
+  /// since the band above the original nyquist is already filtered away by then.
+  ///
+  /// ```cpp
+  /// Oversampler<4> os;
+  /// float out = os(in, [] (float x) { return util::math::fasttanh3(x); });
+  /// ```
+  template<int Factor, int K = 8>
+  struct Oversampler {
+    static_assert(Factor == 2 || Factor == 4, "Only 2x and 4x oversampling is supported");
+
+    static constexpr int factor = Factor;
+
+    /// Process one sample, calling `f` `Factor` times at the oversampled rate
+    template<typename F>
+    float operator()(float in, F&& f) noexcept
+    {
+      auto up = up1_(in);
+      if constexpr (Factor == 2) {
+        return down1_({f(up[0]), f(up[1])});
+      } else {
+        auto a = up2_(up[0]);
+        auto b = up2_(up[1]);
+        return down1_({
+          down2_({f(a[0]), f(a[1])}),
+          down2_({f(b[0]), f(b[1])}),
+        });
+      }
+    }
+
+    /// Process a block of samples in place
+    template<typename F>
+    void process(gsl::span<float> data, F&& f) noexcept
+    {
+      for (float& s : data) s = (*this)(s, f);
+    }
+
+    /// Reset the filter states
+    void clear() noexcept
+    {
+      up1_.clear();
+      up2_.clear();
+      down1_.clear();
+      down2_.clear();
+    }
+
+  private:
+    static constexpr int inner_k = K / 2 > 2 ? K / 2 : 2;
+
+    HalfbandUpsampler<K> up1_;
+    HalfbandDownsampler<K> down1_;
+    HalfbandUpsampler<inner_k> up2_;
+    HalfbandDownsampler<inner_k> down2_;
+  };
+
+} // namespace otto::util::dsp
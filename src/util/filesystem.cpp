@@ -1,6 +1,7 @@
 #include "filesystem.hpp"
 
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 
@@ -170,10 +171,11 @@ namespace otto::filesystem {
       }
 #if __APPLE__
       return file_time_type() + std::chrono::duration_cast<file_time_type::duration>(
+                                  std::chrono::seconds(st.st_mtimespec.tv_sec) +
                                   std::chrono::nanoseconds(st.st_mtimespec.tv_nsec));
 #else
       return file_time_type() + std::chrono::duration_cast<file_time_type::duration>(
-                                  std::chrono::nanoseconds(st.st_mtim.tv_nsec));
+                                  std::chrono::seconds(st.st_mtim.tv_sec) + std::chrono::nanoseconds(st.st_mtim.tv_nsec));
 #endif
     }
 
@@ -1813,15 +1815,18 @@ namespace otto::filesystem {
   uintmax_t remove_all(const path& p, std::error_code& ec) noexcept
   {
     uintmax_t n = 0;
-    if (is_directory(p, ec)) {
-      if (ec) return -1;
-      for (auto&& de : recursive_directory_iterator(p)) {
-        remove(de, ec);
+    // Symlinks to directories are removed, not followed
+    auto st = symlink_status(p, ec);
+    if (ec) return -1;
+    if (is_directory(st)) {
+      // The contents go first, a directory can only be removed once it is empty
+      for (auto&& de : directory_iterator(p, ec)) {
+        n += remove_all(de.path(), ec);
         if (ec) return -1;
-        n++;
       }
-      n += static_cast<uintmax_t>(remove(p, ec));
+      if (ec) return -1;
     }
+    n += static_cast<uintmax_t>(remove(p, ec));
     if (ec) return -1;
     return n;
   }
@@ -1863,6 +1868,32 @@ namespace otto::filesystem {
     }
   }
 
+  path temp_directory_path()
+  {
+    std::error_code ec;
+    auto tmp = temp_directory_path(ec);
+    if (ec != std::error_code()) {
+      throw filesystem_error("In filesystem::temp_directory_path", ec);
+    }
+    return tmp;
+  }
+
+  path temp_directory_path(std::error_code& ec)
+  {
+    path p = "/tmp";
+    for (const char* var : {"TMPDIR", "TMP", "TEMP", "TEMPDIR"}) {
+      if (const char* dir = ::getenv(var)) {
+        p = dir;
+        break;
+      }
+    }
+    if (!is_directory(p, ec)) {
+      if (!ec) ec = {ENOTDIR, std::system_category()};
+      return {};
+    }
+    return p;
+  }
+
   /*
     space_info space(const path& p);
     space_info space(const path& p, std::error_code& ec) noexcept;
@@ -1875,9 +1906,6 @@ namespace otto::filesystem {
     file_status symlink_status(const path& p);
     file_status symlink_status(const path& p, std::error_code& ec) noexcept;
 
-    path temp_directory_path();
-    path temp_directory_path(std::error_code& ec);
-
     path weakly_canonical(const path& p);
     path weakly_canonical(const path& p, std::error_code& ec);
   */
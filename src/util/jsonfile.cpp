@@ -1,13 +1,60 @@
 #include "jsonfile.hpp"
 
+#include <algorithm>
+#include <cerrno>
 #include <fstream>
 #include <iomanip>
 #include <json.hpp>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace otto::util {
 
   using json = nlohmann::json;
 
+  namespace {
+    void sync_fd(int fd)
+    {
+      if (::fsync(fd) != 0) {
+        auto err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::system_category());
+      }
+    }
+
+    /// Write `contents` to a temporary file next to `path`, sync it, and rename it over `path`
+    void write_atomic(const fs::path& path, const std::string& contents)
+    {
+      fs::path tmp = path.string() + ".tmp";
+      int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      if (fd < 0) throw std::system_error(errno, std::system_category());
+      // Write in chunks of at most 64 KiB, so one call never queues a huge amount of I/O
+      constexpr std::size_t chunk_size = 64 * 1024;
+      std::size_t written = 0;
+      while (written < contents.size()) {
+        auto n = ::write(fd, contents.data() + written, std::min(chunk_size, contents.size() - written));
+        if (n < 0) {
+          if (errno == EINTR) continue;
+          auto err = errno;
+          ::close(fd);
+          throw std::system_error(err, std::system_category());
+        }
+        written += n;
+      }
+      sync_fd(fd);
+      ::close(fd);
+      fs::rename(tmp, path);
+      // Sync the directory too, otherwise the rename itself may be lost
+      fs::path dir = path.parent_path();
+      int dir_fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (dir_fd < 0) throw std::system_error(errno, std::system_category());
+      sync_fd(dir_fd);
+      ::close(dir_fd);
+    }
+  } // namespace
+
   JsonFile::JsonFile(const fs::path& p)
     : _path (p)
   {}
@@ -22,6 +69,12 @@ namespace otto::util {
       dir_p.remove_filename();
       fs::create_directories(dir_p);
     }
+    if ((options & OpenOptions::atomic) != OpenOptions::none) {
+      std::ostringstream stream;
+      stream << std::setw(2) << _data << std::endl;
+      write_atomic(_path, stream.str());
+      return;
+    }
     errno = 0;
     std::ofstream stream(_path, std::ios::trunc);
     stream << std::setw(2) << _data << std::endl;
@@ -22,8 +22,9 @@ namespace otto::util {
     using exception = util::as_exception<ErrorCode>;
 
     enum struct OpenOptions {
-      none   = 0b0, /// default options
-      create = 0b1  /// create file if it doesnt exist
+      none   = 0b0,  /// default options
+      create = 0b1,  /// create file if it doesnt exist
+      atomic = 0b10, /// write to a temporary file, sync it to disk, and rename it over the file
     };
 
     /// Constructor
@@ -38,7 +39,8 @@ namespace otto::util {
     /// Write the data to file
     ///
     /// \effects serialize `data()`, and write it to `path()`. No filestreams
-    /// are left open.
+    /// are left open. With `OpenOptions::atomic`, a crash or power loss
+    /// leaves either the old or the new file, never a partial one.
     /// 
     /// \throws `exception` on parse failure, `fs::filesystem_error` or
     /// `std::system_error` on IO failure
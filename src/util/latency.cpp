@@ -0,0 +1,73 @@
+#include "latency.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <fmt/format.h>
+
+namespace otto::util {
+
+  void LatencyHistogram::record(latency_clock::duration latency) noexcept
+  {
+    long us = std::max(0L, long(std::chrono::duration_cast<duration>(latency).count()));
+    int bucket = std::min<long>(us / bucket_width.count(), bucket_count - 1);
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(us, std::memory_order_relaxed);
+    long max = max_us_.load(std::memory_order_relaxed);
+    while (us > max && !max_us_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+    }
+    // Last, so a reader which sees the count also sees the bucket
+    count_.fetch_add(1, std::memory_order_release);
+  }
+
+  long LatencyHistogram::count() const noexcept
+  {
+    return count_.load(std::memory_order_acquire);
+  }
+
+  auto LatencyHistogram::percentile(float p) const noexcept -> duration
+  {
+    long total = count();
+    if (total == 0) return duration(0);
+    long target = std::clamp<long>(std::ceil(p * total), 1, total);
+    long seen = 0;
+    for (int i = 0; i < bucket_count; i++) {
+      seen += buckets_[i].load(std::memory_order_relaxed);
+      if (seen < target) continue;
+      // The last bucket has no upper edge
+      if (i == bucket_count - 1) return max();
+      return std::min(bucket_width * (i + 1), max());
+    }
+    return max();
+  }
+
+  auto LatencyHistogram::max() const noexcept -> duration
+  {
+    return duration(max_us_.load(std::memory_order_relaxed));
+  }
+
+  auto LatencyHistogram::mean() const noexcept -> duration
+  {
+    long total = count();
+    if (total == 0) return duration(0);
+    return duration(sum_us_.load(std::memory_order_relaxed) / total);
+  }
+
+  void LatencyHistogram::clear() noexcept
+  {
+    count_ = 0;
+    for (auto& b : buckets_) b = 0;
+    sum_us_ = 0;
+    max_us_ = 0;
+  }
+
+  std::string LatencyHistogram::summary() const
+  {
+    auto ms = [](duration d) { return d.count() / 1000.0; };
+    return fmt::format("n={} p50={:.1f}ms p90={:.1f}ms p99={:.1f}ms max={:.1f}ms", count(), ms(percentile(0.5)),
+                       ms(percentile(0.9)), ms(percentile(0.99)), ms(max()));
+  }
+
+} // namespace otto::util
+
+// kak: other_file=latency.hpp
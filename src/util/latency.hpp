@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace otto::util {
+
+  /// The monotonic clock latencies are measured with
+  using latency_clock = std::chrono::steady_clock;
+
+  /// A histogram of latencies, which can be recorded from the audio thread
+  ///
+  /// Latencies are counted in buckets of `bucket_width`. Latencies longer than the last bucket are
+  /// counted in it. Recording is wait-free, and the histogram can be read from any thread meanwhile.
+  struct LatencyHistogram {
+    using duration = std::chrono::microseconds;
+    static constexpr duration bucket_width = duration(250);
+    static constexpr int bucket_count = 256;
+
+    /// Count a latency. Negative latencies are counted as 0.
+    void record(latency_clock::duration latency) noexcept;
+
+    /// The number of latencies recorded
+    long count() const noexcept;
+
+    /// An upper bound of the `p` quantile, with `p` in `[0, 1]`
+    ///
+    /// The upper edge of the bucket the quantile is in, or the longest latency if that is lower or
+    /// the quantile is in the last bucket.
+    duration percentile(float p) const noexcept;
+
+    duration max() const noexcept;
+    duration mean() const noexcept;
+
+    void clear() noexcept;
+
+    /// A one line summary, like `n=12 p50=5.2ms p90=7.0ms p99=9.3ms max=9.3ms`
+    std::string summary() const;
+
+  private:
+    std::array<std::atomic_long, bucket_count> buckets_ = {};
+    std::atomic_long count_ = 0;
+    std::atomic_long sum_us_ = 0;
+    std::atomic_long max_us_ = 0;
+  };
+
+} // namespace otto::util
+
+// kak: other_file=latency.cpp
@@ -0,0 +1,74 @@
+#include "mapped_buffer.hpp"
+
+#include <cstring>
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "services/log_manager.hpp"
+
+namespace otto::util {
+
+  static std::size_t page_size() noexcept
+  {
+    static std::size_t res = ::sysconf(_SC_PAGESIZE);
+    return res;
+  }
+
+  MappedBuffer::MappedBuffer(std::size_t size) : size_(size)
+  {
+    void* ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    // Huge page mappings must be a multiple of the huge page size (2 MiB)
+    constexpr std::size_t huge_page_size = 2 << 20;
+    std::size_t huge_size = (size_ + huge_page_size - 1) / huge_page_size * huge_page_size;
+    ptr = ::mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      size_ = huge_size;
+    } else {
+      DLOGI("Huge pages unavailable, using normal pages for buffer of {} bytes", size_);
+    }
+#endif
+    if (ptr == MAP_FAILED) {
+      ptr = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (ptr == MAP_FAILED) {
+      throw exception(ErrorCode::map_failed, "Couldn't map {} bytes. ERR {}: {}", size_, errno, strerror(errno));
+    }
+    data_ = static_cast<std::byte*>(ptr);
+    prefault_and_lock();
+  }
+
+  MappedBuffer::~MappedBuffer() noexcept
+  {
+    if (data_) ::munmap(data_, size_);
+  }
+
+  MappedBuffer::MappedBuffer(MappedBuffer&& rhs) noexcept : data_(rhs.data_), size_(rhs.size_)
+  {
+    rhs.data_ = nullptr;
+    rhs.size_ = 0;
+  }
+
+  MappedBuffer& MappedBuffer::operator=(MappedBuffer&& rhs) noexcept
+  {
+    std::swap(data_, rhs.data_);
+    std::swap(size_, rhs.size_);
+    return *this;
+  }
+
+  void MappedBuffer::prefault_and_lock() noexcept
+  {
+    if (::mlock(data_, size_) != 0) {
+      LOGW("Couldn't lock {} bytes of memory, page faults may occur. ERR {}: {}", size_, errno, strerror(errno));
+    }
+    // Write to every page, so they are all allocated before they are used. Reading would only
+    // map in the shared zero page.
+    volatile std::byte* ptr = data_;
+    for (std::size_t i = 0; i < size_; i += page_size()) {
+      ptr[i] = ptr[i];
+    }
+  }
+
+} // namespace otto::util
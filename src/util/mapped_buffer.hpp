@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <gsl/span>
+
+#include "util/exception.hpp"
+
+namespace otto::util {
+
+  /// A large, preallocated buffer of memory mapped with `mmap`.
+  ///
+  /// The memory is anonymous, using huge pages when available. It is prefaulted and, if
+  /// permitted, locked, so it can be accessed from the audio thread without page faults.
+  struct MappedBuffer {
+    enum struct ErrorCode { map_failed };
+    using exception = util::as_exception<ErrorCode>;
+
+    /// Map `size` bytes of anonymous memory.
+    ///
+    /// Huge pages are tried first, with a fallback to normal pages.
+    ///
+    /// \throws `exception` with `ErrorCode::map_failed`
+    MappedBuffer(std::size_t size);
+
+    ~MappedBuffer() noexcept;
+
+    MappedBuffer(MappedBuffer&&) noexcept;
+    MappedBuffer& operator=(MappedBuffer&&) noexcept;
+    MappedBuffer(const MappedBuffer&) = delete;
+    MappedBuffer& operator=(const MappedBuffer&) = delete;
+
+    std::byte* data() noexcept
+    {
+      return data_;
+    }
+
+    std::size_t size() const noexcept
+    {
+      return size_;
+    }
+
+    /// View `count` objects of type `T`, starting at byte `offset`.
+    template<typename T>
+    gsl::span<T> as_span(std::size_t offset, std::size_t count) noexcept
+    {
+      return {reinterpret_cast<T*>(data_ + offset), static_cast<std::ptrdiff_t>(count)};
+    }
+
+  private:
+    void prefault_and_lock() noexcept;
+
+    std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+  };
+
+} // namespace otto::util
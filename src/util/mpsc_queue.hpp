@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace otto::util {
+
+  /// Bounded lock-free queue with any number of producers, and one consumer.
+  ///
+  /// Each slot has a sequence number, which tells whether it is free for the producer at a given
+  /// position, or ready for the consumer. Pushing never blocks or allocates, so it can be done from
+  /// any thread. When the queue is full, the pushed value is dropped and counted.
+  ///
+  /// \tparam Capacity must be a power of two
+  template<typename T, std::size_t Capacity>
+  struct mpsc_queue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "The capacity must be a power of two");
+
+    static constexpr std::size_t capacity = Capacity;
+
+    mpsc_queue() noexcept
+    {
+      for (std::size_t i = 0; i < capacity; i++) slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    /// Thread safe.
+    ///
+    /// \returns false if the queue was full, and `value` was dropped
+    bool push(T value) noexcept
+    {
+      std::size_t pos = head_.load(std::memory_order_relaxed);
+      Slot* slot;
+      while (true) {
+        slot = &slots_[pos & (capacity - 1)];
+        auto seq = slot->seq.load(std::memory_order_acquire);
+        auto diff = std::intptr_t(seq) - std::intptr_t(pos);
+        if (diff == 0) {
+          if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        } else {
+          pos = head_.load(std::memory_order_relaxed);
+        }
+      }
+      slot->value.emplace(std::move(value));
+      slot->seq.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    /// Only called from the consumer thread.
+    ///
+    /// \returns the oldest value, or `nullopt` if the queue is empty
+    std::optional<T> pop() noexcept
+    {
+      auto& slot = slots_[tail_ & (capacity - 1)];
+      if (slot.seq.load(std::memory_order_acquire) != tail_ + 1) return std::nullopt;
+      std::optional<T> res = std::move(slot.value);
+      slot.value.reset();
+      slot.seq.store(tail_ + capacity, std::memory_order_release);
+      tail_++;
+      return res;
+    }
+
+    /// The number of values dropped because the queue was full, since the last call
+    std::size_t take_dropped() noexcept
+    {
+      return dropped_.exchange(0, std::memory_order_relaxed);
+    }
+
+  private:
+    struct Slot {
+      std::atomic<std::size_t> seq;
+      std::optional<T> value;
+    };
+
+    std::array<Slot, capacity> slots_;
+    std::atomic<std::size_t> head_ = 0;
+    /// Only accessed by the consumer
+    std::size_t tail_ = 0;
+    std::atomic<std::size_t> dropped_ = 0;
+  };
+
+} // namespace otto::util
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace otto::util {
+
+  /// Hands immutable values from a (non-realtime) writer to a realtime reader.
+  ///
+  /// The writer builds a complete value, and publishes it in one atomic exchange.
+  /// The reader never allocates, frees or waits: Values it replaces are handed back
+  /// to the writer, which destroys them the next time it publishes (or calls @ref collect).
+  ///
+  /// Until the writer has collected the last replaced value, the reader keeps using
+  /// its current one. A value published while another is pending replaces it, so
+  /// the reader always gets the latest.
+  ///
+  /// There must be at most one writer thread and one reader thread.
+  template<typename T>
+  struct publisher {
+    publisher() = default;
+    publisher(std::unique_ptr<T> initial) noexcept : current_(initial.release()) {}
+
+    publisher(const publisher&) = delete;
+    publisher& operator=(const publisher&) = delete;
+
+    ~publisher() noexcept
+    {
+      delete current_;
+      delete pending_.load();
+      delete retired_.load();
+    }
+
+    /// Publish a new value. Called from the writer thread.
+    void publish(std::unique_ptr<T> value) noexcept
+    {
+      // The value is made pending before collecting. The other way around, the reader could take the
+      // previous pending value in between, and fill `retired_` again. It would then skip the new value
+      // until the next publish.
+      delete pending_.exchange(value.release());
+      collect();
+    }
+
+    /// Destroy the value the reader has replaced, if any. Called from the writer thread.
+    void collect() noexcept
+    {
+      delete retired_.exchange(nullptr);
+    }
+
+    /// Get the latest value. Called from the reader thread.
+    ///
+    /// The returned pointer is valid until the next call to `acquire`, and may be null
+    /// if nothing has been published yet.
+    const T* acquire() noexcept
+    {
+      if (retired_.load(std::memory_order_acquire) != nullptr) return current_;
+      if (T* p = pending_.exchange(nullptr)) {
+        retired_.store(current_, std::memory_order_release);
+        current_ = p;
+      }
+      return current_;
+    }
+
+  private:
+    /// Only accessed by the reader
+    T* current_ = nullptr;
+    std::atomic<T*> pending_ {nullptr};
+    std::atomic<T*> retired_ {nullptr};
+  };
+
+} // namespace otto::util
@@ -0,0 +1,354 @@
+#include "reactor.hpp"
+
+#include <atomic>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#include "services/log_manager.hpp"
+
+namespace otto::util {
+
+  struct Reactor::Link {
+    Link(LinkId id, int fd, FrameHandler on_frame, std::uint8_t delim)
+      : id(id), fd(fd), on_frame(std::move(on_frame)), delim(delim)
+    {}
+
+    LinkId id;
+    int fd;
+    FrameHandler on_frame;
+    std::uint8_t delim;
+    bool closed = false;
+
+    /// Bytes read, which are not yet part of a complete frame
+    std::array<std::uint8_t, max_frame_size> buffer;
+    std::size_t size = 0;
+
+    std::mutex write_mutex;
+    /// Written by @ref Reactor::write, guarded by `write_mutex`
+    std::vector<std::vector<std::uint8_t>> queued;
+    /// Only accessed by the reactor thread
+    std::vector<std::vector<std::uint8_t>> sending;
+    /// The number of bytes of `sending.front()` which are already written
+    std::size_t sent_offset = 0;
+    /// Whether the poller is waiting for the link to become writable
+    bool waiting_writable = false;
+
+    std::atomic<latency_clock::time_point> last_read = latency_clock::time_point{};
+    std::atomic<latency_clock::time_point> last_write = latency_clock::time_point{};
+  };
+
+  /// Waits for the file descriptors of the reactor to become ready
+  ///
+  /// Events carry the index of the link, or -1 for the wakeup pipe.
+  struct Reactor::Poller {
+    struct Event {
+      int index;
+      bool readable;
+      bool writable;
+      bool error;
+    };
+
+#if defined(__linux__)
+    Poller()
+    {
+      fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+      if (fd_ < 0) {
+        throw exception(ErrorCode::setup_failed, "Couldn't create epoll instance. ERR {}: {}", errno, strerror(errno));
+      }
+    }
+
+    ~Poller() noexcept
+    {
+      ::close(fd_);
+    }
+
+    void add(int fd, int index, bool readable)
+    {
+      epoll_event ev = {};
+      ev.events = readable ? EPOLLIN : 0;
+      ev.data.u32 = static_cast<std::uint32_t>(index + 1);
+      if (::epoll_ctl(fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        throw exception(ErrorCode::setup_failed, "Couldn't add fd {} to epoll. ERR {}: {}", fd, errno,
+                        strerror(errno));
+      }
+    }
+
+    void modify(int fd, int index, bool readable, bool writable) noexcept
+    {
+      epoll_event ev = {};
+      ev.events = (readable ? EPOLLIN : 0) | (writable ? EPOLLOUT : 0);
+      ev.data.u32 = static_cast<std::uint32_t>(index + 1);
+      ::epoll_ctl(fd_, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    void remove(int fd) noexcept
+    {
+      ::epoll_ctl(fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    /// Wait for events, and write them to `out`
+    ///
+    /// \returns the number of events
+    int wait(gsl::span<Event> out) noexcept
+    {
+      std::array<epoll_event, 16> events;
+      int count = std::min<int>(events.size(), out.size());
+      int n = ::epoll_wait(fd_, events.data(), count, -1);
+      for (int i = 0; i < n; i++) {
+        auto& ev = events[i];
+        out[i] = {static_cast<int>(ev.data.u32) - 1, (ev.events & EPOLLIN) != 0, (ev.events & EPOLLOUT) != 0,
+                  (ev.events & (EPOLLERR | EPOLLHUP)) != 0};
+      }
+      return std::max(n, 0);
+    }
+
+  private:
+    int fd_ = -1;
+#else
+    void add(int fd, int index, bool readable)
+    {
+      fds_.push_back({fd, static_cast<short>(readable ? POLLIN : 0), 0});
+      indices_.push_back(index);
+    }
+
+    void modify(int fd, int, bool readable, bool writable) noexcept
+    {
+      for (auto& pfd : fds_) {
+        if (pfd.fd == fd) pfd.events = (readable ? POLLIN : 0) | (writable ? POLLOUT : 0);
+      }
+    }
+
+    void remove(int fd) noexcept
+    {
+      for (auto& pfd : fds_) {
+        // poll ignores negative file descriptors
+        if (pfd.fd == fd) pfd.fd = -1;
+      }
+    }
+
+    int wait(gsl::span<Event> out) noexcept
+    {
+      if (::poll(fds_.data(), fds_.size(), -1) <= 0) return 0;
+      int n = 0;
+      for (std::size_t i = 0; i < fds_.size() && n < out.size(); i++) {
+        auto revents = fds_[i].revents;
+        if (revents == 0) continue;
+        out[n++] = {indices_[i], (revents & POLLIN) != 0, (revents & POLLOUT) != 0,
+                    (revents & (POLLERR | POLLHUP | POLLNVAL)) != 0};
+      }
+      return n;
+    }
+
+  private:
+    std::vector<pollfd> fds_;
+    std::vector<int> indices_;
+#endif
+  };
+
+  static void set_nonblocking(int fd)
+  {
+    int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+      throw Reactor::exception(Reactor::ErrorCode::setup_failed, "Couldn't make fd {} non-blocking. ERR {}: {}", fd,
+                               errno, strerror(errno));
+    }
+  }
+
+  Reactor::Reactor() : poller_(std::make_unique<Poller>())
+  {
+    if (::pipe(wakeup_pipe_.data()) != 0) {
+      throw exception(ErrorCode::setup_failed, "Couldn't create wakeup pipe. ERR {}: {}", errno, strerror(errno));
+    }
+    try {
+      for (int fd : wakeup_pipe_) {
+        set_nonblocking(fd);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+      }
+      poller_->add(wakeup_pipe_[0], -1, true);
+    } catch (...) {
+      for (int fd : wakeup_pipe_) ::close(fd);
+      throw;
+    }
+  }
+
+  Reactor::~Reactor() noexcept
+  {
+    stop();
+    for (int fd : wakeup_pipe_) ::close(fd);
+  }
+
+  Reactor::LinkId Reactor::add(int fd, FrameHandler on_frame, std::uint8_t delim)
+  {
+    OTTO_ASSERT(!thread_, "Links must be added before the reactor is started");
+    set_nonblocking(fd);
+    LinkId id = links_.size();
+    bool readable = on_frame != nullptr;
+    links_.push_back(std::make_unique<Link>(id, fd, std::move(on_frame), delim));
+    poller_->add(fd, id, readable);
+    return id;
+  }
+
+  void Reactor::start(std::function<void()> init)
+  {
+    if (thread_) return;
+    stopping_ = false;
+    thread_.emplace([this, init = std::move(init)](auto should_run) {
+      if (init) init();
+      std::array<Poller::Event, 16> events;
+      while (should_run() && !stopping_) {
+        int n = poller_->wait(events);
+        for (int i = 0; i < n; i++) {
+          auto& event = events[i];
+          if (event.index < 0) {
+            drain_wakeups();
+            continue;
+          }
+          auto& link = *links_[event.index];
+          if (event.readable) handle_readable(link);
+          if (event.writable) flush_writes(link);
+          if (event.error && !link.closed) {
+            LOGE("Controller link on fd {} was closed", link.fd);
+            link.closed = true;
+            poller_->remove(link.fd);
+          }
+        }
+        for (auto& link : links_) flush_writes(*link);
+      }
+    });
+  }
+
+  void Reactor::stop() noexcept
+  {
+    if (!thread_) return;
+    stopping_ = true;
+    wake();
+    thread_.reset();
+  }
+
+  void Reactor::write(LinkId id, ConstBytesView data)
+  {
+    if (data.empty()) return;
+    auto& link = *links_.at(id);
+    {
+      std::unique_lock lock(link.write_mutex);
+      link.queued.emplace_back(data.begin(), data.end());
+    }
+    wake();
+  }
+
+  latency_clock::time_point Reactor::last_read(LinkId id) const noexcept
+  {
+    return links_[id]->last_read;
+  }
+
+  latency_clock::time_point Reactor::last_write(LinkId id) const noexcept
+  {
+    return links_[id]->last_write;
+  }
+
+  void Reactor::wake() noexcept
+  {
+    std::uint8_t byte = 0;
+    // If the pipe is full, the reactor is already going to wake up
+    [[maybe_unused]] auto res = ::write(wakeup_pipe_[1], &byte, 1);
+  }
+
+  void Reactor::drain_wakeups() noexcept
+  {
+    std::array<std::uint8_t, 64> bytes;
+    while (::read(wakeup_pipe_[0], bytes.data(), bytes.size()) > 0) {
+    }
+  }
+
+  void Reactor::handle_readable(Link& link) noexcept
+  {
+    while (true) {
+      auto res = ::read(link.fd, link.buffer.data() + link.size, link.buffer.size() - link.size);
+      if (res < 0 && errno == EINTR) continue;
+      if (res < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          LOGE("Error reading from fd {}. ERR {}: {}", link.fd, errno, strerror(errno));
+        }
+        return;
+      }
+      if (res == 0) return;
+      auto now = latency_clock::now();
+      std::size_t begin = 0;
+      // Bytes before the ones just read contain no delimiter, or they would have been handled
+      for (std::size_t i = link.size; i < link.size + res; i++) {
+        if (link.buffer[i] != link.delim) continue;
+        link.last_read = now;
+        link.on_frame({link.buffer.data() + begin, static_cast<std::ptrdiff_t>(i + 1 - begin)}, now);
+        begin = i + 1;
+      }
+      link.size += res;
+      if (begin > 0) {
+        std::memmove(link.buffer.data(), link.buffer.data() + begin, link.size - begin);
+        link.size -= begin;
+      } else if (link.size == link.buffer.size()) {
+        LOGE("Discarding {} bytes read from fd {} without a frame delimiter", link.size, link.fd);
+        link.size = 0;
+      }
+    }
+  }
+
+  void Reactor::flush_writes(Link& link) noexcept
+  {
+    {
+      std::unique_lock lock(link.write_mutex);
+      for (auto& buf : link.queued) link.sending.push_back(std::move(buf));
+      link.queued.clear();
+    }
+    if (link.closed) link.sending.clear();
+    while (!link.sending.empty()) {
+      std::array<iovec, 32> iov;
+      std::size_t count = std::min(iov.size(), link.sending.size());
+      for (std::size_t i = 0; i < count; i++) {
+        iov[i] = {link.sending[i].data(), link.sending[i].size()};
+      }
+      iov[0].iov_base = link.sending[0].data() + link.sent_offset;
+      iov[0].iov_len -= link.sent_offset;
+      auto res = ::writev(link.fd, iov.data(), count);
+      if (res < 0 && errno == EINTR) continue;
+      if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        if (!link.waiting_writable) {
+          poller_->modify(link.fd, link.id, link.on_frame != nullptr, true);
+          link.waiting_writable = true;
+        }
+        return;
+      }
+      if (res < 0) {
+        LOGE("Error writing to fd {}. ERR {}: {}", link.fd, errno, strerror(errno));
+        link.sending.clear();
+        link.sent_offset = 0;
+        break;
+      }
+      link.last_write = latency_clock::now();
+      std::size_t written = link.sent_offset + res;
+      std::size_t done = 0;
+      while (done < link.sending.size() && written >= link.sending[done].size()) {
+        written -= link.sending[done].size();
+        done++;
+      }
+      link.sending.erase(link.sending.begin(), link.sending.begin() + done);
+      link.sent_offset = written;
+    }
+    if (link.waiting_writable) {
+      poller_->modify(link.fd, link.id, link.on_frame != nullptr, false);
+      link.waiting_writable = false;
+    }
+  }
+
+} // namespace otto::util
+
+// kak: other_file=reactor.hpp
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <gsl/span>
+
+#include "util/exception.hpp"
+#include "util/latency.hpp"
+#include "util/thread.hpp"
+
+namespace otto::util {
+
+  /// Event loop for the file descriptors of the controller links
+  ///
+  /// One thread waits on all links with `epoll` (`poll` where epoll is not available), instead of
+  /// a thread per link doing blocking reads. Reads are non-blocking, into a fixed buffer per link,
+  /// and each frame is passed to the handler as a view into that buffer, without copying.
+  ///
+  /// Writes can be queued from any thread. The reactor thread writes everything queued on a link
+  /// with a single `writev`, and waits for the link to become writable if the kernel buffer is
+  /// full.
+  ///
+  /// Frames are timestamped with the time they were read, and each link records when it was last
+  /// written to, for measuring the latency through the controller. The timestamps are from the
+  /// monotonic @ref latency_clock.
+  struct Reactor {
+    enum struct ErrorCode { setup_failed };
+    using exception = util::as_exception<ErrorCode>;
+
+    using ConstBytesView = gsl::span<const std::uint8_t>;
+
+    /// Called on the reactor thread with each frame read from a link, including the delimiter.
+    ///
+    /// The view is only valid until the handler returns.
+    using FrameHandler = std::function<void(ConstBytesView frame, latency_clock::time_point received)>;
+
+    /// Index of a link in the reactor
+    using LinkId = int;
+
+    /// The longest frame that can be read. Longer frames are discarded.
+    static constexpr std::size_t max_frame_size = 1024;
+
+    /// \throws `exception` with `ErrorCode::setup_failed`
+    Reactor();
+    /// Stops the reactor thread. Queued writes which have not been written are discarded.
+    ~Reactor() noexcept;
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    /// Add a link for `fd`, and put it in non-blocking mode
+    ///
+    /// The reactor does not own `fd`, it must stay open until the reactor is destroyed.
+    /// Links can only be added before @ref start.
+    ///
+    /// \param on_frame Called with each frame read. If empty, the link is only written to.
+    /// \param delim The byte ending each frame
+    /// \throws `exception` with `ErrorCode::setup_failed`
+    LinkId add(int fd, FrameHandler on_frame = nullptr, std::uint8_t delim = '\n');
+
+    /// Start the reactor thread
+    ///
+    /// \param init Called on the reactor thread before it starts waiting, for example to set its
+    ///             thread role.
+    void start(std::function<void()> init = nullptr);
+
+    /// Stop and join the reactor thread. Called by the destructor.
+    void stop() noexcept;
+
+    /// Queue `data` to be written to `link`
+    ///
+    /// Thread safe. The data is copied, and written by the reactor thread.
+    void write(LinkId link, ConstBytesView data);
+
+    /// The time a frame was last read from `link`
+    latency_clock::time_point last_read(LinkId link) const noexcept;
+
+    /// The time data was last written to `link`
+    latency_clock::time_point last_write(LinkId link) const noexcept;
+
+  private:
+    struct Link;
+    struct Poller;
+
+    void wake() noexcept;
+    void drain_wakeups() noexcept;
+    void handle_readable(Link& link) noexcept;
+    void flush_writes(Link& link) noexcept;
+
+    std::unique_ptr<Poller> poller_;
+    /// Self-pipe used to wake the reactor thread
+    std::array<int, 2> wakeup_pipe_ = {-1, -1};
+    std::vector<std::unique_ptr<Link>> links_;
+    std::atomic_bool stopping_ = false;
+    std::optional<util::thread> thread_;
+  };
+
+} // namespace otto::util
+
+// kak: other_file=reactor.cpp
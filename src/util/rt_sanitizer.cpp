@@ -0,0 +1,288 @@
+#include "rt_sanitizer.hpp"
+
+#if OTTO_RT_SANITIZER
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace otto::util::rt_sanitizer {
+
+  namespace {
+    thread_local bool realtime = false;
+    /// Non-zero while reporting and in @ref allow, so the sanitizer does not report itself
+    thread_local int suppressed = 0;
+
+    std::atomic<int> violation_count = 0;
+
+    constexpr int max_frames = 32;
+    constexpr std::size_t table_size = 1024;
+    /// Hashes of the stacks which have been reported. Open addressing, never cleared.
+    std::array<std::atomic<std::uint64_t>, table_size> reported = {};
+
+    /// \returns true if `hash` was not in the table
+    bool insert(std::uint64_t hash) noexcept
+    {
+      if (hash == 0) hash = 1;
+      for (std::size_t i = 0; i < table_size; i++) {
+        auto& slot = reported[(hash + i) % table_size];
+        std::uint64_t expected = 0;
+        if (slot.compare_exchange_strong(expected, hash)) return true;
+        if (expected == hash) return false;
+      }
+      // The table is full, which only happens if something is very wrong. Stop printing.
+      return false;
+    }
+
+    /// Print the violation and the stack to stderr, without allocating or locking
+    void report(const char* what) noexcept
+    {
+      violation_count++;
+      suppressed++;
+      void* frames[max_frames];
+      int n = backtrace(frames, max_frames);
+      // FNV-1a of the return addresses
+      std::uint64_t hash = 14695981039346656037ull;
+      for (int i = 0; i < n; i++) {
+        hash ^= reinterpret_cast<std::uintptr_t>(frames[i]);
+        hash *= 1099511628211ull;
+      }
+      if (insert(hash)) {
+        char msg[128];
+        int len = std::snprintf(msg, sizeof(msg), "RT sanitizer: %s on a real-time thread\n", what);
+        [[maybe_unused]] auto res = write(STDERR_FILENO, msg, std::min<int>(len, sizeof(msg) - 1));
+        // Skip the frames of `report` and `check`
+        constexpr int skip = 2;
+        if (n > skip) backtrace_symbols_fd(frames + skip, n - skip, STDERR_FILENO);
+      }
+      suppressed--;
+    }
+  } // namespace
+
+  void set_realtime(bool rt) noexcept
+  {
+    realtime = rt;
+  }
+
+  bool is_realtime() noexcept
+  {
+    return realtime;
+  }
+
+  void check(const char* what) noexcept
+  {
+    if (realtime && suppressed == 0) report(what);
+  }
+
+  int violations() noexcept
+  {
+    return violation_count;
+  }
+
+  allow::allow() noexcept
+  {
+    suppressed++;
+  }
+
+  allow::~allow() noexcept
+  {
+    suppressed--;
+  }
+
+} // namespace otto::util::rt_sanitizer
+
+using namespace otto::util;
+
+#if defined(__GLIBC__)
+
+// Interpose the allocation functions of glibc, which forward to the real
+// implementations under their internal names.
+extern "C" {
+void* __libc_malloc(std::size_t);
+void* __libc_calloc(std::size_t, std::size_t);
+void* __libc_realloc(void*, std::size_t);
+void __libc_free(void*);
+
+void* malloc(std::size_t size)
+{
+  rt_sanitizer::check("malloc");
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t n, std::size_t size)
+{
+  rt_sanitizer::check("calloc");
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, std::size_t size)
+{
+  rt_sanitizer::check("realloc");
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+  if (ptr != nullptr) rt_sanitizer::check("free");
+  __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+  using lock_fn = int (*)(pthread_mutex_t*);
+  static std::atomic<lock_fn> real = nullptr;
+  rt_sanitizer::check("pthread_mutex_lock");
+  auto fn = real.load(std::memory_order_relaxed);
+  if (fn == nullptr) {
+    fn = reinterpret_cast<lock_fn>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    real = fn;
+  }
+  return fn(mutex);
+}
+}
+
+namespace {
+  void* raw_alloc(std::size_t size) noexcept
+  {
+    return __libc_malloc(size);
+  }
+
+  void raw_free(void* ptr) noexcept
+  {
+    __libc_free(ptr);
+  }
+} // namespace
+
+#else
+
+namespace {
+  void* raw_alloc(std::size_t size) noexcept
+  {
+    return std::malloc(size);
+  }
+
+  void raw_free(void* ptr) noexcept
+  {
+    std::free(ptr);
+  }
+} // namespace
+
+#endif
+
+namespace {
+  void* checked_new(std::size_t size, const char* what)
+  {
+    rt_sanitizer::check(what);
+    if (size == 0) size = 1;
+    if (void* ptr = raw_alloc(size)) return ptr;
+    throw std::bad_alloc();
+  }
+
+  void* checked_new(std::size_t size, std::align_val_t align, const char* what)
+  {
+    rt_sanitizer::check(what);
+    if (size == 0) size = 1;
+    void* ptr = nullptr;
+    auto alignment = std::max(static_cast<std::size_t>(align), sizeof(void*));
+    if (posix_memalign(&ptr, alignment, size) != 0) throw std::bad_alloc();
+    return ptr;
+  }
+
+  void checked_delete(void* ptr, const char* what) noexcept
+  {
+    if (ptr == nullptr) return;
+    rt_sanitizer::check(what);
+    raw_free(ptr);
+  }
+} // namespace
+
+void* operator new(std::size_t size)
+{
+  return checked_new(size, "operator new");
+}
+
+void* operator new[](std::size_t size)
+{
+  return checked_new(size, "operator new[]");
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  try {
+    return checked_new(size, "operator new");
+  } catch (std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  try {
+    return checked_new(size, "operator new[]");
+  } catch (std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+  return checked_new(size, align, "operator new");
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+  return checked_new(size, align, "operator new[]");
+}
+
+void operator delete(void* ptr) noexcept
+{
+  checked_delete(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  checked_delete(ptr, "operator delete[]");
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  checked_delete(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  checked_delete(ptr, "operator delete[]");
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+  checked_delete(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+  checked_delete(ptr, "operator delete[]");
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  checked_delete(ptr, "operator delete");
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  checked_delete(ptr, "operator delete[]");
+}
+
+#endif // OTTO_RT_SANITIZER
+
+// kak: other_file=rt_sanitizer.hpp
@@ -0,0 +1,66 @@
+#pragma once
+
+/// Detects calls that may block on the real-time threads.
+///
+/// Enabled with the `OTTO_RT_SANITIZER` CMake option. Threads registered with the
+/// `audio` or `worker` role in @ref services::ThreadPolicy are marked as real-time.
+/// On those threads, heap allocations (`operator new/delete`, and `malloc` & co on glibc),
+/// mutex locks and log calls are reported to stderr, with a stack trace. Each stack
+/// is only reported once, but every violation is counted.
+///
+/// When the option is disabled, all of these functions are empty.
+
+namespace otto::util::rt_sanitizer {
+
+#if OTTO_RT_SANITIZER
+
+  /// Mark or unmark the calling thread as real-time
+  void set_realtime(bool realtime) noexcept;
+
+  /// Whether the calling thread is marked as real-time
+  bool is_realtime() noexcept;
+
+  /// Report a violation, if the calling thread is real-time.
+  ///
+  /// `what` must be a string literal
+  void check(const char* what) noexcept;
+
+  /// Number of violations since the start
+  int violations() noexcept;
+
+  /// Allows violations on the calling thread while it is alive.
+  ///
+  /// For the few places where blocking on the audio thread is accepted.
+  struct allow {
+    allow() noexcept;
+    ~allow() noexcept;
+
+    allow(const allow&) = delete;
+    allow& operator=(const allow&) = delete;
+  };
+
+#else
+
+  inline void set_realtime(bool) noexcept {}
+
+  inline bool is_realtime() noexcept
+  {
+    return false;
+  }
+
+  inline void check(const char*) noexcept {}
+
+  inline int violations() noexcept
+  {
+    return 0;
+  }
+
+  struct allow {
+    allow() noexcept {}
+  };
+
+#endif
+
+} // namespace otto::util::rt_sanitizer
+
+// kak: other_file=rt_sanitizer.cpp
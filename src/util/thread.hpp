@@ -120,7 +120,7 @@ namespace otto::util {
         _should_run = false;
       }
       _trigger.notify_all();
-      std_thread.join();
+      if (std_thread.joinable()) std_thread.join();
     }
 
     bool should_run() noexcept
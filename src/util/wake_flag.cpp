@@ -0,0 +1,62 @@
+#include "wake_flag.hpp"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace otto::util {
+
+#if defined(__linux__)
+  static_assert(sizeof(std::atomic<int>) == sizeof(int), "The futex word must be a plain int");
+
+  static void futex_wait(std::atomic<int>& word, int expected) noexcept
+  {
+    // Returns immediately if the word is no longer `expected`. Spurious wakeups are handled by the caller.
+    ::syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+  }
+
+  static void futex_wake(std::atomic<int>& word) noexcept
+  {
+    ::syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+  }
+
+  void wake_flag::notify() noexcept
+  {
+    if (state_.exchange(set, std::memory_order_release) == sleeping) futex_wake(state_);
+  }
+
+  void wake_flag::wait() noexcept
+  {
+    while (true) {
+      int state = state_.load(std::memory_order_acquire);
+      if (state == set) {
+        if (state_.compare_exchange_weak(state, clear, std::memory_order_acquire)) return;
+        continue;
+      }
+      if (state == clear && !state_.compare_exchange_weak(state, sleeping, std::memory_order_relaxed)) continue;
+      futex_wait(state_, sleeping);
+    }
+  }
+#else
+  void wake_flag::notify() noexcept
+  {
+    {
+      std::unique_lock lock(mutex_);
+      state_ = set;
+    }
+    cv_.notify_one();
+  }
+
+  void wake_flag::wait() noexcept
+  {
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [this] { return state_ == set; });
+    state_ = clear;
+  }
+#endif
+
+} // namespace otto::util
+
+// kak: other_file=wake_flag.hpp
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+
+#if !defined(__linux__)
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace otto::util {
+
+  /// A flag one thread sleeps on until another thread sets it
+  ///
+  /// On Linux, this is a futex: setting the flag is a single atomic exchange, and only makes a
+  /// system call when the other thread is actually sleeping. Other platforms use a mutex and a
+  /// condition variable.
+  ///
+  /// Only one thread may wait on the flag at a time.
+  struct wake_flag {
+    wake_flag() = default;
+    wake_flag(const wake_flag&) = delete;
+    wake_flag& operator=(const wake_flag&) = delete;
+
+    /// Set the flag, and wake the waiting thread. Thread safe.
+    void notify() noexcept;
+
+    /// Sleep until the flag is set, and clear it
+    ///
+    /// Returns immediately if the flag was set since the last call.
+    void wait() noexcept;
+
+  private:
+    enum State : int { clear = 0, set = 1, sleeping = 2 };
+    std::atomic<int> state_ = clear;
+#if !defined(__linux__)
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+  };
+
+} // namespace otto::util
+
+// kak: other_file=wake_flag.cpp
@@ -59,5 +59,24 @@ namespace otto::test {
       REQUIRE(cr.count_multiple(half) == 2);
       REQUIRE(cr.count_multiple(2 * whole) == 1);
     }
+
+    SUBCASE ("first_multiple") {
+      REQUIRE(cr.first_multiple(sixteenth) == whole + sixteenth);
+      REQUIRE(cr.first_multiple(eighth) == whole + eighth);
+      REQUIRE(cr.first_multiple(whole) == 2 * whole);
+      REQUIRE(cr.first_multiple(whole, sixteenth) == whole + sixteenth);
+
+      cr = {0, whole};
+      REQUIRE(cr.first_multiple(whole) == 0);
+    }
+
+    SUBCASE ("sample_offset") {
+      cr = {0, whole};
+      REQUIRE(cr.sample_offset(0, 256) == 0);
+      REQUIRE(cr.sample_offset(half, 256) == 128);
+
+      cr = {whole, whole};
+      REQUIRE(cr.sample_offset(whole, 256) == 0);
+    }
   }
 } // namespace otto::test
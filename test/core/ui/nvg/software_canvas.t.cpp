@@ -0,0 +1,75 @@
+#include "testing.t.hpp"
+
+#include "core/ui/nvg/SoftwareCanvas.hpp"
+
+namespace otto::nvg {
+
+  TEST_CASE ("[graphics] SoftwareCanvas") {
+    SoftwareCanvas sc = {320, 240};
+    const Color black = {0, 0, 0};
+    const Color red = {255, 0, 0};
+    const Color green = {0, 255, 0};
+
+    SUBCASE ("The frame is cleared to the background color") {
+      sc.begin_frame(green);
+      auto& bitmap = sc.end_frame();
+      REQUIRE(bitmap.width() == 320);
+      REQUIRE(bitmap.height() == 240);
+      REQUIRE(bitmap.at(0, 0) == green);
+      REQUIRE(bitmap.at(319, 239) == green);
+    }
+
+    SUBCASE ("Rectangles cover the pixels with their center inside") {
+      auto& ctx = sc.begin_frame();
+      ctx.fillStyle(red);
+      ctx.fillRect(10, 20, 30, 40);
+      auto& bitmap = sc.end_frame();
+      REQUIRE(bitmap.at(10, 20) == red);
+      REQUIRE(bitmap.at(39, 59) == red);
+      REQUIRE(bitmap.at(9, 20) == black);
+      REQUIRE(bitmap.at(40, 20) == black);
+      REQUIRE(bitmap.at(10, 60) == black);
+    }
+
+    SUBCASE ("Transforms and clipping are applied") {
+      auto& ctx = sc.begin_frame();
+      ctx.translate(100, 100);
+      ctx.clip(0, 0, 50, 50);
+      ctx.beginPath();
+      ctx.circle(0, 0, 20);
+      ctx.fill(red);
+      auto& bitmap = sc.end_frame();
+      REQUIRE(bitmap.at(110, 110) == red);
+      REQUIRE(bitmap.at(90, 110) == black);
+      REQUIRE(bitmap.at(125, 125) == black);
+    }
+
+    SUBCASE ("Overlapping parts of a stroke are drawn once") {
+      auto& ctx = sc.begin_frame();
+      ctx.beginPath();
+      ctx.moveTo(10, 10);
+      ctx.lineTo(100, 10);
+      ctx.lineTo(10, 10);
+      ctx.stroke(Color(255, 0, 0, 128), 6);
+      auto& bitmap = sc.end_frame();
+      REQUIRE(bitmap.at(50, 10).r == 128);
+      REQUIRE(bitmap.at(50, 20) == black);
+    }
+
+    SUBCASE ("PNG round trip") {
+      fs::create_directories(test::dir);
+      auto& ctx = sc.begin_frame();
+      ctx.fillStyle(Color(12, 34, 56, 78));
+      ctx.fillRect(0, 0, 100, 100);
+      auto& bitmap = sc.end_frame();
+      auto path = test::dir / "software_canvas.png";
+      bitmap.write_png(path);
+      auto read = Bitmap::read_png(path);
+      REQUIRE(read.width() == 320);
+      REQUIRE(read.height() == 240);
+      REQUIRE(read.count_different_pixels(bitmap) == 0);
+      REQUIRE(read.count_different_pixels(Bitmap(320, 240)) == 100 * 100);
+    }
+  }
+
+} // namespace otto::nvg
@@ -1,3 +1,4 @@
+#include <cmath>
 #include <nanorange.hpp>
 #include <set>
 
@@ -605,4 +606,189 @@ namespace otto::core::voices {
       }
     }
   }
+
+  TEST_CASE ("VoiceManager records the key-to-sound latency") {
+    auto app = services::test::make_dummy_application();
+    auto& audio_manager = services::AudioManager::current();
+    auto& latency = audio_manager.key_to_sound_latency;
+    latency.clear();
+
+    /// Silent for the first millisecond after a note on
+    struct SVoice : voices::VoiceBase<SVoice> {
+      void on_note_on(float) noexcept
+      {
+        silent = audio_manager().samplerate() / 1000;
+      }
+
+      float operator()() noexcept
+      {
+        if (!is_triggered()) return 0.f;
+        if (silent > 0) {
+          silent--;
+          return 0.f;
+        }
+        return 1.f;
+      }
+
+      static services::AudioManager& audio_manager()
+      {
+        return services::AudioManager::current();
+      }
+
+      int silent = 0;
+    };
+    VoiceManager<SVoice, 4> vmgr;
+
+    auto note_on = [&](int key) {
+      auto evt = midi::NoteOnEvent{key};
+      evt.input_time = audio_manager.buffer_time() - std::chrono::milliseconds(10);
+      return evt;
+    };
+
+    SUBCASE ("With process") {
+      vmgr.handle_midi(note_on(60));
+      auto buf = audio_manager.buffer_pool().allocate_clear();
+      vmgr.process(audio::ProcessData<1>{buf});
+      REQUIRE(latency.count() == 1);
+      REQUIRE(latency.max().count() == doctest::Approx(11000).epsilon(0.001));
+    }
+
+    SUBCASE ("With operator()") {
+      vmgr.handle_midi(note_on(60));
+      for (int i = 0; i < 100; i++) vmgr();
+      REQUIRE(latency.count() == 1);
+      REQUIRE(latency.max().count() == doctest::Approx(11000).epsilon(0.001));
+    }
+
+    SUBCASE ("Events without an input time are not measured") {
+      vmgr.handle_midi(midi::NoteOnEvent{60});
+      for (int i = 0; i < 100; i++) vmgr();
+      REQUIRE(latency.count() == 0);
+    }
+  }
+
+  TEST_CASE ("VoiceManager polyphony and voice limiting") {
+    auto app = services::test::make_dummy_application();
+    auto& audio_manager = services::test::DummyAudioManager::current();
+    audio_manager.set_dsp_load(0);
+
+    constexpr int release_frames = 1000;
+
+    /// Sounds while triggered and for `release_frames` after, and counts the samples it is processed
+    struct SVoice : voices::VoiceBase<SVoice> {
+      void on_note_off() noexcept
+      {
+        tail = release_frames;
+      }
+
+      float operator()() noexcept
+      {
+        processed++;
+        if (is_triggered()) return 1.f;
+        if (tail > 0) {
+          tail--;
+          return 0.5f;
+        }
+        return 0.f;
+      }
+
+      int tail = 0;
+      int processed = 0;
+    };
+    VoiceManager<SVoice, 8> vmgr;
+    REQUIRE(vmgr.polyphony() == voices::default_polyphony);
+    call_receiver(vmgr, polyphony_tag::action::data(8));
+
+    auto run = [&](int frames) {
+      for (int i = 0; i < frames; i++) vmgr();
+    };
+    auto count_voices = [&](auto pred) { return nano::count_if(vmgr.voices(), pred); };
+
+    SUBCASE ("Released voices are skipped once they are silent") {
+      run(vmgr.silence_frames);
+      REQUIRE(vmgr.active_voices() == 0);
+      vmgr.handle_midi(midi::NoteOnEvent{60});
+      REQUIRE(vmgr.active_voices() == 1);
+      auto& v = vmgr.last_triggered_voice();
+      run(10);
+      REQUIRE(v.processed == vmgr.silence_frames + 10);
+      REQUIRE(count_voices([&](SVoice& v) { return v.processed == vmgr.silence_frames; }) == 7);
+
+      vmgr.handle_midi(midi::NoteOffEvent{60});
+      run(release_frames);
+      REQUIRE(v.is_active());
+      run(vmgr.silence_frames);
+      REQUIRE_FALSE(v.is_active());
+      int processed = v.processed;
+      run(10);
+      REQUIRE(v.processed == processed);
+    }
+
+    SUBCASE ("Polyphony is a runtime setting") {
+      call_receiver(vmgr, polyphony_tag::action::data(4));
+      REQUIRE(vmgr.polyphony() == 4);
+      REQUIRE(vmgr.voice_volume() == test::approx(0.25f));
+      for (int key = 60; key < 66; key++) vmgr.handle_midi(midi::NoteOnEvent{key});
+      REQUIRE(count_voices([](SVoice& v) { return v.is_triggered(); }) == 4);
+
+      call_receiver(vmgr, polyphony_tag::action::data(100));
+      REQUIRE(vmgr.polyphony() == 8);
+      call_receiver(vmgr, polyphony_tag::action::data(0));
+      REQUIRE(vmgr.polyphony() == vmgr.min_polyphony);
+    }
+
+    SUBCASE ("A high DSP load limits the voices, and a low load raises the limit again") {
+      run(vmgr.silence_frames);
+      for (int key = 60; key < 64; key++) vmgr.handle_midi(midi::NoteOnEvent{key});
+      REQUIRE(vmgr.active_voices() == 4);
+
+      audio_manager.set_dsp_load(0.9);
+      vmgr.next_buffer();
+      REQUIRE(vmgr.voice_limit() == 3);
+      // At the limit, new notes steal a voice instead of taking a silent one
+      vmgr.handle_midi(midi::NoteOnEvent{64});
+      REQUIRE(vmgr.active_voices() == 4);
+
+      // Released voices above the limit are faded out
+      vmgr.handle_midi(midi::NoteOffEvent{60});
+      vmgr.handle_midi(midi::NoteOffEvent{61});
+      vmgr.next_buffer();
+      REQUIRE(vmgr.voice_limit() == 2);
+      REQUIRE(vmgr.active_voices() == 3);
+      run(2 * audio_manager.samplerate() * vmgr.limiter_fade_time);
+      REQUIRE(count_voices([](SVoice& v) { return v.is_active(); }) == 3);
+
+      audio_manager.set_dsp_load(0.1);
+      for (int i = 0; i < 1000; i++) vmgr.next_buffer();
+      REQUIRE(vmgr.voice_limit() == 8);
+    }
+
+    SUBCASE ("A sustained high load sheds one voice at a time, waiting for each to fade out") {
+      audio_manager.set_bs_sr(64, audio_manager.samplerate());
+      const int buffer_size = audio_manager.buffer_size();
+      const int fade_frames = std::ceil(audio_manager.samplerate() * vmgr.limiter_fade_time);
+      run(vmgr.silence_frames);
+      for (int key = 60; key < 68; key++) vmgr.handle_midi(midi::NoteOnEvent{key});
+      for (int key = 60; key < 68; key++) vmgr.handle_midi(midi::NoteOffEvent{key});
+      REQUIRE(vmgr.active_voices() == 8);
+
+      audio_manager.set_dsp_load(0.9);
+      vmgr.next_buffer();
+      REQUIRE(vmgr.voice_limit() == 7);
+      // The shed voice is still fading out, so its effect on the load can not be seen yet
+      for (int i = 0; i < 10; i++) vmgr.next_buffer();
+      REQUIRE(vmgr.voice_limit() == 7);
+      REQUIRE(vmgr.active_voices() == 7);
+
+      // At most one voice is shed per fade time
+      int buffers = 0;
+      for (; buffers * buffer_size < 4 * fade_frames; buffers++) {
+        run(buffer_size);
+        vmgr.next_buffer();
+      }
+      REQUIRE(buffers > 4);
+      REQUIRE(vmgr.voice_limit() >= 3);
+      REQUIRE(vmgr.voice_limit() < 7);
+    }
+  }
 } // namespace otto::core::voices
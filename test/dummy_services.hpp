@@ -30,6 +30,8 @@ namespace otto::services::test {
     {
       LOGI("DummyStateManager::detach({})", name);
     }
+    void mark_dirty(const std::string& name) override {}
+    void snapshot() override {}
   };
 
   struct DummyPresetManager final : PresetManager {
@@ -84,6 +86,22 @@ namespace otto::services::test {
     {
       UIManager::display({screen, input});
     }
+    void process_actions()
+    {
+      UIManager::process_actions();
+    }
+    void update_frame()
+    {
+      UIManager::update_frame();
+    }
+    bool has_new_frame() const noexcept
+    {
+      return UIManager::has_new_frame();
+    }
+    void render_frame(core::ui::vg::Canvas& ctx)
+    {
+      UIManager::render_frame(ctx);
+    }
 
     static DummyUIManager& current()
     {
@@ -161,6 +179,11 @@ namespace otto::services::test {
       gam::sampleRate(sample_rate);
     }
 
+    void set_dsp_load(float load)
+    {
+      record_dsp_load(load);
+    }
+
     static DummyAudioManager& current()
     {
       return dynamic_cast<DummyAudioManager&>(*Application::current().audio_manager);
@@ -0,0 +1,96 @@
+#include "testing.t.hpp"
+
+#include "engines/misc/sequencer/timeline.hpp"
+
+namespace otto::engines::sequencer {
+
+  using namespace core::clock;
+
+  struct Played {
+    Time time;
+    int key;
+    bool note_on;
+
+    bool operator==(const Played& rhs) const noexcept
+    {
+      return time == rhs.time && key == rhs.key && note_on == rhs.note_on;
+    }
+  };
+
+  std::ostream& operator<<(std::ostream& os, const Played& p)
+  {
+    return os << "{" << p.time << ", " << p.key << ", " << (p.note_on ? "on" : "off") << "}";
+  }
+
+  TEST_CASE ("[engines] Sequencer timeline") {
+    Pattern pattern;
+    pattern.length = 4;
+    pattern.tracks[0].note = 60;
+    pattern.tracks[0].steps[0] = {true, 1, 0.5};
+    pattern.tracks[1].note = 64;
+    pattern.tracks[1].steps[1] = {true, 1, 1};
+    pattern.tracks[0].steps[2] = {true, 1, 4};
+    // Outside the pattern length
+    pattern.tracks[2].steps[8].active = true;
+
+    auto timeline = Timeline::compile(pattern);
+    constexpr Time step = notes::sixteenth;
+
+    SUBCASE ("Compiles to sorted events") {
+      REQUIRE(timeline.length == 4 * step);
+      REQUIRE(timeline.events.size() == 6);
+      REQUIRE(std::is_sorted(timeline.events.begin(), timeline.events.end(),
+                             [](auto& a, auto& b) { return a.time < b.time; }));
+    }
+
+    SUBCASE ("Note-offs come before note-ons at the same time") {
+      // The gate of the second step ends where the third step starts
+      auto first = timeline.lower_bound(2 * step);
+      REQUIRE(timeline.events[first].note_on == false);
+      REQUIRE(timeline.events[first].key == 64);
+      REQUIRE(timeline.events[first + 1].note_on == true);
+    }
+
+    SUBCASE ("Gates longer than the loop wrap around") {
+      REQUIRE(std::all_of(timeline.events.begin(), timeline.events.end(),
+                          [&](auto& e) { return e.time >= 0 && e.time < timeline.length; }));
+    }
+
+    auto play = [&](TimelineCursor& cursor, ClockRange range) {
+      std::vector<Played> res;
+      cursor.advance(timeline, range, [&](const Timeline::Event& e, Time t) { res.push_back({t, e.key, e.note_on}); });
+      return res;
+    };
+
+    SUBCASE ("Small contiguous ranges play every event exactly once") {
+      TimelineCursor cursor;
+      std::vector<Played> res;
+      for (Time t = 0; t < 2 * timeline.length; t += 5) {
+        auto played = play(cursor, {t, std::min(t + 5, 2 * timeline.length)});
+        res.insert(res.end(), played.begin(), played.end());
+      }
+      REQUIRE(res.size() == 2 * timeline.events.size());
+      REQUIRE(res[0] == Played{0, 60, true});
+      REQUIRE(res[6] == Played{timeline.length, 60, true});
+    }
+
+    SUBCASE ("A range spanning several loops") {
+      TimelineCursor cursor;
+      auto res = play(cursor, {0, 3 * timeline.length});
+      REQUIRE(res.size() == 3 * timeline.events.size());
+    }
+
+    SUBCASE ("Jumping finds the position") {
+      TimelineCursor cursor;
+      play(cursor, {0, 10});
+      auto res = play(cursor, {timeline.length + step, timeline.length + step + 1});
+      REQUIRE(res == std::vector<Played>{{timeline.length + step, 64, true}});
+    }
+
+    SUBCASE ("Empty ranges play nothing") {
+      TimelineCursor cursor;
+      REQUIRE(play(cursor, {0, 0}).empty());
+    }
+  }
+
+} // namespace otto::engines::sequencer
@@ -5,13 +5,26 @@
 
 #ifndef OTTO_BOARD_PARTS_UI_GLFW
 
+#include "core/ui/nvg/SoftwareCanvas.hpp"
+
 namespace otto::test {
 
+  /// Without GLFW, a single frame is drawn to a software canvas instead, and written to
+  /// `testdir/show_gui.png`
   void show_gui(core::ui::vg::Size size,
                 std::function<void(core::ui::vg::Canvas& ctx)> draw,
                 core::input::InputHandler*)
   {
-    FAIL("show_gui run, but isn't implemented without GLFW");
+    nvg::SoftwareCanvas sc = {int(size.w), int(size.h)};
+    core::ui::vg::initUtils(sc.canvas());
+    auto& ctx = sc.begin_frame();
+    ctx.lineWidth(6);
+    ctx.lineCap(core::ui::vg::LineCap::ROUND);
+    ctx.lineJoin(core::ui::vg::LineJoin::ROUND);
+    ctx.clip(0, 0, size.w, size.h);
+    draw(ctx);
+    fs::create_directories(dir);
+    sc.end_frame().write_png(dir / "show_gui.png");
   }
 
 } // namespace otto::test
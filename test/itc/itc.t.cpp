@@ -150,6 +150,33 @@ namespace otto::itc {
         REQUIRE(aq.try_push(ar, void_action::data()) == false);
         REQUIRE(aq.size() == 0);
       }
+
+      SUBCASE ("ActionTransaction pushes one entry per queue when destroyed") {
+        ActionQueue aq2;
+        IntAR iar;
+        VoidAR var;
+        {
+          ActionTransaction transaction;
+          aq.push(iar, int_action::data(10));
+          aq.push(var, void_action::data());
+          {
+            ActionTransaction nested;
+            aq.push(iar, int_action::data(5));
+          }
+          aq2.push(var, void_action::data());
+          REQUIRE(aq.size() == 0);
+          REQUIRE(aq2.size() == 0);
+        }
+        REQUIRE(aq.size() == 1);
+        REQUIRE(aq2.size() == 1);
+        aq.pop_call_all();
+        REQUIRE(iar.value == 15);
+        REQUIRE(var.run_count == 1);
+        aq2.pop_call_all();
+        REQUIRE(var.run_count == 2);
+        aq.push(var, void_action::data());
+        REQUIRE(aq.size() == 1);
+      }
     }
 
     SUBCASE ("ActionSender") {
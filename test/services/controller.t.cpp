@@ -0,0 +1,71 @@
+#include "testing.t.hpp"
+
+#include "services/controller.hpp"
+
+namespace otto::services::test {
+
+  using namespace core::input;
+
+  namespace {
+    std::vector<std::pair<Key, LEDColor>> take_changes(LEDFramebuffer& leds)
+    {
+      std::vector<std::pair<Key, LEDColor>> res;
+      leds.take_changes([&](LED led, LEDColor color) { res.emplace_back(led.key, color); });
+      return res;
+    }
+  } // namespace
+
+  TEST_CASE ("LEDFramebuffer") {
+    LEDFramebuffer leds = {chrono::duration::zero()};
+
+    SUBCASE ("All LEDs are sent with the first batch") {
+      REQUIRE(take_changes(leds).size() == Key::_size());
+      REQUIRE(take_changes(leds).empty());
+    }
+
+    take_changes(leds);
+
+    SUBCASE ("Only the changed LEDs are sent") {
+      leds.set(Key::sends, LEDColor::Blue);
+      leds.set(Key::plus, LEDColor::Red);
+      auto changes = take_changes(leds);
+      REQUIRE(changes.size() == 2);
+      REQUIRE(leds.get(Key::sends) == LEDColor::Blue);
+      REQUIRE(take_changes(leds).empty());
+    }
+
+    SUBCASE ("Setting an LED to the color it was sent with sends nothing") {
+      leds.set(Key::sends, LEDColor::Black);
+      REQUIRE(take_changes(leds).empty());
+      leds.set(Key::sends, LEDColor::Blue);
+      leds.set(Key::sends, LEDColor::Black);
+      REQUIRE(take_changes(leds).empty());
+    }
+
+    SUBCASE ("Only the last color of an LED is sent") {
+      leds.set(Key::sends, LEDColor::Red);
+      leds.set(Key::sends, LEDColor::Blue);
+      auto changes = take_changes(leds);
+      REQUIRE(changes.size() == 1);
+      REQUIRE(changes[0].second == LEDColor::Blue);
+    }
+
+    SUBCASE ("fill and invalidate") {
+      leds.fill(LEDColor::White);
+      REQUIRE(take_changes(leds).size() == Key::_size());
+      leds.fill(LEDColor::White);
+      REQUIRE(take_changes(leds).empty());
+      leds.invalidate();
+      REQUIRE(take_changes(leds).size() == Key::_size());
+    }
+  }
+
+  TEST_CASE ("LEDFramebuffer batches are rate limited") {
+    LEDFramebuffer leds = {chrono::hours(1)};
+    take_changes(leds);
+    leds.set(Key::sends, LEDColor::Blue);
+    REQUIRE(take_changes(leds).empty());
+    REQUIRE(leds.get(Key::sends) == LEDColor::Blue);
+  }
+
+} // namespace otto::services::test
@@ -0,0 +1,56 @@
+#include "testing.t.hpp"
+
+#include "services/preset_bank.hpp"
+#include "util/jsonfile.hpp"
+
+namespace otto::services {
+
+  TEST_CASE ("[services] Preset bank") {
+    fs::path dir = fs::temp_directory_path() / "otto-preset-bank-test";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "presets");
+    auto bank_file = dir / "presets.bank";
+
+    auto write_preset = [&](const std::string& file, const std::string& name, nlohmann::json props) {
+      util::JsonFile jf{dir / "presets" / file};
+      jf.data() = {{"engine", "Synth"}, {"name", name}, {"props", std::move(props)}};
+      jf.write(util::JsonFile::OpenOptions::create);
+    };
+    write_preset("a.json", "Bass", {{"volume", 0.5}});
+    write_preset("b.json", "Lead", {{"volume", 0.8}, {"envelope", {1, 2, 3}}});
+
+    PresetBank bank{bank_file};
+    REQUIRE(bank.entries().empty());
+    REQUIRE(bank.update(dir / "presets") == 2);
+    REQUIRE(bank.entries().size() == 2);
+    REQUIRE(bank.entries()[0].name == "Bass");
+    REQUIRE(bank.entries()[1].name == "Lead");
+    REQUIRE(bank.entries()[1].engine == "Synth");
+    REQUIRE(bank.load(bank.entries()[1]) == nlohmann::json{{"volume", 0.8}, {"envelope", {1, 2, 3}}});
+
+    SUBCASE ("The index is read back from the bank file") {
+      PresetBank bank2{bank_file};
+      REQUIRE(bank2.entries().size() == 2);
+      REQUIRE(bank2.load(bank2.entries()[0]) == nlohmann::json{{"volume", 0.5}});
+      REQUIRE(bank2.update(dir / "presets") == 0);
+    }
+
+    SUBCASE ("Only changed files are parsed") {
+      write_preset("a.json", "Bass", {{"volume", 0.25}, {"pan", 1}});
+      REQUIRE(bank.update(dir / "presets") == 1);
+      REQUIRE(bank.load(bank.entries()[0]) == nlohmann::json{{"volume", 0.25}, {"pan", 1}});
+      REQUIRE(bank.load(bank.entries()[1]) == nlohmann::json{{"volume", 0.8}, {"envelope", {1, 2, 3}}});
+    }
+
+    SUBCASE ("Removed files are removed from the bank") {
+      fs::remove(dir / "presets" / "a.json");
+      REQUIRE(bank.update(dir / "presets") == 0);
+      REQUIRE(bank.entries().size() == 1);
+      REQUIRE(bank.entries()[0].name == "Lead");
+      REQUIRE(bank.load(bank.entries()[0]) == nlohmann::json{{"volume", 0.8}, {"envelope", {1, 2, 3}}});
+    }
+
+    fs::remove_all(dir);
+  }
+
+} // namespace otto::services
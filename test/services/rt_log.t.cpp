@@ -0,0 +1,41 @@
+#include "testing.t.hpp"
+
+#include <vector>
+
+#include "services/rt_log.hpp"
+
+namespace otto::services {
+
+  TEST_CASE ("[services] Real-time logging") {
+    std::vector<std::string> messages;
+    auto sink = [&](const rt_log::Entry&, const std::string& msg) { messages.push_back(msg); };
+    // Empty the queue
+    rt_log::flush([](auto&, auto&) {});
+
+    SUBCASE ("Messages are formatted when flushed") {
+      RT_LOGI("{} buffers of {:.1f} {}", 2, 1.5f, "ms");
+      RT_LOGE_IF(false, "Not logged");
+      RT_LOGE_IF(true, "Logged");
+      REQUIRE(messages.empty());
+      REQUIRE(rt_log::flush(sink) == 2);
+      REQUIRE(messages == std::vector<std::string>{"2 buffers of 1.5 ms", "Logged"});
+    }
+
+    SUBCASE ("Messages are dropped when the queue is full") {
+      auto dropped = rt_log::dropped();
+      for (std::size_t i = 0; i < rt_log::capacity + 10; i++) {
+        RT_LOGI("{}", i);
+      }
+      REQUIRE(rt_log::dropped() == dropped + 10);
+      REQUIRE(rt_log::flush(sink) == rt_log::capacity);
+      REQUIRE(messages.front() == "0");
+      REQUIRE(messages.back() == std::to_string(rt_log::capacity - 1));
+
+      // The queue is usable again
+      RT_LOGI("again");
+      messages.clear();
+      REQUIRE(rt_log::flush(sink) == 1);
+    }
+  }
+
+} // namespace otto::services
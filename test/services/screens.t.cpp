@@ -0,0 +1,115 @@
+#include "testing.t.hpp"
+
+#include <cstdlib>
+
+#include "core/ui/nvg/SoftwareCanvas.hpp"
+#include "core/ui/vector_graphics.hpp"
+#include "dummy_services.hpp"
+
+namespace otto::services::test {
+
+  using namespace core::input;
+  namespace vg = core::ui::vg;
+
+  namespace {
+    /// Reference images for the "Screen snapshots" test, in the source tree, so the test does not
+    /// depend on the working directory. They are only written when the `OTTO_UPDATE_SNAPSHOTS`
+    /// environment variable is set.
+    const fs::path snapshot_dir = fs::path(OTTO_TEST_SOURCE_DIR) / "snapshots";
+    /// Where the images of screens which differ from their reference are written, outside the source tree
+    const fs::path failed_dir = fs::temp_directory_path() / "otto-snapshots";
+
+    /// Draws the registered screens to a @ref nvg::SoftwareCanvas, while turning the encoders
+    struct ScreenRunner {
+      ScreenRunner()
+      {
+        vg::initUtils(sc.canvas());
+      }
+
+      /// All screens with a registered screen selector
+      std::vector<ScreenEnum> screens()
+      {
+        std::vector<ScreenEnum> res;
+        for (auto screen : ScreenEnum::_values()) {
+          if (app.ui_manager->has_screen(screen)) res.push_back(screen);
+        }
+        return res;
+      }
+
+      /// Display `screen`, and draw `frames` frames of it
+      ///
+      /// Before each frame, one of the encoders is turned a step. Each encoder is turned up four
+      /// steps, and then back down again, so the props stay in a range where something is drawn.
+      ///
+      /// \returns the average time spent in `Screen::draw`
+      std::chrono::nanoseconds run(ScreenEnum screen, int frames)
+      {
+        auto& ui = DummyUIManager::current();
+        static_cast<UIManager&>(ui).display(screen);
+        auto encoders = Encoder::_values();
+        std::chrono::nanoseconds total{0};
+        for (int i = 0; i < frames; i++) {
+          auto round = i / static_cast<int>(encoders.size());
+          int steps = round % 8 < 4 ? 1 : -1;
+          ui.current_input_handler().encoder({encoders[i % encoders.size()], steps});
+          ui.process_actions();
+
+          auto& ctx = sc.begin_frame();
+          // The same state as in UIManager::draw_frame
+          ctx.lineWidth(6);
+          ctx.lineCap(vg::LineCap::ROUND);
+          ctx.lineJoin(vg::LineJoin::ROUND);
+          ctx.clip(0, 0, vg::width, vg::height);
+          total += test::measure::execution([&] { ui.current_screen().draw(ctx); });
+          sc.end_frame();
+        }
+        return total / std::max(frames, 1);
+      }
+
+      Application app = make_dummy_application_default_engines();
+      nvg::SoftwareCanvas sc = {int(vg::width), int(vg::height)};
+    };
+  } // namespace
+
+  TEST_CASE ("[graphics] Screen draw benchmark" * doctest::skip()) {
+    ScreenRunner runner;
+    std::string report = fmt::format("{:<20} {:>12}\n", "Screen", "us / frame");
+    for (auto screen : runner.screens()) {
+      auto time = runner.run(screen, 256);
+      report += fmt::format("{:<20} {:>12.1f}\n", screen._to_string(), time.count() / 1000.0);
+    }
+    MESSAGE(report);
+  }
+
+  // Skipped until the reference images in test/snapshots are generated with OTTO_UPDATE_SNAPSHOTS=1 and
+  // committed. Run it explicitly with -tc="*Screen snapshots*" -ns.
+  TEST_CASE ("[graphics] Screen snapshots" * doctest::skip()) {
+    ScreenRunner runner;
+    bool update = std::getenv("OTTO_UPDATE_SNAPSHOTS") != nullptr;
+    fs::create_directories(update ? snapshot_dir : failed_dir);
+    for (auto screen : runner.screens()) {
+      CAPTURE(screen._to_string());
+      runner.run(screen, 32);
+      auto& bitmap = runner.sc.bitmap();
+      auto path = snapshot_dir / (std::string(screen._to_string()) + ".png");
+      auto failed_path = failed_dir / (std::string(screen._to_string()) + ".png");
+      if (update) {
+        bitmap.write_png(path);
+        MESSAGE("Wrote snapshot " << path);
+        continue;
+      }
+      if (!fs::exists(path)) {
+        bitmap.write_png(failed_path);
+        FAIL_CHECK("No reference image " << path << ", see " << failed_path
+                                         << ". Run with OTTO_UPDATE_SNAPSHOTS=1 to accept it.");
+        continue;
+      }
+      // Allow for rounding differences between compilers
+      int diff = nvg::Bitmap::read_png(path).count_different_pixels(bitmap, 2);
+      if (diff != 0) bitmap.write_png(failed_path);
+      else if (fs::exists(failed_path)) fs::remove(failed_path);
+      CHECK_MESSAGE(diff == 0, "The screen differs from " << path << ", see " << failed_path);
+    }
+  }
+
+} // namespace otto::services::test
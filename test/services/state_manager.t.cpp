@@ -0,0 +1,80 @@
+#include "testing.t.hpp"
+
+#include <array>
+
+#include <unistd.h>
+
+#include "dummy_services.hpp"
+#include "util/jsonfile.hpp"
+
+namespace otto::services::test {
+
+  TEST_CASE ("[services] DefaultStateManager snapshots") {
+    // The state is kept in `data/state.json`, relative to the working directory
+    fs::path dir = fs::temp_directory_path() / "otto-state-manager-test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::array<char, 4096> old_cwd;
+    REQUIRE(::getcwd(old_cwd.data(), old_cwd.size()) != nullptr);
+    REQUIRE(::chdir(dir.c_str()) == 0);
+
+    int a_saves = 0;
+    int b_saves = 0;
+    {
+      Application app = {
+        std::make_unique<LogManager>,        StateManager::create_default,  std::make_unique<DummyPresetManager>,
+        std::make_unique<DummyAudioManager>, ClockManager::create_default, std::make_unique<DummyUIManager>,
+        std::make_unique<DummyController>,   std::make_unique<DummyEngineManager>,
+      };
+      auto& state = *app.state_manager;
+      state.attach("a", [](auto&) {}, [&] { return nlohmann::json{{"saves", ++a_saves}}; });
+      state.attach("b", [](auto&) {}, [&] { return nlohmann::json{{"saves", ++b_saves}}; });
+
+      auto read_state = [&] {
+        util::JsonFile file{app.data_dir / "state.json"};
+        file.read();
+        return file.data();
+      };
+
+      SUBCASE ("Only the savers of dirty clients are invoked") {
+        state.mark_dirty("a");
+        state.mark_dirty("a");
+        state.snapshot();
+        REQUIRE(a_saves == 1);
+        REQUIRE(b_saves == 0);
+        auto data = read_state();
+        REQUIRE(data["a"]["saves"] == 1);
+        REQUIRE(!data.contains("b"));
+
+        state.mark_dirty("b");
+        state.snapshot();
+        REQUIRE(a_saves == 1);
+        REQUIRE(b_saves == 1);
+        // The earlier state of `a` is kept
+        data = read_state();
+        REQUIRE(data["a"]["saves"] == 1);
+        REQUIRE(data["b"]["saves"] == 1);
+      }
+
+      SUBCASE ("A snapshot with no dirty clients invokes no savers") {
+        state.snapshot();
+        REQUIRE(a_saves == 0);
+        REQUIRE(b_saves == 0);
+      }
+
+      SUBCASE ("A client is clean again after a snapshot") {
+        state.mark_dirty("b");
+        state.snapshot();
+        state.snapshot();
+        REQUIRE(b_saves == 1);
+      }
+    }
+    // Saving on exit invokes all savers
+    REQUIRE(a_saves > 0);
+    REQUIRE(b_saves > 0);
+
+    REQUIRE(::chdir(old_cwd.data()) == 0);
+    fs::remove_all(dir);
+  }
+
+} // namespace otto::services::test
@@ -0,0 +1,33 @@
+#include "testing.t.hpp"
+
+#include "core/ui/nvg/SoftwareCanvas.hpp"
+#include "dummy_services.hpp"
+
+namespace otto::services::test {
+
+  TEST_CASE ("[graphics] UIManager renders the frames recorded by the logic") {
+    auto app = make_dummy_application_default_engines();
+    auto& ui = DummyUIManager::current();
+    static_cast<UIManager&>(ui).display(ScreenEnum::sends);
+
+    nvg::SoftwareCanvas direct = {320, 240};
+    nvg::SoftwareCanvas split = {320, 240};
+    ui.draw_frame(direct.begin_frame());
+    direct.end_frame();
+
+    REQUIRE(!ui.has_new_frame());
+    ui.update_frame();
+    REQUIRE(ui.has_new_frame());
+    ui.render_frame(split.begin_frame());
+    split.end_frame();
+    REQUIRE(!ui.has_new_frame());
+    REQUIRE(split.bitmap().count_different_pixels(direct.bitmap()) == 0);
+
+    SUBCASE ("Without a new frame, the previous frame is drawn again") {
+      ui.render_frame(split.begin_frame());
+      split.end_frame();
+      REQUIRE(split.bitmap().count_different_pixels(direct.bitmap()) == 0);
+    }
+  }
+
+} // namespace otto::services::test
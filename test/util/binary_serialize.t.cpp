@@ -0,0 +1,113 @@
+#include "testing.t.hpp"
+
+#include "util/binary_serialize.hpp"
+
+namespace otto::util {
+
+  namespace {
+    struct Step {
+      bool active = false;
+      float velocity = 0.5f;
+      int gate = 3;
+
+      DECL_REFLECTION(Step, active, velocity, gate);
+    };
+
+    struct Pattern {
+      std::array<Step, 4> steps;
+      std::vector<int> notes;
+      std::string name;
+      std::tuple<int, float> tuple;
+      double tempo = 120;
+
+      int length() const
+      {
+        return length_;
+      }
+      void length(int l)
+      {
+        length_ = l;
+      }
+      int length_ = 16;
+
+      DECL_REFLECTION(Pattern, steps, notes, name, tuple, tempo, ("length", &Pattern::length, &Pattern::length));
+    };
+
+    /// A later version of `Pattern`, with some members removed and one added
+    struct PatternV2 {
+      std::string name;
+      int swing = 50;
+      std::vector<int> notes;
+
+      DECL_REFLECTION(PatternV2, name, swing, notes);
+    };
+  } // namespace
+
+  TEST_CASE ("[util] Binary serialization") {
+    Pattern pattern;
+    pattern.steps[2].active = true;
+    pattern.steps[1].velocity = -1.25f;
+    pattern.steps[3].gate = -100000;
+    pattern.notes = {1, 300, 70000, -5};
+    pattern.name = "Beat";
+    pattern.tuple = {4, 2.5f};
+    pattern.tempo = 93.5;
+    pattern.length(42);
+
+    auto data = to_binary(pattern, 3);
+
+    SUBCASE ("Round trip") {
+      Pattern res;
+      REQUIRE(from_binary(res, data) == 3);
+      REQUIRE(res.steps[2].active);
+      REQUIRE(!res.steps[0].active);
+      REQUIRE(res.steps[1].velocity == -1.25f);
+      REQUIRE(res.steps[3].gate == -100000);
+      REQUIRE(res.notes == pattern.notes);
+      REQUIRE(res.name == "Beat");
+      REQUIRE(res.tuple == pattern.tuple);
+      REQUIRE(res.tempo == 93.5);
+      REQUIRE(res.length() == 42);
+    }
+
+    SUBCASE ("The output is valid CBOR") {
+      auto json = nlohmann::json::from_cbor(data);
+      REQUIRE(json[0] == 3);
+      REQUIRE(json[1]["name"] == "Beat");
+      REQUIRE(json[1]["steps"][3]["gate"] == -100000);
+      REQUIRE(json[1]["length"] == 42);
+    }
+
+    SUBCASE ("Unknown members are skipped, and missing members are left as they are") {
+      PatternV2 res;
+      from_binary(res, data);
+      REQUIRE(res.name == "Beat");
+      REQUIRE(res.swing == 50);
+      REQUIRE(res.notes == pattern.notes);
+    }
+
+    SUBCASE ("The output buffer is reused") {
+      std::vector<std::uint8_t> buf;
+      to_binary(buf, pattern);
+      auto capacity = buf.capacity();
+      to_binary(buf, pattern);
+      REQUIRE(buf.capacity() == capacity);
+      REQUIRE(buf.size() == data.size());
+    }
+
+    SUBCASE ("Truncated data throws") {
+      data.resize(data.size() - 3);
+      Pattern res;
+      REQUIRE_THROWS_AS(from_binary(res, data), util::exception);
+    }
+
+    SUBCASE ("A corrupt array length throws") {
+      // [3, {"notes": <array of 2^64 - 1 items>}]
+      std::vector<std::uint8_t> corrupt = {0x82, 0x03, 0xa1, 0x65, 'n',  'o',  't',  'e', 's',
+                                           0x9b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+      Pattern res;
+      REQUIRE_THROWS_AS(from_binary(res, corrupt), util::exception);
+    }
+  }
+
+} // namespace otto::util
@@ -0,0 +1,49 @@
+#include "testing.t.hpp"
+
+#include <random>
+
+#include "util/dsp/limiter.hpp"
+
+namespace otto::util::dsp {
+
+  using namespace test;
+
+  TEST_CASE ("LookaheadLimiter") {
+    LookaheadLimiter<64> limiter;
+    limiter.ceiling(0.9f);
+    limiter.release(0.05f, 44100);
+
+    SUBCASE ("The audio is delayed by the latency") {
+      int delay = -1;
+      for (int i = 0; i < 200; i++) {
+        auto out = limiter(i == 0 ? 0.5f : 0.f, 0.f);
+        if (out[0] != 0) delay = i;
+      }
+      REQUIRE(delay == limiter.latency);
+    }
+
+    SUBCASE ("Signals below the ceiling are unchanged") {
+      for (int i = 0; i < 1000; i++) {
+        float in = 0.5f * std::sin(i * 0.1f);
+        limiter(in, in);
+      }
+      REQUIRE(limiter.gain() == approx(1.f));
+    }
+
+    SUBCASE ("The output never exceeds the ceiling") {
+      for (bool tp : {false, true}) {
+        limiter.true_peak(tp);
+        std::mt19937 gen;
+        std::normal_distribution<float> dist(0, 1);
+        float peak = 0;
+        for (int i = 0; i < 100000; i++) {
+          float amp = (i / 10000) % 2 ? 3.f : 0.3f;
+          auto out = limiter(dist(gen) * amp, std::sin(i * 0.3f) * amp);
+          peak = std::max({peak, std::abs(out[0]), std::abs(out[1])});
+        }
+        REQUIRE(peak <= 0.9f + 1e-6f);
+      }
+    }
+  }
+
+} // namespace otto::util::dsp
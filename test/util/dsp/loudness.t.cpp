@@ -0,0 +1,27 @@
+#include "testing.t.hpp"
+
+#include "util/dsp/loudness.hpp"
+
+namespace otto::util::dsp {
+
+  using namespace test;
+
+  TEST_CASE ("ShortTermLoudness") {
+    SUBCASE ("A 1 kHz full scale sine in one channel measures -3.01 LUFS") {
+      for (float sr : {44100.f, 48000.f}) {
+        ShortTermLoudness loudness{sr};
+        for (int i = 0; i < 4 * sr; i++) {
+          loudness(std::sin(2 * M_PI * 1000 * i / sr), 0);
+        }
+        REQUIRE(loudness.lufs() == approx(-3.01f).margin(0.05));
+      }
+    }
+
+    SUBCASE ("Silence measures -inf") {
+      ShortTermLoudness loudness{48000};
+      for (int i = 0; i < 48000; i++) loudness(0, 0);
+      REQUIRE(std::isinf(loudness.lufs()));
+    }
+  }
+
+} // namespace otto::util::dsp
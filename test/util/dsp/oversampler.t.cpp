@@ -0,0 +1,58 @@
+#include "testing.t.hpp"
+
+#include "util/dsp/oversampler.hpp"
+
+namespace otto::util::dsp {
+
+  using namespace test;
+
+  template<typename OS>
+  float peak_of_sine(OS& os, float freq, float sr = 44100.f)
+  {
+    float peak = 0;
+    for (int i = 0; i < 4096; i++) {
+      float out = os(std::sin(2 * M_PI * freq * i / sr), [](float x) { return x; });
+      // Skip the filter latency
+      if (i > 256) peak = std::max(peak, std::abs(out));
+    }
+    return peak;
+  }
+
+  TEST_CASE ("Oversampler") {
+    SUBCASE ("The half-band coefficients sum to 0.5") {
+      auto coeffs = halfband_coefficients<8>();
+      float sum = 0;
+      for (float c : coeffs) sum += c;
+      REQUIRE(sum == approx(0.5));
+    }
+
+    SUBCASE ("Up- and downsampling preserves DC") {
+      HalfbandUpsampler<8> up;
+      HalfbandDownsampler<8> down;
+      float out = 0;
+      for (int i = 0; i < 100; i++) {
+        auto os = up(1.f);
+        out = down(os);
+      }
+      REQUIRE(out == approx(1.f).margin(0.001));
+    }
+
+    SUBCASE ("Called with the identity function, the passband is unchanged") {
+      Oversampler<2> os2;
+      REQUIRE(peak_of_sine(os2, 1000) == approx(1.f).margin(0.01));
+      Oversampler<4> os4;
+      REQUIRE(peak_of_sine(os4, 1000) == approx(1.f).margin(0.01));
+    }
+
+    SUBCASE ("The function is called Factor times per sample") {
+      Oversampler<4> os;
+      int calls = 0;
+      os(0.f, [&](float x) {
+        calls++;
+        return x;
+      });
+      REQUIRE(calls == 4);
+    }
+  }
+
+} // namespace otto::util::dsp
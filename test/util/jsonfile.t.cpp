@@ -0,0 +1,65 @@
+#include "testing.t.hpp"
+
+#include <fstream>
+
+#include "util/jsonfile.hpp"
+
+namespace otto::util {
+
+  TEST_CASE ("[util] JsonFile atomic write") {
+    fs::path dir = fs::temp_directory_path() / "otto-jsonfile-test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    auto path = dir / "state.json";
+
+    JsonFile old_file{path};
+    old_file.data() = {{"version", 1}};
+    old_file.write();
+
+    SUBCASE ("The new contents replace the file") {
+      // A reader which opened the old file keeps reading the old contents, as the file is
+      // replaced, not truncated and rewritten
+      std::ifstream reader(path);
+      REQUIRE(reader.is_open());
+
+      JsonFile file{path};
+      file.data() = {{"version", 2}, {"data", {1, 2, 3}}};
+      file.write(JsonFile::OpenOptions::atomic);
+
+      nlohmann::json old_contents;
+      reader >> old_contents;
+      REQUIRE(old_contents == nlohmann::json{{"version", 1}});
+
+      JsonFile read_back{path};
+      read_back.read();
+      REQUIRE(read_back.data() == nlohmann::json{{"version", 2}, {"data", {1, 2, 3}}});
+    }
+
+    SUBCASE ("No temporary file is left over") {
+      JsonFile file{path};
+      file.data() = {{"version", 2}};
+      file.write(JsonFile::OpenOptions::atomic);
+      file.write(JsonFile::OpenOptions::atomic);
+      REQUIRE(!fs::exists(path.string() + ".tmp"));
+      int files = 0;
+      for (auto& entry : fs::directory_iterator(dir)) {
+        REQUIRE(entry.path() == path);
+        files++;
+      }
+      REQUIRE(files == 1);
+    }
+
+    SUBCASE ("A new file is created in a new directory") {
+      JsonFile file{dir / "sub" / "new.json"};
+      file.data() = {{"version", 3}};
+      file.write(JsonFile::OpenOptions::create | JsonFile::OpenOptions::atomic);
+      JsonFile read_back{dir / "sub" / "new.json"};
+      read_back.read();
+      REQUIRE(read_back.data() == nlohmann::json{{"version", 3}});
+      REQUIRE(!fs::exists(dir / "sub" / "new.json.tmp"));
+    }
+
+    fs::remove_all(dir);
+  }
+
+} // namespace otto::util
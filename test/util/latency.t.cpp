@@ -0,0 +1,45 @@
+#include "testing.t.hpp"
+
+#include "util/latency.hpp"
+
+namespace otto::util {
+
+  using namespace std::chrono_literals;
+
+  TEST_CASE ("util::LatencyHistogram") {
+    LatencyHistogram hist;
+
+    SUBCASE ("Empty") {
+      REQUIRE(hist.count() == 0);
+      REQUIRE(hist.percentile(0.5) == 0us);
+      REQUIRE(hist.mean() == 0us);
+    }
+
+    SUBCASE ("Percentiles are bounded by the bucket edges") {
+      for (int i = 1; i <= 100; i++) hist.record(i * 100us);
+      REQUIRE(hist.count() == 100);
+      REQUIRE(hist.max() == 10ms);
+      REQUIRE(hist.mean() == 5050us);
+      // The 50th latency is 5ms, which is the lower edge of its bucket
+      REQUIRE(hist.percentile(0.5) == 5250us);
+      REQUIRE(hist.percentile(0.99) == 10ms);
+      REQUIRE(hist.percentile(1) == 10ms);
+    }
+
+    SUBCASE ("Negative and very long latencies are counted") {
+      hist.record(-1ms);
+      hist.record(1h);
+      REQUIRE(hist.count() == 2);
+      REQUIRE(hist.percentile(0.5) == 250us);
+      REQUIRE(hist.percentile(1) == 1h);
+    }
+
+    SUBCASE ("clear") {
+      hist.record(1ms);
+      hist.clear();
+      REQUIRE(hist.count() == 0);
+      REQUIRE(hist.max() == 0us);
+    }
+  }
+
+} // namespace otto::util
@@ -0,0 +1,67 @@
+#include "testing.t.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "util/mpsc_queue.hpp"
+#include "util/wake_flag.hpp"
+
+namespace otto::util {
+
+  TEST_CASE ("util::mpsc_queue") {
+    mpsc_queue<int, 4> queue;
+
+    SUBCASE ("Values are popped in the order they were pushed") {
+      REQUIRE(queue.push(1));
+      REQUIRE(queue.push(2));
+      REQUIRE(queue.pop() == 1);
+      REQUIRE(queue.push(3));
+      REQUIRE(queue.pop() == 2);
+      REQUIRE(queue.pop() == 3);
+      REQUIRE(queue.pop() == std::nullopt);
+    }
+
+    SUBCASE ("Values pushed to a full queue are dropped and counted") {
+      for (int i = 0; i < 4; i++) REQUIRE(queue.push(i));
+      REQUIRE_FALSE(queue.push(4));
+      REQUIRE_FALSE(queue.push(5));
+      REQUIRE(queue.take_dropped() == 2);
+      REQUIRE(queue.take_dropped() == 0);
+      REQUIRE(queue.pop() == 0);
+      REQUIRE(queue.push(6));
+    }
+  }
+
+  TEST_CASE ("util::mpsc_queue with a consumer waiting on a wake_flag") {
+    constexpr int producers = 4;
+    constexpr int per_producer = 10000;
+    mpsc_queue<std::pair<int, int>, 64> queue;
+    wake_flag wake;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+      threads.emplace_back([&, p] {
+        for (int i = 0; i < per_producer; i++) {
+          while (!queue.push({p, i})) std::this_thread::yield();
+          wake.notify();
+        }
+      });
+    }
+
+    std::vector<int> next(producers, 0);
+    int received = 0;
+    while (received < producers * per_producer) {
+      wake.wait();
+      while (auto v = queue.pop()) {
+        auto [p, i] = *v;
+        // Values from one producer arrive in order
+        REQUIRE(i == next[p]);
+        next[p]++;
+        received++;
+      }
+    }
+    for (auto& t : threads) t.join();
+    REQUIRE(queue.pop() == std::nullopt);
+  }
+
+} // namespace otto::util
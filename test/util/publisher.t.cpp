@@ -0,0 +1,79 @@
+#include "testing.t.hpp"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "util/publisher.hpp"
+
+namespace otto::util {
+
+  TEST_CASE ("util::publisher") {
+    publisher<int> pub(std::make_unique<int>(1));
+    REQUIRE(*pub.acquire() == 1);
+
+    SUBCASE ("The reader gets the latest value") {
+      pub.publish(std::make_unique<int>(2));
+      pub.publish(std::make_unique<int>(3));
+      REQUIRE(*pub.acquire() == 3);
+    }
+
+    SUBCASE ("Values are handed over in order") {
+      pub.publish(std::make_unique<int>(2));
+      REQUIRE(*pub.acquire() == 2);
+      pub.publish(std::make_unique<int>(3));
+      REQUIRE(*pub.acquire() == 3);
+      REQUIRE(*pub.acquire() == 3);
+    }
+  }
+
+  TEST_CASE ("util::publisher with the reader acquiring while a value is published") {
+    /// Runs `on_destroy` when the writer destroys it
+    struct Value {
+      int value = 0;
+      std::function<void()> on_destroy;
+
+      ~Value()
+      {
+        if (on_destroy) on_destroy();
+      }
+    };
+
+    SUBCASE ("A reader acquiring during publish gets the new value") {
+      auto initial = std::make_unique<Value>();
+      auto* initial_ptr = initial.get();
+      publisher<Value> pub(std::move(initial));
+      auto v1 = std::make_unique<Value>();
+      v1->value = 1;
+      pub.publish(std::move(v1));
+      REQUIRE(pub.acquire()->value == 1);
+
+      // The initial value is now retired, and is destroyed by the next publish
+      int seen = -1;
+      initial_ptr->on_destroy = [&] { seen = pub.acquire()->value; };
+      auto v2 = std::make_unique<Value>();
+      v2->value = 2;
+      pub.publish(std::move(v2));
+      REQUIRE(seen == 2);
+      REQUIRE(pub.acquire()->value == 2);
+    }
+
+    SUBCASE ("The last published value is always seen") {
+      // The reader used to be able to take the previous value between the writer's collect and
+      // exchange. The newest value then stayed pending until the next publish.
+      for (int round = 0; round < 2000; round++) {
+        publisher<int> pub(std::make_unique<int>(0));
+        pub.publish(std::make_unique<int>(1));
+        std::atomic_bool done = false;
+        std::thread writer([&] {
+          pub.publish(std::make_unique<int>(2));
+          done = true;
+        });
+        while (!done) pub.acquire();
+        writer.join();
+        REQUIRE(*pub.acquire() == 2);
+      }
+    }
+  }
+
+} // namespace otto::util
@@ -0,0 +1,87 @@
+#include "testing.t.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "util/reactor.hpp"
+
+namespace otto::util {
+
+  namespace {
+    /// A pipe, closed when it goes out of scope
+    struct Pipe {
+      Pipe()
+      {
+        REQUIRE(::pipe(fds) == 0);
+      }
+      ~Pipe()
+      {
+        ::close(fds[0]);
+        ::close(fds[1]);
+      }
+      int read_end() const noexcept
+      {
+        return fds[0];
+      }
+      int write_end() const noexcept
+      {
+        return fds[1];
+      }
+      int fds[2];
+    };
+  } // namespace
+
+  TEST_CASE ("util::Reactor") {
+    Pipe in;
+    Pipe out;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> frames;
+    Reactor reactor;
+    auto in_link = reactor.add(in.read_end(), [&](auto frame, auto) {
+      std::unique_lock lock(mutex);
+      frames.emplace_back(frame.begin(), frame.end());
+      cv.notify_all();
+    });
+    auto out_link = reactor.add(out.write_end());
+    reactor.start();
+
+    auto wait_for_frames = [&](std::size_t n) {
+      std::unique_lock lock(mutex);
+      return cv.wait_for(lock, std::chrono::seconds(1), [&] { return frames.size() >= n; });
+    };
+
+    SUBCASE ("Frames are split on the delimiter, also when they arrive in parts") {
+      REQUIRE(::write(in.write_end(), "ab\ncd", 5) == 5);
+      REQUIRE(wait_for_frames(1));
+      REQUIRE(::write(in.write_end(), "e\nf\n", 4) == 4);
+      REQUIRE(wait_for_frames(3));
+      REQUIRE(frames == std::vector<std::string>{"ab\n", "cde\n", "f\n"});
+      reactor.stop();
+      REQUIRE(reactor.last_read(in_link) != latency_clock::time_point{});
+    }
+
+    SUBCASE ("Queued writes are written in order, also when they fill the pipe") {
+      std::vector<std::uint8_t> small = {'x', 'y'};
+      std::vector<std::uint8_t> big(1 << 18, 'z');
+      reactor.write(out_link, small);
+      reactor.write(out_link, big);
+      std::string read;
+      std::array<char, 4096> buf;
+      while (read.size() < small.size() + big.size()) {
+        auto n = ::read(out.read_end(), buf.data(), buf.size());
+        REQUIRE(n > 0);
+        read.append(buf.data(), n);
+      }
+      REQUIRE(read.substr(0, 3) == "xyz");
+      REQUIRE(read.back() == 'z');
+      reactor.stop();
+      REQUIRE(reactor.last_write(out_link) != latency_clock::time_point{});
+    }
+  }
+
+} // namespace otto::util
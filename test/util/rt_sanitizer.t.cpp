@@ -0,0 +1,51 @@
+#include "testing.t.hpp"
+
+#include <mutex>
+#include <vector>
+
+#include "util/rt_sanitizer.hpp"
+
+namespace otto::util {
+
+  TEST_CASE ("util::rt_sanitizer") {
+    std::mutex mutex;
+
+    SUBCASE ("Non-realtime threads are not checked") {
+      auto before = rt_sanitizer::violations();
+      std::vector<int> v(10);
+      std::lock_guard lock(mutex);
+      REQUIRE(rt_sanitizer::violations() == before);
+    }
+
+#if OTTO_RT_SANITIZER
+    SUBCASE ("Allocations and locks on realtime threads are counted") {
+      auto before = rt_sanitizer::violations();
+      rt_sanitizer::set_realtime(true);
+      {
+        std::vector<int> v(10);
+      }
+      int after_alloc = rt_sanitizer::violations();
+      {
+        std::lock_guard lock(mutex);
+      }
+      int after_lock = rt_sanitizer::violations();
+      rt_sanitizer::set_realtime(false);
+      // new and delete
+      REQUIRE(after_alloc == before + 2);
+      REQUIRE(after_lock == after_alloc + 1);
+    }
+
+    SUBCASE ("allow suppresses violations") {
+      auto before = rt_sanitizer::violations();
+      rt_sanitizer::set_realtime(true);
+      {
+        rt_sanitizer::allow allow;
+        std::vector<int> v(10);
+      }
+      rt_sanitizer::set_realtime(false);
+      REQUIRE(rt_sanitizer::violations() == before);
+    }
+#endif
+  }
+
+} // namespace otto::util